@@ -229,11 +229,15 @@ SOURCES += ../dust3d/base/axis_aligned_bounding_box_tree.cc
 HEADERS += ../dust3d/base/color.h
 HEADERS += ../dust3d/base/combine_mode.h
 SOURCES += ../dust3d/base/combine_mode.cc
+HEADERS += ../dust3d/base/compiled_snapshot.h
+SOURCES += ../dust3d/base/compiled_snapshot.cc
+HEADERS += ../dust3d/base/content_hasher.h
 HEADERS += ../dust3d/base/cut_face.h
 SOURCES += ../dust3d/base/cut_face.cc
 HEADERS += ../dust3d/base/debug.h
 HEADERS += ../dust3d/base/ds3_file.h
 SOURCES += ../dust3d/base/ds3_file.cc
+HEADERS += ../dust3d/base/indexed_mesh.h
 HEADERS += ../dust3d/base/math.h
 HEADERS += ../dust3d/base/matrix4x4.h
 HEADERS += ../dust3d/base/object.h
@@ -246,8 +250,11 @@ HEADERS += ../dust3d/base/rectangle.h
 HEADERS += ../dust3d/base/snapshot.h
 HEADERS += ../dust3d/base/snapshot_xml.h
 SOURCES += ../dust3d/base/snapshot_xml.cc
+HEADERS += ../dust3d/base/spatial_hash_map.h
 HEADERS += ../dust3d/base/string.h
 SOURCES += ../dust3d/base/string.cc
+HEADERS += ../dust3d/base/task_group.h
+SOURCES += ../dust3d/base/task_group.cc
 HEADERS += ../dust3d/base/texture_type.h
 SOURCES += ../dust3d/base/texture_type.cc
 HEADERS += ../dust3d/base/vector3.h
@@ -263,12 +270,15 @@ HEADERS += ../dust3d/mesh/solid_mesh.h
 SOURCES += ../dust3d/mesh/solid_mesh.cc
 HEADERS += ../dust3d/mesh/solid_mesh_boolean_operation.h
 SOURCES += ../dust3d/mesh/solid_mesh_boolean_operation.cc
+HEADERS += ../dust3d/mesh/half_edge_map.h
 HEADERS += ../dust3d/mesh/hole_stitcher.h
 SOURCES += ../dust3d/mesh/hole_stitcher.cc
 HEADERS += ../dust3d/mesh/hole_wrapper.h
 SOURCES += ../dust3d/mesh/hole_wrapper.cc
 HEADERS += ../dust3d/mesh/mesh_combiner.h
 SOURCES += ../dust3d/mesh/mesh_combiner.cc
+HEADERS += ../dust3d/mesh/mesh_disk_cache.h
+SOURCES += ../dust3d/mesh/mesh_disk_cache.cc
 HEADERS += ../dust3d/mesh/mesh_generator.h
 SOURCES += ../dust3d/mesh/mesh_generator.cc
 HEADERS += ../dust3d/mesh/mesh_node.h
@@ -276,6 +286,8 @@ HEADERS += ../dust3d/mesh/mesh_recombiner.h
 SOURCES += ../dust3d/mesh/mesh_recombiner.cc
 HEADERS += ../dust3d/mesh/mesh_state.h
 SOURCES += ../dust3d/mesh/mesh_state.cc
+HEADERS += ../dust3d/mesh/mesh_validation.h
+SOURCES += ../dust3d/mesh/mesh_validation.cc
 HEADERS += ../dust3d/mesh/re_triangulator.h
 SOURCES += ../dust3d/mesh/re_triangulator.cc
 HEADERS += ../dust3d/mesh/resolve_triangle_tangent.h
@@ -302,6 +314,8 @@ HEADERS += ../dust3d/uv/chart_packer.h
 SOURCES += ../dust3d/uv/chart_packer.cc
 HEADERS += ../dust3d/uv/max_rectangles.h
 SOURCES += ../dust3d/uv/max_rectangles.cc
+HEADERS += ../dust3d/uv/texture_rasterizer.h
+SOURCES += ../dust3d/uv/texture_rasterizer.cc
 HEADERS += ../dust3d/uv/uv_map_packer.h
 SOURCES += ../dust3d/uv/uv_map_packer.cc
 HEADERS += ../third_party/GuigueDevillers03/tri_tri_intersect.h
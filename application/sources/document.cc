@@ -3,23 +3,46 @@
 #include "image_forever.h"
 #include "mesh_generator.h"
 #include "uv_map_generator.h"
+#include "version.h"
 #include <QApplication>
 #include <QClipboard>
 #include <QDebug>
 #include <QElapsedTimer>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QGuiApplication>
 #include <QMimeData>
+#include <QStandardPaths>
 #include <QThread>
 #include <QVector3D>
 #include <QtCore/qbuffer.h>
 #include <dust3d/base/snapshot_xml.h>
 #include <dust3d/base/texture_type.h>
+#include <dust3d/mesh/mesh_disk_cache.h>
 #include <functional>
 #include <queue>
 
 unsigned long Document::m_maxSnapshot = 1000;
 
+// Shared by all documents, so reopening a project reuses the parts and combinations generated before.
+// The cache outlives the application, the version and the stamp of the executable tell builds apart,
+// so an upgrade or any rebuild never reads meshes generated by other code.
+static const dust3d::MeshDiskCache* meshDiskCache()
+{
+    static const dust3d::MeshDiskCache* diskCache = []() -> const dust3d::MeshDiskCache* {
+        QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        if (cacheLocation.isEmpty())
+            return nullptr;
+        QFileInfo executableInfo(QCoreApplication::applicationFilePath());
+        QString buildId = QString("%1 %2 %3").arg(APP_VER).arg(executableInfo.size()).arg(executableInfo.lastModified().toMSecsSinceEpoch());
+        auto diskCache = new dust3d::MeshDiskCache((cacheLocation + "/meshes").toStdString(), buildId.toStdString());
+        diskCache->setMaxBytes(512ull * 1024 * 1024);
+        diskCache->trim(512ull * 1024 * 1024);
+        return diskCache;
+    }();
+    return diskCache;
+}
+
 Document::Document()
 {
 }
@@ -2242,6 +2265,7 @@ void Document::generateMesh()
     if (nullptr == m_generatedCacheContext)
         m_generatedCacheContext = new MeshGenerator::GeneratedCacheContext;
     m_meshGenerator->setGeneratedCacheContext((dust3d::MeshGenerator::GeneratedCacheContext*)m_generatedCacheContext);
+    m_meshGenerator->setDiskCache(meshDiskCache());
     if (!m_smoothNormal) {
         m_meshGenerator->setSmoothShadingThresholdAngleDegrees(0);
     }
@@ -2275,6 +2299,8 @@ void Document::generateTexture()
 
     QThread* thread = new QThread;
     m_textureGenerator = new UvMapGenerator(std::move(object), std::move(snapshot));
+    if (nullptr != m_uvPackedState && nullptr != textureImage)
+        m_textureGenerator->setPreviousResult(*m_uvPackedState, *textureImage);
     m_textureGenerator->moveToThread(thread);
     connect(thread, &QThread::started, m_textureGenerator, &UvMapGenerator::process);
     connect(m_textureGenerator, &UvMapGenerator::finished, this, &Document::textureReady);
@@ -2294,6 +2320,8 @@ void Document::textureReady()
     delete m_resultTextureMesh;
     m_resultTextureMesh = m_textureGenerator->takeResultMesh().release();
 
+    m_uvPackedState = m_textureGenerator->takeResultPackedState();
+
     auto object = m_textureGenerator->takeObject();
     if (nullptr != object)
         m_uvMappedObject = std::move(object);
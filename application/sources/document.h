@@ -17,6 +17,7 @@
 #include <dust3d/base/snapshot.h>
 #include <dust3d/base/texture_type.h>
 #include <dust3d/base/uuid.h>
+#include <dust3d/uv/uv_map_packer.h>
 #include <map>
 #include <set>
 #include <vector>
@@ -565,6 +566,7 @@ private:
     dust3d::Object* m_currentObject = nullptr;
     bool m_isTextureObsolete = false;
     UvMapGenerator* m_textureGenerator = nullptr;
+    std::unique_ptr<dust3d::UvMapPacker::PackedState> m_uvPackedState;
     std::unique_ptr<dust3d::Object> m_uvMappedObject = std::make_unique<dust3d::Object>();
     ModelMesh* m_resultTextureMesh = nullptr;
     quint64 m_textureImageUpdateVersion = 0;
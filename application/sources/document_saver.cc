@@ -47,16 +47,14 @@ bool DocumentSaver::save(const QString* filename,
 {
     dust3d::Ds3FileWriter ds3Writer;
 
-    {
-        std::string modelXml;
-        saveSnapshotToXmlString(*snapshot, modelXml);
-        if (modelXml.size() > 0) {
-            ds3Writer.add("model.xml", "model", modelXml.c_str(), modelXml.size());
-        }
+    std::string modelXml;
+    saveSnapshotToXmlString(*snapshot, modelXml);
+    if (modelXml.size() > 0) {
+        ds3Writer.addReference("model.xml", "model", modelXml.c_str(), modelXml.size());
     }
 
     if (nullptr != turnaroundPngByteArray && turnaroundPngByteArray->size() > 0)
-        ds3Writer.add("canvas.png", "asset", turnaroundPngByteArray->data(), turnaroundPngByteArray->size());
+        ds3Writer.addReference("canvas.png", "asset", turnaroundPngByteArray->data(), turnaroundPngByteArray->size());
 
     std::set<dust3d::Uuid> imageIds;
     collectUsedResourceIds(snapshot, imageIds);
@@ -66,7 +64,7 @@ bool DocumentSaver::save(const QString* filename,
         if (nullptr == pngByteArray)
             continue;
         if (pngByteArray->size() > 0)
-            ds3Writer.add("images/" + imageId.toString() + ".png", "asset", pngByteArray->data(), pngByteArray->size());
+            ds3Writer.addReference("images/" + imageId.toString() + ".png", "asset", pngByteArray->data(), pngByteArray->size());
     }
 
     return ds3Writer.save(filename->toUtf8().constData());
@@ -943,13 +943,18 @@ void DocumentWindow::openPathAs(const QString& path, const QString& asName)
 
     reset();
 
-    QFile file(path);
-    file.open(QFile::ReadOnly);
-    QByteArray fileData = file.readAll();
-
-    dust3d::Ds3FileReader ds3Reader((const std::uint8_t*)fileData.data(), fileData.size());
-    for (int i = 0; i < (int)ds3Reader.items().size(); ++i) {
-        const dust3d::Ds3ReaderItem& item = ds3Reader.items()[i];
+    // Examples are bundled as Qt resources, which only QFile can read, local files are mapped
+    std::unique_ptr<dust3d::Ds3FileReader> ds3Reader;
+    if (path.startsWith(":")) {
+        QFile file(path);
+        file.open(QFile::ReadOnly);
+        QByteArray fileData = file.readAll();
+        ds3Reader = std::make_unique<dust3d::Ds3FileReader>((const std::uint8_t*)fileData.data(), fileData.size());
+    } else {
+        ds3Reader = std::make_unique<dust3d::Ds3FileReader>(path.toUtf8().constData());
+    }
+    for (int i = 0; i < (int)ds3Reader->items().size(); ++i) {
+        const dust3d::Ds3ReaderItem& item = ds3Reader->items()[i];
         qDebug() << "[" << i << "]item.name:" << item.name << "item.type:" << item.type;
         if (item.type == "asset") {
             if (dust3d::String::startsWith(item.name, "images/")) {
@@ -957,20 +962,19 @@ void DocumentWindow::openPathAs(const QString& path, const QString& asName)
                 std::string imageIdString = dust3d::String::split(filename, '.')[0];
                 dust3d::Uuid imageId = dust3d::Uuid(imageIdString);
                 if (!imageId.isNull()) {
-                    std::vector<std::uint8_t> data;
-                    ds3Reader.loadItem(item.name, &data);
-                    QImage image = QImage::fromData(data.data(), (int)data.size(), "PNG");
+                    dust3d::Ds3ReaderItemView data = ds3Reader->itemView(item.name);
+                    QImage image = QImage::fromData(data.data, (int)data.size, "PNG");
                     (void)ImageForever::add(&image, imageId);
                 }
             }
         }
     }
 
-    for (int i = 0; i < (int)ds3Reader.items().size(); ++i) {
-        const dust3d::Ds3ReaderItem& item = ds3Reader.items()[i];
+    for (int i = 0; i < (int)ds3Reader->items().size(); ++i) {
+        const dust3d::Ds3ReaderItem& item = ds3Reader->items()[i];
         if (item.type == "model") {
             std::vector<std::uint8_t> data;
-            ds3Reader.loadItem(item.name, &data);
+            ds3Reader->loadItem(item.name, &data);
             data.push_back('\0');
             dust3d::Snapshot snapshot;
             loadSnapshotFromXmlString(&snapshot, (char*)data.data());
@@ -978,9 +982,8 @@ void DocumentWindow::openPathAs(const QString& path, const QString& asName)
             m_document->saveSnapshot();
         } else if (item.type == "asset") {
             if (item.name == "canvas.png") {
-                std::vector<std::uint8_t> data;
-                ds3Reader.loadItem(item.name, &data);
-                m_document->updateTurnaround(QImage::fromData(data.data(), (int)data.size(), "PNG"));
+                dust3d::Ds3ReaderItemView data = ds3Reader->itemView(item.name);
+                m_document->updateTurnaround(QImage::fromData(data.data, (int)data.size, "PNG"));
             }
         }
     }
@@ -1,8 +1,10 @@
 #include "uv_map_generator.h"
 #include "image_forever.h"
-#include <QMatrix>
-#include <QPainter>
+#include <QColor>
+#include <cmath>
+#include <dust3d/uv/texture_rasterizer.h>
 #include <dust3d/uv/uv_map_packer.h>
+#include <map>
 #include <unordered_set>
 
 size_t UvMapGenerator::m_textureSize = 4096;
@@ -13,6 +15,12 @@ UvMapGenerator::UvMapGenerator(std::unique_ptr<dust3d::Object> object, std::uniq
 {
 }
 
+void UvMapGenerator::setPreviousResult(const dust3d::UvMapPacker::PackedState& packedState, const QImage& textureColorImage)
+{
+    m_previousPackedState = std::make_unique<dust3d::UvMapPacker::PackedState>(packedState);
+    m_previousTextureColorImage = std::make_unique<QImage>(textureColorImage);
+}
+
 void UvMapGenerator::process()
 {
     generate();
@@ -49,6 +57,13 @@ std::unique_ptr<ModelMesh> UvMapGenerator::takeResultMesh()
     return std::move(m_mesh);
 }
 
+std::unique_ptr<dust3d::UvMapPacker::PackedState> UvMapGenerator::takeResultPackedState()
+{
+    if (nullptr == m_mapPacker)
+        return nullptr;
+    return std::make_unique<dust3d::UvMapPacker::PackedState>(m_mapPacker->packedState());
+}
+
 std::unique_ptr<dust3d::Object> UvMapGenerator::takeObject()
 {
     return std::move(m_object);
@@ -74,19 +89,32 @@ QImage* UvMapGenerator::combineMetalnessRoughnessAmbientOcclusionImages(QImage*
             textureSize = ambientOcclusionImage->height();
         if (textureSize > 0) {
             textureMetalnessRoughnessAmbientOcclusionImage = new QImage(textureSize, textureSize, QImage::Format_ARGB32);
-            textureMetalnessRoughnessAmbientOcclusionImage->fill(QColor(255, 255, 0));
-            for (int row = 0; row < textureMetalnessRoughnessAmbientOcclusionImage->height(); ++row) {
-                for (int col = 0; col < textureMetalnessRoughnessAmbientOcclusionImage->width(); ++col) {
-                    QColor color(255, 255, 0);
-                    if (nullptr != metalnessImage)
-                        color.setBlue(qGray(metalnessImage->pixel(col, row)));
-                    if (nullptr != roughnessImage)
-                        color.setGreen(qGray(roughnessImage->pixel(col, row)));
-                    if (nullptr != ambientOcclusionImage)
-                        color.setRed(qGray(ambientOcclusionImage->pixel(col, row)));
-                    textureMetalnessRoughnessAmbientOcclusionImage->setPixelColor(col, row, color);
-                }
-            }
+            // Pixels out of a smaller source read as zero, the same as QImage::pixel does
+            auto toRasterizerImage = [&](const QImage* image, QImage* converted, dust3d::TextureRasterizer::Image* rasterizerImage) -> const dust3d::TextureRasterizer::Image* {
+                if (nullptr == image)
+                    return nullptr;
+                *converted = image->convertToFormat(QImage::Format_ARGB32);
+                if (converted->width() < textureSize || converted->height() < textureSize)
+                    *converted = converted->copy(0, 0, textureSize, textureSize);
+                rasterizerImage->pixels = (const uint32_t*)converted->constBits();
+                rasterizerImage->width = converted->width();
+                rasterizerImage->height = converted->height();
+                rasterizerImage->stride = converted->bytesPerLine() / 4;
+                return rasterizerImage;
+            };
+            QImage metalness;
+            QImage roughness;
+            QImage ambientOcclusion;
+            dust3d::TextureRasterizer::Image rasterizerMetalness;
+            dust3d::TextureRasterizer::Image rasterizerRoughness;
+            dust3d::TextureRasterizer::Image rasterizerAmbientOcclusion;
+            dust3d::ThreadBudget threadBudget(dust3d::ThreadBudget::hardwareThreadCount());
+            dust3d::TextureRasterizer::packMetalnessRoughnessAmbientOcclusion(toRasterizerImage(metalnessImage, &metalness, &rasterizerMetalness),
+                toRasterizerImage(roughnessImage, &roughness, &rasterizerRoughness),
+                toRasterizerImage(ambientOcclusionImage, &ambientOcclusion, &rasterizerAmbientOcclusion),
+                (uint32_t*)textureMetalnessRoughnessAmbientOcclusionImage->bits(),
+                textureMetalnessRoughnessAmbientOcclusionImage->bytesPerLine() / 4,
+                textureSize, textureSize, &threadBudget);
         }
     }
     return textureMetalnessRoughnessAmbientOcclusionImage;
@@ -95,6 +123,9 @@ QImage* UvMapGenerator::combineMetalnessRoughnessAmbientOcclusionImages(QImage*
 void UvMapGenerator::packUvs()
 {
     m_mapPacker = std::make_unique<dust3d::UvMapPacker>();
+    m_mapPacker->setThreadCount(dust3d::ThreadBudget::hardwareThreadCount());
+    if (nullptr != m_previousPackedState)
+        m_mapPacker->setPreviousState(*m_previousPackedState);
 
     for (const auto& partIt : m_snapshot->parts) {
         dust3d::Uuid imageId;
@@ -119,6 +150,7 @@ void UvMapGenerator::packUvs()
             continue;
         dust3d::UvMapPacker::Part part;
         part.id = imageId;
+        part.partId = dust3d::Uuid(partIt.first);
         part.color = color;
         part.width = width;
         part.height = height;
@@ -133,52 +165,68 @@ void UvMapGenerator::packUvs()
 
 void UvMapGenerator::generateTextureColorImage()
 {
-    m_textureColorImage = std::make_unique<QImage>(UvMapGenerator::m_textureSize, UvMapGenerator::m_textureSize, QImage::Format_ARGB32);
-    m_textureColorImage->fill(Qt::white);
+    dust3d::TextureRasterizer rasterizer(UvMapGenerator::m_textureSize, UvMapGenerator::m_textureSize);
+    rasterizer.setThreadCount(dust3d::ThreadBudget::hardwareThreadCount());
 
-    QPainter colorTexturePainter;
-    colorTexturePainter.begin(m_textureColorImage.get());
-    colorTexturePainter.setRenderHint(QPainter::Antialiasing);
-    colorTexturePainter.setRenderHint(QPainter::HighQualityAntialiasing);
-    colorTexturePainter.setPen(Qt::NoPen);
+    // When the layout was packed incrementally only the changed rectangles are repainted over the previous texture
+    if (m_mapPacker->isIncrementallyPacked()
+        && nullptr != m_previousTextureColorImage
+        && m_previousTextureColorImage->width() == (int)UvMapGenerator::m_textureSize
+        && m_previousTextureColorImage->height() == (int)UvMapGenerator::m_textureSize) {
+        m_textureColorImage = std::move(m_previousTextureColorImage);
+        if (m_mapPacker->dirtyRects().empty())
+            return;
+        for (const auto& rect : m_mapPacker->dirtyRects()) {
+            int left = std::floor(rect.left() * UvMapGenerator::m_textureSize) - 1;
+            int top = std::floor(rect.top() * UvMapGenerator::m_textureSize) - 1;
+            int right = std::ceil(rect.right() * UvMapGenerator::m_textureSize) + 1;
+            int bottom = std::ceil(rect.bottom() * UvMapGenerator::m_textureSize) + 1;
+            rasterizer.addClipRect(left, top, right - left, bottom - top);
+        }
+    } else {
+        m_textureColorImage = std::make_unique<QImage>(UvMapGenerator::m_textureSize, UvMapGenerator::m_textureSize, QImage::Format_ARGB32);
+    }
+    m_previousTextureColorImage.reset();
 
+    std::map<dust3d::Uuid, QImage> sourceImages;
+    std::map<dust3d::Uuid, dust3d::TextureRasterizer::Image> rasterizerImages;
     for (const auto& layout : m_mapPacker->packedLayouts()) {
-        QPixmap brushPixmap;
+        dust3d::TextureRasterizer::Layout rasterizerLayout;
+        rasterizerLayout.left = layout.left * UvMapGenerator::m_textureSize;
+        rasterizerLayout.top = layout.top * UvMapGenerator::m_textureSize;
+        rasterizerLayout.width = layout.width * UvMapGenerator::m_textureSize;
+        rasterizerLayout.height = layout.height * UvMapGenerator::m_textureSize;
         if (layout.id.isNull()) {
-            brushPixmap = QPixmap(layout.width * UvMapGenerator::m_textureSize, layout.height * UvMapGenerator::m_textureSize);
-            brushPixmap.fill(QColor(QString::fromStdString(layout.color.toString())));
+            rasterizerLayout.color = QColor(QString::fromStdString(layout.color.toString())).rgba();
         } else {
-            const QImage* image = ImageForever::get(layout.id);
-            if (nullptr == image) {
-                dust3dDebug << "Find image failed:" << layout.id.toString();
-                continue;
-            }
-            if (layout.flipped) {
-                auto scaledImage = image->scaled(QSize(layout.height * UvMapGenerator::m_textureSize,
-                    layout.width * UvMapGenerator::m_textureSize));
-                QPoint center = scaledImage.rect().center();
-                QMatrix matrix;
-                matrix.translate(center.x(), center.y());
-                matrix.rotate(90);
-                auto rotatedImage = scaledImage.transformed(matrix).mirrored(true, false);
-                brushPixmap = QPixmap::fromImage(rotatedImage);
-            } else {
-                auto scaledImage = image->scaled(QSize(layout.width * UvMapGenerator::m_textureSize,
-                    layout.height * UvMapGenerator::m_textureSize));
-                brushPixmap = QPixmap::fromImage(scaledImage);
+            auto findImage = rasterizerImages.find(layout.id);
+            if (findImage == rasterizerImages.end()) {
+                const QImage* image = ImageForever::get(layout.id);
+                if (nullptr == image) {
+                    dust3dDebug << "Find image failed:" << layout.id.toString();
+                    continue;
+                }
+                QImage& sourceImage = sourceImages[layout.id];
+                sourceImage = image->convertToFormat(QImage::Format_ARGB32);
+                dust3d::TextureRasterizer::Image rasterizerImage;
+                rasterizerImage.pixels = (const uint32_t*)sourceImage.constBits();
+                rasterizerImage.width = sourceImage.width();
+                rasterizerImage.height = sourceImage.height();
+                rasterizerImage.stride = sourceImage.bytesPerLine() / 4;
+                findImage = rasterizerImages.insert({ layout.id, rasterizerImage }).first;
             }
+            rasterizerLayout.image = &findImage->second;
+            rasterizerLayout.flipped = layout.flipped;
         }
-        colorTexturePainter.drawPixmap(layout.left * UvMapGenerator::m_textureSize,
-            layout.top * UvMapGenerator::m_textureSize,
-            brushPixmap);
+        rasterizer.addLayout(rasterizerLayout);
     }
 
-    colorTexturePainter.end();
+    rasterizer.rasterize((uint32_t*)m_textureColorImage->bits(), m_textureColorImage->bytesPerLine() / 4);
 }
 
 void UvMapGenerator::generateUvCoords()
 {
-    std::map<std::array<dust3d::PositionKey, 3>, std::array<dust3d::Vector2, 3>> mergedUvs;
+    dust3d::SpatialHashMap<std::array<dust3d::PositionKey, 3>, std::array<dust3d::Vector2, 3>> mergedUvs;
     for (const auto& layout : m_mapPacker->packedLayouts()) {
         for (const auto& it : layout.globalUv) {
             mergedUvs.insert({ it.first, it.second });
@@ -13,6 +13,7 @@ class UvMapGenerator : public QObject {
     Q_OBJECT
 public:
     UvMapGenerator(std::unique_ptr<dust3d::Object> object, std::unique_ptr<dust3d::Snapshot> snapshot);
+    void setPreviousResult(const dust3d::UvMapPacker::PackedState& packedState, const QImage& textureColorImage);
     void generate();
     std::unique_ptr<QImage> takeResultTextureColorImage();
     std::unique_ptr<QImage> takeResultTextureNormalImage();
@@ -20,6 +21,7 @@ public:
     std::unique_ptr<QImage> takeResultTextureMetalnessImage();
     std::unique_ptr<QImage> takeResultTextureAmbientOcclusionImage();
     std::unique_ptr<ModelMesh> takeResultMesh();
+    std::unique_ptr<dust3d::UvMapPacker::PackedState> takeResultPackedState();
     std::unique_ptr<dust3d::Object> takeObject();
     bool hasTransparencySettings() const;
     static QImage* combineMetalnessRoughnessAmbientOcclusionImages(QImage* metalnessImage,
@@ -34,6 +36,8 @@ private:
     std::unique_ptr<dust3d::Object> m_object;
     std::unique_ptr<dust3d::Snapshot> m_snapshot;
     std::unique_ptr<dust3d::UvMapPacker> m_mapPacker;
+    std::unique_ptr<dust3d::UvMapPacker::PackedState> m_previousPackedState;
+    std::unique_ptr<QImage> m_previousTextureColorImage;
     std::unique_ptr<QImage> m_textureColorImage;
     std::unique_ptr<QImage> m_textureNormalImage;
     std::unique_ptr<QImage> m_textureRoughnessImage;
@@ -0,0 +1,89 @@
+#ifndef DUST3D_BENCH_BENCH_H_
+#define DUST3D_BENCH_BENCH_H_
+
+#include <chrono>
+#include <cstdio>
+#include <dust3d/base/indexed_mesh.h>
+#include <dust3d/base/vector3.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Counted by the global operator new replacement in memory.cpp
+size_t benchAllocationCount();
+size_t benchPeakResidentKilobytes();
+
+class BenchTimer {
+public:
+    BenchTimer()
+        : m_startAllocationCount(benchAllocationCount())
+        , m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    // Freezes the readings, so building the report does not count against the measured code
+    void stop()
+    {
+        m_elapsedMilliseconds = elapsedMilliseconds();
+        m_allocationCount = allocationCount();
+        m_stopped = true;
+    }
+
+    double elapsedMilliseconds() const
+    {
+        if (m_stopped)
+            return m_elapsedMilliseconds;
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+    size_t allocationCount() const
+    {
+        if (m_stopped)
+            return m_allocationCount;
+        return benchAllocationCount() - m_startAllocationCount;
+    }
+
+private:
+    size_t m_startAllocationCount = 0;
+    std::chrono::steady_clock::time_point m_start;
+    bool m_stopped = false;
+    double m_elapsedMilliseconds = 0.0;
+    size_t m_allocationCount = 0;
+};
+
+inline void reportBench(const std::string& name, size_t operations, const BenchTimer& timer)
+{
+    double milliseconds = timer.elapsedMilliseconds();
+    size_t allocationCount = timer.allocationCount();
+    printf("%-48s %10zu ops %10.2f ms %10.2f Mops/s %10zu allocs\n", name.c_str(), operations, milliseconds,
+        milliseconds > 0 ? operations / milliseconds / 1000.0 : 0.0, allocationCount);
+}
+
+// Closed, outward facing test shapes
+void makeUvSphere(const dust3d::Vector3& center, double radius, size_t segments,
+    std::vector<dust3d::Vector3>* vertices, dust3d::IndexedTriangles* triangles);
+void makeCapsule(const dust3d::Vector3& from, const dust3d::Vector3& to, double radius, size_t segments,
+    std::vector<dust3d::Vector3>* vertices, dust3d::IndexedTriangles* triangles);
+bool makeUnion(const std::vector<dust3d::Vector3>& firstVertices, const dust3d::IndexedTriangles& firstTriangles,
+    const std::vector<dust3d::Vector3>& secondVertices, const dust3d::IndexedTriangles& secondTriangles,
+    std::vector<dust3d::Vector3>* vertices, dust3d::IndexedTriangles* triangles);
+
+namespace dust3d {
+class Snapshot;
+}
+
+// Loads the model of a .ds3 file given relative to the source tree
+std::unique_ptr<dust3d::Snapshot> loadBenchSnapshot(const std::string& sampleFile);
+
+void runSpatialHashMapBench();
+void runChartPackerBench();
+void runUuidBench();
+void runTubeMeshBench();
+void runStitchMeshBench();
+void runBooleanBench();
+void runWeldVerticesBench();
+void runSmoothNormalBench();
+void runMeshValidationBench();
+void runMeshGeneratorBench();
+
+#endif
@@ -0,0 +1,56 @@
+#include "bench.h"
+#include <dust3d/mesh/solid_mesh.h>
+#include <dust3d/mesh/solid_mesh_boolean_operation.h>
+
+namespace {
+
+struct Shape {
+    std::vector<dust3d::Vector3> vertices;
+    dust3d::IndexedTriangles triangles;
+};
+
+void benchBoolean(const std::string& name, const Shape& first, const Shape& second, dust3d::ThreadBudget* threadBudget)
+{
+    dust3d::IndexedTriangles unionTriangles;
+    dust3d::IndexedTriangles diffTriangles;
+    BenchTimer timer;
+    dust3d::SolidMesh firstMesh;
+    firstMesh.setVertices(&first.vertices);
+    firstMesh.setTriangles(&first.triangles);
+    firstMesh.prepare();
+    dust3d::SolidMesh secondMesh;
+    secondMesh.setVertices(&second.vertices);
+    secondMesh.setTriangles(&second.triangles);
+    secondMesh.prepare();
+    dust3d::SolidMeshBooleanOperation booleanOperation(&firstMesh, &secondMesh);
+    booleanOperation.setThreadBudget(threadBudget);
+    bool combined = booleanOperation.combine();
+    if (combined) {
+        booleanOperation.fetchUnion(unionTriangles);
+        booleanOperation.fetchDiff(diffTriangles);
+    }
+    timer.stop();
+    reportBench(name, first.triangles.size() + second.triangles.size(), timer);
+    printf("%-48s %10zu union %10zu diff%s\n", (name + " result").c_str(),
+        unionTriangles.size(), diffTriangles.size(), combined ? "" : " (failed)");
+}
+
+}
+
+void runBooleanBench()
+{
+    dust3d::ThreadBudget threadBudget(dust3d::ThreadBudget::hardwareThreadCount());
+    for (size_t segments : { 16, 32, 64, 128 }) {
+        Shape sphere;
+        makeUvSphere(dust3d::Vector3(0.0, 0.0, 0.0), 1.0, segments, &sphere.vertices, &sphere.triangles);
+        Shape offsetSphere;
+        makeUvSphere(dust3d::Vector3(0.61, 0.13, 0.07), 0.8, segments, &offsetSphere.vertices, &offsetSphere.triangles);
+        Shape capsule;
+        makeCapsule(dust3d::Vector3(-1.5, 0.21, 0.09), dust3d::Vector3(1.5, -0.17, 0.11), 0.35, segments, &capsule.vertices, &capsule.triangles);
+
+        std::string suffix = " " + std::to_string(segments) + " segments";
+        benchBoolean("sphere/sphere" + suffix, sphere, offsetSphere, nullptr);
+        benchBoolean("sphere/capsule" + suffix, sphere, capsule, nullptr);
+        benchBoolean("sphere/capsule threaded" + suffix, sphere, capsule, &threadBudget);
+    }
+}
@@ -0,0 +1,62 @@
+#include "bench.h"
+#include <dust3d/base/task_group.h>
+#include <dust3d/uv/chart_packer.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+const size_t g_chartCount = 300;
+
+std::vector<std::pair<float, float>> generateCharts(const std::string& distribution)
+{
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> uniform(0.05f, 1.0f);
+    std::lognormal_distribution<float> longTail(-2.0f, 0.8f);
+    std::vector<std::pair<float, float>> charts;
+    charts.reserve(g_chartCount);
+    for (size_t i = 0; i < g_chartCount; ++i) {
+        if ("uniform" == distribution) {
+            charts.push_back({ uniform(generator), uniform(generator) });
+        } else if ("long tail" == distribution) {
+            float size = std::min(longTail(generator), 2.0f);
+            charts.push_back({ size, size * uniform(generator) });
+        } else {
+            float length = uniform(generator);
+            charts.push_back({ length, length * 0.08f });
+        }
+    }
+    return charts;
+}
+
+}
+
+void runChartPackerBench()
+{
+    dust3d::ThreadBudget threadBudget(dust3d::ThreadBudget::hardwareThreadCount());
+    for (const char* distributionName : { "uniform", "long tail", "skinny" }) {
+        std::string distribution = distributionName;
+        auto charts = generateCharts(distribution);
+        float textureSize = 0;
+        {
+            dust3d::ChartPacker packer;
+            packer.setCharts(charts);
+            BenchTimer timer;
+            textureSize = packer.pack();
+            timer.stop();
+            reportBench(distribution + " pack", charts.size(), timer);
+            printf("%-48s %10.4f texture size\n", (distribution + " pack result").c_str(), textureSize);
+        }
+        {
+            dust3d::ChartPacker packer;
+            packer.setCharts(charts);
+            packer.setThreadBudget(&threadBudget);
+            BenchTimer timer;
+            textureSize = packer.pack();
+            timer.stop();
+            reportBench(distribution + " pack threaded", charts.size(), timer);
+            printf("%-48s %10.4f texture size\n", (distribution + " pack threaded result").c_str(), textureSize);
+        }
+    }
+}
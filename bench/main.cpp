@@ -0,0 +1,37 @@
+#include "bench.h"
+#include <cstring>
+#include <functional>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::pair<const char*, std::function<void()>>> benches = {
+        { "spatial_hash_map", runSpatialHashMapBench },
+        { "uuid", runUuidBench },
+        { "chart_packer", runChartPackerBench },
+        { "tube_mesh", runTubeMeshBench },
+        { "stitch_mesh", runStitchMeshBench },
+        { "boolean", runBooleanBench },
+        { "weld_vertices", runWeldVerticesBench },
+        { "smooth_normal", runSmoothNormalBench },
+        { "mesh_validation", runMeshValidationBench },
+        { "mesh_generator", runMeshGeneratorBench },
+    };
+
+    for (const auto& bench : benches) {
+        if (argc > 1) {
+            bool selected = false;
+            for (int i = 1; i < argc; ++i) {
+                if (0 == strcmp(argv[i], bench.first))
+                    selected = true;
+            }
+            if (!selected)
+                continue;
+        }
+        printf("[%s]\n", bench.first);
+        bench.second();
+        printf("%-48s %10zu KB\n", "peak RSS", benchPeakResidentKilobytes());
+    }
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "bench.h"
+#include <dust3d/base/ds3_file.h>
+#include <dust3d/base/snapshot_xml.h>
+#include <dust3d/mesh/mesh_generator.h>
+#include <memory>
+
+namespace {
+
+const char* g_sampleFiles[] = {
+    "imgui_gui/aaa.ds3",
+    "application/resources/model-dog.ds3",
+    "application/resources/model-meerkat.ds3",
+    "application/resources/model-mosquito.ds3",
+};
+
+void benchGenerate(const std::string& name, const dust3d::Snapshot& snapshot,
+    dust3d::MeshGenerator::GeneratedCacheContext* cacheContext, size_t threadCount)
+{
+    BenchTimer timer;
+    dust3d::MeshGenerator meshGenerator(new dust3d::Snapshot(snapshot));
+    meshGenerator.setGeneratedCacheContext(cacheContext);
+    meshGenerator.setThreadCount(threadCount);
+    meshGenerator.generate();
+    std::unique_ptr<dust3d::Object> object(meshGenerator.takeObject());
+    timer.stop();
+    reportBench(name, 1, timer);
+    printf("%-48s %10zu vertices %10zu triangles%s\n", (name + " result").c_str(),
+        object->vertices.size(), object->triangles.size(), meshGenerator.isSuccessful() ? "" : " (partial)");
+}
+
+}
+
+std::unique_ptr<dust3d::Snapshot> loadBenchSnapshot(const std::string& sampleFile)
+{
+    dust3d::Ds3FileReader ds3Reader(std::string(BENCH_SOURCE_DIR) + "/" + sampleFile);
+    for (const auto& item : ds3Reader.items()) {
+        if ("model" != item.type)
+            continue;
+        std::vector<std::uint8_t> data;
+        ds3Reader.loadItem(item.name, &data);
+        data.push_back('\0');
+        auto snapshot = std::make_unique<dust3d::Snapshot>();
+        dust3d::loadSnapshotFromXmlString(snapshot.get(), (char*)data.data());
+        return snapshot;
+    }
+    return nullptr;
+}
+
+void runMeshGeneratorBench()
+{
+    for (const auto& sampleFile : g_sampleFiles) {
+        auto snapshot = loadBenchSnapshot(sampleFile);
+        if (nullptr == snapshot) {
+            printf("%-48s missing\n", sampleFile);
+            continue;
+        }
+        std::string name = std::string(sampleFile).substr(std::string(sampleFile).rfind('/') + 1);
+        benchGenerate(name + " generate", *snapshot, nullptr, 1);
+        benchGenerate(name + " generate threaded", *snapshot, nullptr, dust3d::ThreadBudget::hardwareThreadCount());
+
+        // Regenerating an unchanged snapshot with its cache context is the cost of a no-op edit
+        dust3d::MeshGenerator::GeneratedCacheContext cacheContext;
+        benchGenerate(name + " generate cold cache", *snapshot, &cacheContext, 1);
+        benchGenerate(name + " generate warm cache", *snapshot, &cacheContext, 1);
+    }
+}
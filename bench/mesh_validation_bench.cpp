@@ -0,0 +1,39 @@
+#include "bench.h"
+#include <dust3d/mesh/mesh_validation.h>
+
+void runMeshValidationBench()
+{
+    for (size_t segments : { 32, 64, 128, 256 }) {
+        std::vector<dust3d::Vector3> sphereVertices;
+        dust3d::IndexedTriangles sphereTriangles;
+        makeUvSphere(dust3d::Vector3(0.0, 0.0, 0.0), 1.0, segments, &sphereVertices, &sphereTriangles);
+        std::vector<dust3d::Vector3> capsuleVertices;
+        dust3d::IndexedTriangles capsuleTriangles;
+        makeCapsule(dust3d::Vector3(-1.5, 0.21, 0.09), dust3d::Vector3(1.5, -0.17, 0.11), 0.35, segments, &capsuleVertices, &capsuleTriangles);
+        std::vector<dust3d::Vector3> vertices;
+        dust3d::IndexedTriangles indexedTriangles;
+        if (!makeUnion(sphereVertices, sphereTriangles, capsuleVertices, capsuleTriangles, &vertices, &indexedTriangles))
+            continue;
+        std::vector<std::vector<size_t>> triangles;
+        dust3d::toFaces(indexedTriangles, &triangles);
+
+        std::string name = "isMeshWatertight " + std::to_string(segments) + " segments";
+        {
+            BenchTimer timer;
+            bool isWatertight = dust3d::isMeshWatertight(triangles);
+            timer.stop();
+            reportBench(name, triangles.size(), timer);
+            printf("%-48s %10s\n", (name + " result").c_str(), isWatertight ? "watertight" : "open");
+        }
+
+        name = "validateMesh " + std::to_string(segments) + " segments";
+        {
+            BenchTimer timer;
+            dust3d::MeshValidationReport report = dust3d::validateMesh(vertices, triangles);
+            timer.stop();
+            reportBench(name, triangles.size(), timer);
+            printf("%-48s %10zu boundary %10zu non-manifold %10zu self-intersections\n", (name + " result").c_str(),
+                report.boundaryHalfEdgeCount, report.nonManifoldVertexCount, report.selfIntersectionCount);
+        }
+    }
+}
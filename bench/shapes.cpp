@@ -0,0 +1,85 @@
+#include "bench.h"
+#include <dust3d/base/cut_face.h>
+#include <dust3d/base/math.h>
+#include <dust3d/mesh/solid_mesh.h>
+#include <dust3d/mesh/solid_mesh_boolean_operation.h>
+#include <dust3d/mesh/tube_mesh_builder.h>
+#include <dust3d/mesh/triangulate.h>
+#include <cmath>
+
+void makeUvSphere(const dust3d::Vector3& center, double radius, size_t segments,
+    std::vector<dust3d::Vector3>* vertices, dust3d::IndexedTriangles* triangles)
+{
+    size_t ringCount = segments / 2;
+    std::vector<double> latitudes;
+    for (size_t i = 1; i < ringCount; ++i)
+        latitudes.push_back(dust3d::Math::Pi * i / ringCount);
+
+    vertices->clear();
+    triangles->clear();
+    vertices->push_back(center + dust3d::Vector3(0.0, radius, 0.0));
+    for (const auto& latitude : latitudes) {
+        for (size_t j = 0; j < segments; ++j) {
+            double longitude = 2.0 * dust3d::Math::Pi * j / segments;
+            vertices->push_back(center + dust3d::Vector3(std::sin(latitude) * std::cos(longitude), std::cos(latitude), std::sin(latitude) * std::sin(longitude)) * radius);
+        }
+    }
+    vertices->push_back(center + dust3d::Vector3(0.0, -radius, 0.0));
+
+    uint32_t southPole = (uint32_t)vertices->size() - 1;
+    auto ringVertex = [&](size_t ring, size_t column) {
+        return (uint32_t)(1 + ring * segments + column % segments);
+    };
+    for (size_t j = 0; j < segments; ++j)
+        triangles->push_back({ 0, ringVertex(0, j + 1), ringVertex(0, j) });
+    for (size_t ring = 0; ring + 1 < latitudes.size(); ++ring) {
+        for (size_t j = 0; j < segments; ++j) {
+            triangles->push_back({ ringVertex(ring, j), ringVertex(ring, j + 1), ringVertex(ring + 1, j) });
+            triangles->push_back({ ringVertex(ring, j + 1), ringVertex(ring + 1, j + 1), ringVertex(ring + 1, j) });
+        }
+    }
+    for (size_t j = 0; j < segments; ++j)
+        triangles->push_back({ ringVertex(latitudes.size() - 1, j), ringVertex(latitudes.size() - 1, j + 1), southPole });
+}
+
+void makeCapsule(const dust3d::Vector3& from, const dust3d::Vector3& to, double radius, size_t segments,
+    std::vector<dust3d::Vector3>* vertices, dust3d::IndexedTriangles* triangles)
+{
+    dust3d::TubeMeshBuilder::BuildParameters buildParameters;
+    for (size_t i = 0; i < segments; ++i) {
+        double angle = 2.0 * dust3d::Math::Pi * i / segments;
+        buildParameters.cutFace.emplace_back(std::cos(angle), std::sin(angle));
+    }
+    dust3d::normalizeCutFacePoints(&buildParameters.cutFace);
+    buildParameters.frontEndRounded = buildParameters.backEndRounded = true;
+    std::vector<dust3d::MeshNode> nodes = {
+        { from, radius, dust3d::Uuid(0, 1) },
+        { to, radius, dust3d::Uuid(0, 2) },
+    };
+    dust3d::TubeMeshBuilder tubeMeshBuilder(buildParameters, std::move(nodes), false);
+    tubeMeshBuilder.build();
+    *vertices = tubeMeshBuilder.generatedVertices();
+    triangles->clear();
+    dust3d::triangulate(*vertices, tubeMeshBuilder.generatedFaces(), triangles);
+}
+
+bool makeUnion(const std::vector<dust3d::Vector3>& firstVertices, const dust3d::IndexedTriangles& firstTriangles,
+    const std::vector<dust3d::Vector3>& secondVertices, const dust3d::IndexedTriangles& secondTriangles,
+    std::vector<dust3d::Vector3>* vertices, dust3d::IndexedTriangles* triangles)
+{
+    dust3d::SolidMesh firstMesh;
+    firstMesh.setVertices(&firstVertices);
+    firstMesh.setTriangles(&firstTriangles);
+    firstMesh.prepare();
+    dust3d::SolidMesh secondMesh;
+    secondMesh.setVertices(&secondVertices);
+    secondMesh.setTriangles(&secondTriangles);
+    secondMesh.prepare();
+    dust3d::SolidMeshBooleanOperation booleanOperation(&firstMesh, &secondMesh);
+    if (!booleanOperation.combine())
+        return false;
+    triangles->clear();
+    booleanOperation.fetchUnion(*triangles);
+    *vertices = booleanOperation.resultVertices();
+    return true;
+}
@@ -0,0 +1,41 @@
+#include "bench.h"
+#include <dust3d/mesh/smooth_normal.h>
+
+void runSmoothNormalBench()
+{
+    dust3d::ThreadBudget threadBudget(dust3d::ThreadBudget::hardwareThreadCount());
+    for (size_t segments : { 32, 128, 512 }) {
+        std::vector<dust3d::Vector3> vertices;
+        dust3d::IndexedTriangles indexedTriangles;
+        makeUvSphere(dust3d::Vector3(0.0, 0.0, 0.0), 1.0, segments, &vertices, &indexedTriangles);
+        std::vector<std::vector<size_t>> triangles;
+        dust3d::toFaces(indexedTriangles, &triangles);
+        std::vector<dust3d::Vector3> triangleNormals;
+        triangleNormals.reserve(triangles.size());
+        for (const auto& triangle : triangles)
+            triangleNormals.push_back(dust3d::Vector3::normal(vertices[triangle[0]], vertices[triangle[1]], vertices[triangle[2]]));
+
+        // Half of the vertices keep hard edges, as the per node smooth cutoff in a generated object would
+        std::vector<float> thresholdAngleDegrees(vertices.size());
+        for (size_t i = 0; i < thresholdAngleDegrees.size(); ++i)
+            thresholdAngleDegrees[i] = 0 == i % 2 ? 60.0f : 0.0f;
+
+        for (int variant = 0; variant < 3; ++variant) {
+            const std::vector<float>* thresholds = 0 == variant ? nullptr : &thresholdAngleDegrees;
+            dust3d::ThreadBudget* budget = 2 == variant ? &threadBudget : nullptr;
+            std::string name = "smoothNormal " + std::to_string(segments) + " segments"
+                + (nullptr == thresholds ? "" : " cutoff") + (nullptr == budget ? "" : " threaded");
+            std::vector<std::vector<dust3d::Vector3>> triangleVertexNormals;
+            BenchTimer timer;
+            dust3d::smoothNormal(vertices, triangles, triangleNormals, thresholds, &triangleVertexNormals, budget);
+            timer.stop();
+            reportBench(name, triangles.size(), timer);
+            double checksum = 0.0;
+            for (const auto& normals : triangleVertexNormals) {
+                for (const auto& normal : normals)
+                    checksum += normal.x() + normal.y() * 2.0 + normal.z() * 3.0;
+            }
+            printf("%-48s %10.4f checksum\n", (name + " result").c_str(), checksum);
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#include "bench.h"
+#include <dust3d/base/spatial_hash_map.h>
+#include <map>
+#include <random>
+
+namespace {
+
+const size_t vertexCount = 1000000;
+
+std::vector<dust3d::Vector3> generateVertices()
+{
+    // Roughly a third of the positions repeat, like the shared corners of a triangle soup
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    std::vector<dust3d::Vector3> vertices;
+    vertices.reserve(vertexCount);
+    while (vertices.size() < vertexCount) {
+        if (vertices.size() > 3 && 0 == generator() % 3) {
+            vertices.push_back(vertices[generator() % vertices.size()]);
+            continue;
+        }
+        vertices.emplace_back(distribution(generator), distribution(generator), distribution(generator));
+    }
+    return vertices;
+}
+
+template <typename Map>
+void benchMap(const std::string& name, const std::vector<dust3d::Vector3>& vertices)
+{
+    Map map;
+    size_t checksum = 0;
+    {
+        BenchTimer timer;
+        for (size_t i = 0; i < vertices.size(); ++i)
+            checksum += map.insert({ dust3d::PositionKey(vertices[i]), i }).first->second;
+        timer.stop();
+        reportBench(name + " insert", vertices.size(), timer);
+    }
+    {
+        BenchTimer timer;
+        for (size_t i = vertices.size(); i > 0; --i) {
+            auto findResult = map.find(dust3d::PositionKey(vertices[i - 1]));
+            if (findResult != map.end())
+                checksum += findResult->second;
+        }
+        timer.stop();
+        reportBench(name + " find", vertices.size(), timer);
+    }
+    printf("%-48s %10zu unique, checksum %zu\n", (name + " result").c_str(), map.size(), checksum);
+}
+
+}
+
+void runSpatialHashMapBench()
+{
+    auto vertices = generateVertices();
+    benchMap<std::map<dust3d::PositionKey, size_t>>("std::map<PositionKey>", vertices);
+    benchMap<dust3d::SpatialHashMap<dust3d::PositionKey, size_t>>("SpatialHashMap<PositionKey>", vertices);
+}
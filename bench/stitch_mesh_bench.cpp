@@ -0,0 +1,44 @@
+#include "bench.h"
+#include <dust3d/mesh/stitch_mesh_builder.h>
+#include <cmath>
+
+namespace {
+
+const size_t g_splineCount = 4;
+
+// Parallel wavy lines stitched into a sheet, the last one closes the sheet into a cap
+std::vector<dust3d::StitchMeshBuilder::Spline> generateSplines(size_t nodeCount)
+{
+    std::vector<dust3d::StitchMeshBuilder::Spline> splines;
+    for (size_t splineIndex = 0; splineIndex < g_splineCount; ++splineIndex) {
+        dust3d::StitchMeshBuilder::Spline spline;
+        for (size_t i = 0; i < nodeCount; ++i) {
+            double t = (double)i / nodeCount;
+            spline.nodes.push_back({ dust3d::Vector3(t * 2.0, std::sin(t * 9.0 + splineIndex) * 0.2, splineIndex * 0.4),
+                0.02,
+                dust3d::Uuid(splineIndex + 1, i + 1) });
+        }
+        spline.sourceId = dust3d::Uuid(splineIndex + 1, 0);
+        splines.push_back(std::move(spline));
+    }
+    splines.back().isClosing = true;
+    splines.back().nodes.resize(1);
+    return splines;
+}
+
+}
+
+void runStitchMeshBench()
+{
+    for (size_t nodeCount : { 16, 128, 1024 }) {
+        auto splines = generateSplines(nodeCount);
+        std::string name = "stitch " + std::to_string(g_splineCount) + " splines " + std::to_string(nodeCount) + " nodes";
+        BenchTimer timer;
+        dust3d::StitchMeshBuilder stitchMeshBuilder(std::move(splines));
+        stitchMeshBuilder.build();
+        timer.stop();
+        reportBench(name, nodeCount * g_splineCount, timer);
+        printf("%-48s %10zu vertices %10zu faces\n", (name + " result").c_str(),
+            stitchMeshBuilder.generatedVertices().size(), stitchMeshBuilder.generatedFaces().size());
+    }
+}
@@ -0,0 +1,42 @@
+#include "bench.h"
+#include <dust3d/base/cut_face.h>
+#include <dust3d/mesh/tube_mesh_builder.h>
+#include <cmath>
+
+namespace {
+
+// A wavy limb with a varying radius, like the nodes of a drawn tail
+std::vector<dust3d::MeshNode> generateNodes(size_t nodeCount)
+{
+    std::vector<dust3d::MeshNode> nodes;
+    nodes.reserve(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        double t = (double)i / nodeCount;
+        nodes.push_back({ dust3d::Vector3(t * 4.0, std::sin(t * 12.0) * 0.5, std::cos(t * 7.0) * 0.3),
+            0.05 + 0.04 * std::sin(t * 20.0) + 0.05 * (1.0 - t),
+            dust3d::Uuid(0, i + 1) });
+    }
+    return nodes;
+}
+
+}
+
+void runTubeMeshBench()
+{
+    for (const auto& cutFace : { dust3d::CutFace::Quad, dust3d::CutFace::Hexagon }) {
+        for (size_t nodeCount : { 8, 64, 512 }) {
+            dust3d::TubeMeshBuilder::BuildParameters buildParameters;
+            buildParameters.cutFace = dust3d::CutFaceToPoints(cutFace);
+            buildParameters.frontEndRounded = buildParameters.backEndRounded = true;
+            auto nodes = generateNodes(nodeCount);
+            std::string name = dust3d::CutFaceToString(cutFace) + " tube " + std::to_string(nodeCount) + " nodes";
+            BenchTimer timer;
+            dust3d::TubeMeshBuilder tubeMeshBuilder(buildParameters, std::move(nodes), false);
+            tubeMeshBuilder.build();
+            timer.stop();
+            reportBench(name, nodeCount, timer);
+            printf("%-48s %10zu vertices %10zu faces\n", (name + " result").c_str(),
+                tubeMeshBuilder.generatedVertices().size(), tubeMeshBuilder.generatedFaces().size());
+        }
+    }
+}
@@ -0,0 +1,127 @@
+#include "bench.h"
+#include <dust3d/base/snapshot.h>
+#include <dust3d/base/uuid.h>
+#include <dust3d/mesh/mesh_generator.h>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const size_t g_uuidCount = 200000;
+const size_t g_lookupRounds = 10;
+
+template <typename Map, typename Key>
+void benchLookup(const std::string& name, const std::vector<Key>& keys)
+{
+    Map map;
+    for (size_t i = 0; i < keys.size(); ++i)
+        map.insert({ keys[i], i });
+    size_t checksum = 0;
+    BenchTimer timer;
+    for (size_t round = 0; round < g_lookupRounds; ++round) {
+        for (size_t i = keys.size(); i > 0; --i) {
+            auto findResult = map.find(keys[i - 1]);
+            if (findResult != map.end())
+                checksum += findResult->second;
+        }
+    }
+    timer.stop();
+    reportBench(name + " find", keys.size() * g_lookupRounds, timer);
+    printf("%-48s %10zu checksum\n", (name + " result").c_str(), checksum);
+}
+
+// The vertex position to source node to node properties chain postprocessing walks for every object vertex
+template <typename PositionMap, typename NodeMap>
+void benchNodeLookupChain(const std::string& name, const std::vector<dust3d::Vector3>& vertices,
+    const PositionMap& positionToNodeIdMap, const NodeMap& nodeMap)
+{
+    float checksum = 0.0f;
+    size_t foundCount = 0;
+    BenchTimer timer;
+    for (size_t round = 0; round < g_lookupRounds; ++round) {
+        for (const auto& vertex : vertices) {
+            auto findSourceNode = positionToNodeIdMap.find(dust3d::PositionKey(vertex));
+            if (findSourceNode == positionToNodeIdMap.end())
+                continue;
+            auto findObjectNode = nodeMap.find(findSourceNode->second);
+            if (findObjectNode == nodeMap.end())
+                continue;
+            checksum += findObjectNode->second.smoothCutoffDegrees + findObjectNode->second.color.red();
+            ++foundCount;
+        }
+    }
+    timer.stop();
+    reportBench(name + " lookup chain", vertices.size() * g_lookupRounds, timer);
+    printf("%-48s %10zu found %10.2f checksum\n", (name + " lookup chain result").c_str(), foundCount, checksum);
+}
+
+void benchObjectNodeLookups(const std::string& sampleFile)
+{
+    auto snapshot = loadBenchSnapshot(sampleFile);
+    if (nullptr == snapshot) {
+        printf("%-48s missing\n", sampleFile.c_str());
+        return;
+    }
+    dust3d::MeshGenerator meshGenerator(snapshot.release());
+    meshGenerator.generate();
+    std::unique_ptr<dust3d::Object> object(meshGenerator.takeObject());
+    std::string name = sampleFile.substr(sampleFile.rfind('/') + 1);
+
+    benchNodeLookupChain(name, object->vertices, object->positionToNodeIdMap, object->nodeMap);
+
+    // The same chain through string keyed maps stands for the former string backed Uuid
+    std::map<dust3d::PositionKey, std::string> positionToNodeIdStringMap;
+    for (const auto& it : object->positionToNodeIdMap)
+        positionToNodeIdStringMap.insert({ it.first, dust3d::to_string(it.second) });
+    std::map<std::string, dust3d::ObjectNode> nodeStringMap;
+    for (const auto& it : object->nodeMap)
+        nodeStringMap.insert({ dust3d::to_string(it.first), it.second });
+    benchNodeLookupChain(name + " std::string", object->vertices, positionToNodeIdStringMap, nodeStringMap);
+}
+
+}
+
+void runUuidBench()
+{
+    std::vector<dust3d::Uuid> uuids;
+    uuids.reserve(g_uuidCount);
+    {
+        BenchTimer timer;
+        for (size_t i = 0; i < g_uuidCount; ++i)
+            uuids.emplace_back(dust3d::Uuid::createUuid());
+        timer.stop();
+        reportBench("Uuid::createUuid", g_uuidCount, timer);
+    }
+
+    std::vector<std::string> strings;
+    strings.reserve(g_uuidCount);
+    {
+        BenchTimer timer;
+        for (const auto& uuid : uuids)
+            strings.emplace_back(dust3d::to_string(uuid));
+        timer.stop();
+        reportBench("to_string(Uuid)", g_uuidCount, timer);
+    }
+
+    {
+        size_t mismatches = 0;
+        BenchTimer timer;
+        for (size_t i = 0; i < g_uuidCount; ++i) {
+            if (dust3d::Uuid(strings[i]) != uuids[i])
+                ++mismatches;
+        }
+        timer.stop();
+        reportBench("Uuid(std::string)", g_uuidCount, timer);
+        printf("%-48s %10zu mismatches\n", "Uuid(std::string) result", mismatches);
+    }
+
+    // The string keyed maps stand for the former string backed Uuid
+    benchLookup<std::map<std::string, size_t>>("std::map<std::string>", strings);
+    benchLookup<std::map<dust3d::Uuid, size_t>>("std::map<Uuid>", uuids);
+    benchLookup<std::unordered_map<std::string, size_t>>("std::unordered_map<std::string>", strings);
+    benchLookup<std::unordered_map<dust3d::Uuid, size_t>>("std::unordered_map<Uuid>", uuids);
+
+    benchObjectNodeLookups("application/resources/model-dog.ds3");
+    benchObjectNodeLookups("application/resources/model-mosquito.ds3");
+}
@@ -0,0 +1,28 @@
+#include "bench.h"
+#include <dust3d/mesh/weld_vertices.h>
+
+void runWeldVerticesBench()
+{
+    for (size_t segments : { 32, 64, 128, 256 }) {
+        // Boolean seams are where the generator finds its slivers to weld
+        std::vector<dust3d::Vector3> sphereVertices;
+        dust3d::IndexedTriangles sphereTriangles;
+        makeUvSphere(dust3d::Vector3(0.0, 0.0, 0.0), 1.0, segments, &sphereVertices, &sphereTriangles);
+        std::vector<dust3d::Vector3> capsuleVertices;
+        dust3d::IndexedTriangles capsuleTriangles;
+        makeCapsule(dust3d::Vector3(-1.5, 0.21, 0.09), dust3d::Vector3(1.5, -0.17, 0.11), 0.35, segments, &capsuleVertices, &capsuleTriangles);
+        std::vector<dust3d::Vector3> vertices;
+        dust3d::IndexedTriangles indexedTriangles;
+        if (!makeUnion(sphereVertices, sphereTriangles, capsuleVertices, capsuleTriangles, &vertices, &indexedTriangles))
+            continue;
+        std::vector<std::vector<size_t>> triangles;
+        dust3d::toFaces(indexedTriangles, &triangles);
+
+        std::string name = "weldVertices " + std::to_string(segments) + " segments";
+        BenchTimer timer;
+        size_t affectedCount = dust3d::weldVertices(vertices, triangles, 0.01, std::set<dust3d::PositionKey>());
+        timer.stop();
+        reportBench(name, indexedTriangles.size(), timer);
+        printf("%-48s %10zu affected %10zu triangles\n", (name + " result").c_str(), affectedCount, triangles.size());
+    }
+}
@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dust3d/base/ds3_file.h>
+#include <dust3d/base/snapshot_xml.h>
+#include <dust3d/base/task_group.h>
+#include <dust3d/mesh/mesh_disk_cache.h>
+#include <dust3d/mesh/mesh_generator.h>
+#include <dust3d/mesh/mesh_validation.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct Options {
+    std::vector<std::string> inputs;
+    std::string outputDirectory;
+    std::string cacheDirectory;
+    size_t cacheMegabytes = 512;
+    size_t jobCount = dust3d::ThreadBudget::hardwareThreadCount();
+    size_t threadCount = 1;
+    bool validate = false;
+    bool balancedUnion = false;
+};
+
+struct Result {
+    std::string path;
+    std::string error;
+    bool isSuccessful = false;
+    size_t vertexCount = 0;
+    size_t faceCount = 0;
+    double milliseconds = 0.0;
+    dust3d::MeshValidationReport validation;
+};
+
+static void printUsage(const char* program)
+{
+    fprintf(stderr,
+        "Usage: %s [options] <file.ds3 | directory>...\n"
+        "Generate the model of each .ds3 file, directories are scanned for .ds3 files.\n"
+        "\n"
+        "  -o <directory>      write <name>.obj of each input into the directory\n"
+        "  -j <count>          files generated concurrently, defaults to the hardware thread count\n"
+        "  -t <count>          threads used inside each generation, defaults to 1\n"
+        "  --cache <directory> reuse tubes and combinations kept in a disk cache\n"
+        "  --cache-size <MB>   trim the disk cache to this size, defaults to 512\n"
+        "  --validate          check the generated meshes for holes, non-manifold parts and self-intersections\n"
+        "  --balanced-union    union the parts pairwise as a balanced tree, the seams come out differently\n"
+        "  -h, --help          show this help\n",
+        program);
+}
+
+static bool parseCount(const char* text, size_t* count)
+{
+    char* end = nullptr;
+    long value = strtol(text, &end, 10);
+    if (end == text || '\0' != *end || value < 1)
+        return false;
+    *count = (size_t)value;
+    return true;
+}
+
+static bool parseOptions(int argc, char* argv[], Options* options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (0 == strcmp(arg, "-h") || 0 == strcmp(arg, "--help")) {
+            return false;
+        } else if (0 == strcmp(arg, "-o") && hasValue) {
+            options->outputDirectory = argv[++i];
+        } else if (0 == strcmp(arg, "--cache") && hasValue) {
+            options->cacheDirectory = argv[++i];
+        } else if (0 == strcmp(arg, "--cache-size") && hasValue) {
+            if (!parseCount(argv[++i], &options->cacheMegabytes))
+                return false;
+        } else if (0 == strcmp(arg, "--validate")) {
+            options->validate = true;
+        } else if (0 == strcmp(arg, "--balanced-union")) {
+            options->balancedUnion = true;
+        } else if (0 == strcmp(arg, "-j") && hasValue) {
+            if (!parseCount(argv[++i], &options->jobCount))
+                return false;
+        } else if (0 == strcmp(arg, "-t") && hasValue) {
+            if (!parseCount(argv[++i], &options->threadCount))
+                return false;
+        } else if ('-' == arg[0]) {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            return false;
+        } else {
+            options->inputs.emplace_back(arg);
+        }
+    }
+    return !options->inputs.empty();
+}
+
+// Directories are expanded in name order, so the output never depends on the file system iteration order
+static std::vector<std::string> collectFiles(const std::vector<std::string>& inputs)
+{
+    std::vector<std::string> files;
+    for (const auto& input : inputs) {
+        std::error_code errorCode;
+        if (!std::filesystem::is_directory(input, errorCode)) {
+            files.push_back(input);
+            continue;
+        }
+        std::vector<std::string> directoryFiles;
+        for (const auto& entry : std::filesystem::directory_iterator(input, errorCode)) {
+            if (entry.is_regular_file(errorCode) && ".ds3" == entry.path().extension())
+                directoryFiles.push_back(entry.path().string());
+        }
+        std::sort(directoryFiles.begin(), directoryFiles.end());
+        files.insert(files.end(), directoryFiles.begin(), directoryFiles.end());
+    }
+    return files;
+}
+
+static std::string outputPathOf(const Options& options, const std::string& path)
+{
+    return (std::filesystem::path(options.outputDirectory) / std::filesystem::path(path).stem()).string() + ".obj";
+}
+
+// Outputs are only named after the input file names, inputs sharing a name would overwrite each other's output,
+// names differing in case are also caught because they meet on case insensitive file systems
+static bool checkOutputCollisions(const Options& options, const std::vector<std::string>& files)
+{
+    bool isSuccessful = true;
+    std::unordered_map<std::string, std::string> outputToInputMap;
+    for (const auto& file : files) {
+        std::string outputPath = outputPathOf(options, file);
+        std::string outputKey = outputPath;
+        std::transform(outputKey.begin(), outputKey.end(), outputKey.begin(), [](unsigned char c) {
+            return (char)tolower(c);
+        });
+        auto insertResult = outputToInputMap.insert({ outputKey, file });
+        if (!insertResult.second) {
+            fprintf(stderr, "%s and %s would both be written to %s\n", insertResult.first->second.c_str(), file.c_str(), outputPath.c_str());
+            isSuccessful = false;
+        }
+    }
+    return isSuccessful;
+}
+
+// Cached meshes must come from the same build, the size and modification time of the executable change with
+// every rebuild, the compile time of this file is all that is left when the executable cannot be found
+static std::string executableBuildId(const char* argv0)
+{
+    std::error_code errorCode;
+    std::filesystem::path executablePath = std::filesystem::read_symlink("/proc/self/exe", errorCode);
+    if (errorCode) {
+        errorCode.clear();
+        executablePath = std::filesystem::absolute(argv0, errorCode);
+    }
+    if (!errorCode) {
+        auto size = std::filesystem::file_size(executablePath, errorCode);
+        if (!errorCode) {
+            auto time = std::filesystem::last_write_time(executablePath, errorCode);
+            if (!errorCode)
+                return std::to_string(size) + " " + std::to_string(time.time_since_epoch().count());
+        }
+    }
+    return __DATE__ " " __TIME__;
+}
+
+static std::unique_ptr<dust3d::Snapshot> loadSnapshot(const std::string& path)
+{
+    dust3d::Ds3FileReader ds3Reader(path);
+    for (const auto& item : ds3Reader.items()) {
+        if ("model" != item.type)
+            continue;
+        dust3d::Ds3ReaderItemView view = ds3Reader.itemView(item.name);
+        std::vector<char> data(view.data, view.data + view.size);
+        data.push_back('\0');
+        auto snapshot = std::make_unique<dust3d::Snapshot>();
+        dust3d::loadSnapshotFromXmlString(snapshot.get(), data.data());
+        return snapshot;
+    }
+    return nullptr;
+}
+
+static bool writeObj(const std::string& path, const dust3d::Object& object)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (nullptr == file)
+        return false;
+    fprintf(file, "# dust3d-cli\n");
+    for (const auto& vertex : object.vertices)
+        fprintf(file, "v %g %g %g\n", vertex.x(), vertex.y(), vertex.z());
+    for (const auto& face : object.triangleAndQuads) {
+        fprintf(file, "f");
+        for (const auto& index : face)
+            fprintf(file, " %zu", index + 1);
+        fprintf(file, "\n");
+    }
+    bool succeed = 0 == ferror(file);
+    return 0 == fclose(file) && succeed;
+}
+
+static void generate(const std::string& path, const Options& options, const dust3d::MeshDiskCache* diskCache, Result* result)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    result->path = path;
+
+    auto snapshot = loadSnapshot(path);
+    if (nullptr == snapshot) {
+        result->error = "no model found";
+        return;
+    }
+
+    dust3d::MeshGenerator meshGenerator(snapshot.release());
+    meshGenerator.setThreadCount(options.threadCount);
+    meshGenerator.setBalancedUnionEnabled(options.balancedUnion);
+    meshGenerator.setDiskCache(diskCache);
+    meshGenerator.generate();
+    result->isSuccessful = meshGenerator.isSuccessful();
+    std::unique_ptr<dust3d::Object> object(meshGenerator.takeObject());
+    if (nullptr == object) {
+        result->error = "generation failed";
+        return;
+    }
+    result->vertexCount = object->vertices.size();
+    result->faceCount = object->triangleAndQuads.size();
+
+    if (options.validate) {
+        dust3d::ThreadBudget threadBudget(options.threadCount);
+        result->validation = dust3d::validateMesh(object->vertices, object->triangles, true, &threadBudget);
+    }
+
+    if (!options.outputDirectory.empty()) {
+        std::string outputPath = outputPathOf(options, path);
+        if (!writeObj(outputPath, *object))
+            result->error = "failed to write " + outputPath;
+    }
+
+    result->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> files = collectFiles(options.inputs);
+    if (!options.outputDirectory.empty()) {
+        if (!checkOutputCollisions(options, files))
+            return 1;
+        std::error_code errorCode;
+        std::filesystem::create_directories(options.outputDirectory, errorCode);
+        if (errorCode) {
+            fprintf(stderr, "Failed to create %s: %s\n", options.outputDirectory.c_str(), errorCode.message().c_str());
+            return 1;
+        }
+    }
+    std::unique_ptr<dust3d::MeshDiskCache> diskCache;
+    if (!options.cacheDirectory.empty()) {
+        uint64_t cacheBytes = (uint64_t)options.cacheMegabytes * 1024 * 1024;
+        diskCache = std::make_unique<dust3d::MeshDiskCache>(options.cacheDirectory, executableBuildId(argv[0]));
+        diskCache->setMaxBytes(cacheBytes);
+        diskCache->trim(cacheBytes);
+    }
+
+    // Workers pull the next file as soon as they are done, files vary too much in cost to split them up front
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<Result> results(files.size());
+    std::atomic<size_t> nextFile = 0;
+    auto worker = [&]() {
+        for (size_t i = nextFile++; i < files.size(); i = nextFile++)
+            generate(files[i], options, diskCache.get(), &results[i]);
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < std::min(options.jobCount, files.size()); ++i)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& it : workers)
+        it.join();
+    double totalMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+    // Reported in input order once everything is done, whichever worker finished first
+    size_t failedCount = 0;
+    for (const auto& result : results) {
+        if (!result.error.empty()) {
+            ++failedCount;
+            printf("%10s  FAILED   %s: %s\n", "", result.path.c_str(), result.error.c_str());
+            continue;
+        }
+        printf("%10.1f ms  %-7s  %s  (%zu vertices, %zu faces)\n", result.milliseconds,
+            result.isSuccessful ? "ok" : "partial", result.path.c_str(), result.vertexCount, result.faceCount);
+        if (options.validate) {
+            const auto& validation = result.validation;
+            printf("%10s  %-7s  %zu boundary, %zu duplicated half-edges, %zu non-manifold vertices, %zu degenerate, %zu self-intersections\n", "",
+                validation.isWatertight() && validation.isManifold() && 0 == validation.selfIntersectionCount ? "valid" : "invalid",
+                validation.boundaryHalfEdgeCount, validation.duplicatedHalfEdgeCount, validation.nonManifoldVertexCount,
+                validation.degenerateFaceCount, validation.selfIntersectionCount);
+        }
+    }
+    printf("%zu files, %zu failed, %.1f ms\n", results.size(), failedCount, totalMilliseconds);
+
+    return 0 == failedCount ? 0 : 1;
+}
@@ -29,26 +29,26 @@ const size_t AxisAlignedBoudingBoxTree::m_leafMaxNodeSize = 20;
 AxisAlignedBoudingBoxTree::AxisAlignedBoudingBoxTree(const std::vector<AxisAlignedBoudingBox>* boxes,
     const std::vector<size_t>& boxIndices,
     const AxisAlignedBoudingBox& outterBox)
+    : m_boxes(boxes)
+    , m_boxIndices(boxIndices)
 {
-    m_boxes = boxes;
-
-    m_root = new Node;
-    m_root->boundingBox = outterBox;
-    m_root->boxIndices = boxIndices;
-
-    if (!boxIndices.empty()) {
-        for (const auto& boxIndex : boxIndices) {
-            m_root->center += (*boxes)[boxIndex].center();
+    Vector3 center;
+    if (!m_boxIndices.empty()) {
+        for (const auto& boxIndex : m_boxIndices) {
+            center += (*m_boxes)[boxIndex].center();
         }
-        m_root->center /= (float)boxIndices.size();
+        center /= (float)m_boxIndices.size();
     }
 
-    splitNode(m_root);
-}
+    Node root;
+    root.lowerBound = outterBox.lowerBound();
+    root.upperBound = outterBox.upperBound();
+    root.end = m_boxIndices.size();
+    m_nodes.reserve(m_boxIndices.size() / m_leafMaxNodeSize * 4 + 1);
+    m_nodes.push_back(root);
 
-const AxisAlignedBoudingBoxTree::Node* AxisAlignedBoudingBoxTree::root() const
-{
-    return m_root;
+    std::vector<size_t> boxIndicesOrderList(m_boxIndices.size() + m_boxIndices.size() + 2);
+    splitNode(0, center, boxIndicesOrderList);
 }
 
 const std::vector<AxisAlignedBoudingBox>* AxisAlignedBoudingBoxTree::boxes() const
@@ -56,50 +56,45 @@ const std::vector<AxisAlignedBoudingBox>* AxisAlignedBoudingBoxTree::boxes() con
     return m_boxes;
 }
 
-AxisAlignedBoudingBoxTree::~AxisAlignedBoudingBoxTree()
+const std::vector<AxisAlignedBoudingBoxTree::Node>& AxisAlignedBoudingBoxTree::nodes() const
 {
-    deleteNode(m_root);
+    return m_nodes;
 }
 
-void AxisAlignedBoudingBoxTree::deleteNode(Node* node)
+const std::vector<size_t>& AxisAlignedBoudingBoxTree::boxIndices() const
 {
-    if (nullptr == node)
-        return;
-    deleteNode(node->left);
-    deleteNode(node->right);
-    delete node;
+    return m_boxIndices;
 }
 
-void AxisAlignedBoudingBoxTree::splitNode(Node* node)
+void AxisAlignedBoudingBoxTree::splitNode(size_t nodeIndex, const Vector3& center, std::vector<size_t>& boxIndicesOrderList)
 {
-    const auto& boxIndices = node->boxIndices;
-    if (boxIndices.size() <= m_leafMaxNodeSize)
+    const size_t begin = m_nodes[nodeIndex].begin;
+    const size_t count = m_nodes[nodeIndex].size();
+    if (count <= m_leafMaxNodeSize)
         return;
-    const auto& splitBox = node->boundingBox;
-    const Vector3& lower = splitBox.lowerBound();
-    const Vector3& upper = splitBox.upperBound();
-    for (size_t i = 0; i < 3; ++i)
-        m_spans[i] = { i, upper[i] - lower[i] };
-    size_t longestAxis = std::max_element(m_spans.begin(), m_spans.end(), [](const std::pair<size_t, float>& first, const std::pair<size_t, float>& second) {
-        return first.second < second.second;
-    })->first;
-    auto splitPoint = node->center[longestAxis];
-    node->left = new Node;
-    node->right = new Node;
-    m_boxIndicesOrderList.resize(boxIndices.size() + boxIndices.size() + 2);
-    size_t leftOffset = boxIndices.size();
-    size_t rightOffset = boxIndices.size() - 1;
+    const Vector3& lower = m_nodes[nodeIndex].lowerBound;
+    const Vector3& upper = m_nodes[nodeIndex].upperBound;
+    size_t longestAxis = 0;
+    float longestSpan = upper[0] - lower[0];
+    for (size_t i = 1; i < 3; ++i) {
+        float span = upper[i] - lower[i];
+        if (longestSpan < span) {
+            longestSpan = span;
+            longestAxis = i;
+        }
+    }
+    auto splitPoint = center[longestAxis];
+    size_t leftOffset = count;
+    size_t rightOffset = count - 1;
     size_t leftCount = 0;
     size_t rightCount = 0;
-    for (size_t i = 0; i < boxIndices.size(); ++i) {
-        const auto& boxIndex = boxIndices[i];
-        const AxisAlignedBoudingBox& box = (*m_boxes)[boxIndex];
-        const auto& center = box.center()[longestAxis];
-        if (center < splitPoint) {
-            m_boxIndicesOrderList[--leftOffset] = boxIndex;
+    for (size_t i = begin; i < begin + count; ++i) {
+        const auto& boxIndex = m_boxIndices[i];
+        if ((*m_boxes)[boxIndex].center()[longestAxis] < splitPoint) {
+            boxIndicesOrderList[--leftOffset] = boxIndex;
             ++leftCount;
         } else {
-            m_boxIndicesOrderList[++rightOffset] = boxIndex;
+            boxIndicesOrderList[++rightOffset] = boxIndex;
             ++rightCount;
         }
     }
@@ -107,38 +102,77 @@ void AxisAlignedBoudingBoxTree::splitNode(Node* node)
     if (0 == leftCount) {
         leftCount = rightCount / 2;
         rightCount -= leftCount;
-        leftOffset = rightOffset - boxIndices.size() + 1;
+        leftOffset = rightOffset - count + 1;
     } else if (0 == rightCount) {
         rightCount = leftCount / 2;
         leftCount -= rightCount;
-        rightOffset = leftOffset + boxIndices.size() - 1;
     }
 
-    size_t middle = leftOffset + leftCount - 1;
-
-    for (size_t i = leftOffset; i <= middle; ++i) {
-        const auto& boxIndex = m_boxIndicesOrderList[i];
-        const AxisAlignedBoudingBox& box = (*m_boxes)[boxIndex];
-        node->left->boundingBox.update(box.lowerBound());
-        node->left->boundingBox.update(box.upperBound());
-        node->left->boxIndices.push_back(boxIndex);
-        node->left->center += box.center();
-    }
+    std::copy(boxIndicesOrderList.begin() + leftOffset,
+        boxIndicesOrderList.begin() + leftOffset + count,
+        m_boxIndices.begin() + begin);
+
+    auto makeChild = [&](size_t childBegin, size_t childEnd, Vector3* childCenter) {
+        AxisAlignedBoudingBox childBox;
+        for (size_t i = childBegin; i < childEnd; ++i) {
+            const AxisAlignedBoudingBox& box = (*m_boxes)[m_boxIndices[i]];
+            childBox.update(box.lowerBound());
+            childBox.update(box.upperBound());
+            *childCenter += box.center();
+        }
+        *childCenter /= (float)(childEnd - childBegin);
+        Node child;
+        child.lowerBound = childBox.lowerBound();
+        child.upperBound = childBox.upperBound();
+        child.begin = childBegin;
+        child.end = childEnd;
+        return child;
+    };
+
+    Vector3 leftCenter;
+    Node left = makeChild(begin, begin + leftCount, &leftCenter);
+    Vector3 rightCenter;
+    Node right = makeChild(begin + leftCount, begin + count, &rightCenter);
+
+    m_nodes.push_back(left);
+    splitNode(nodeIndex + 1, leftCenter, boxIndicesOrderList);
+
+    m_nodes[nodeIndex].right = m_nodes.size();
+    m_nodes.push_back(right);
+    splitNode(m_nodes[nodeIndex].right, rightCenter, boxIndicesOrderList);
+}
 
-    for (size_t i = middle + 1; i <= rightOffset; ++i) {
-        const auto& boxIndex = m_boxIndicesOrderList[i];
-        const AxisAlignedBoudingBox& box = (*m_boxes)[boxIndex];
-        node->right->boundingBox.update(box.lowerBound());
-        node->right->boundingBox.update(box.upperBound());
-        node->right->boxIndices.push_back(boxIndex);
-        node->right->center += box.center();
+void AxisAlignedBoudingBoxTree::test(const AxisAlignedBoudingBoxTree& other,
+    std::vector<std::pair<size_t, size_t>>* pairs) const
+{
+    const std::vector<AxisAlignedBoudingBox>& secondBoxes = *other.m_boxes;
+    std::vector<std::pair<size_t, size_t>> stack;
+    stack.reserve(64);
+    stack.push_back({ 0, 0 });
+    while (!stack.empty()) {
+        auto [firstIndex, secondIndex] = stack.back();
+        stack.pop_back();
+        const Node& first = m_nodes[firstIndex];
+        const Node& second = other.m_nodes[secondIndex];
+        if (!first.intersectWith(second))
+            continue;
+        if (first.isLeaf() && second.isLeaf()) {
+            for (size_t i = first.begin; i < first.end; ++i) {
+                const auto& a = m_boxIndices[i];
+                for (size_t j = second.begin; j < second.end; ++j) {
+                    const auto& b = other.m_boxIndices[j];
+                    if ((*m_boxes)[a].intersectWith(secondBoxes[b]))
+                        pairs->push_back(std::make_pair(a, b));
+                }
+            }
+        } else if (first.isLeaf() || (!second.isLeaf() && first.size() < second.size())) {
+            stack.push_back({ firstIndex, second.right });
+            stack.push_back({ firstIndex, secondIndex + 1 });
+        } else {
+            stack.push_back({ first.right, secondIndex });
+            stack.push_back({ firstIndex + 1, secondIndex });
+        }
     }
-
-    node->left->center /= (float)node->left->boxIndices.size();
-    splitNode(node->left);
-
-    node->right->center /= (float)node->right->boxIndices.size();
-    splitNode(node->right);
 }
 
 }
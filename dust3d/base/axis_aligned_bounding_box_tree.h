@@ -24,6 +24,8 @@
 #define DUST3D_BASE_AXIS_ALIGNED_BOUNDING_BOX_TREE_H_
 
 #include <dust3d/base/axis_aligned_bounding_box.h>
+#include <numeric>
+#include <tuple>
 #include <vector>
 
 namespace dust3d {
@@ -31,77 +33,113 @@ namespace dust3d {
 class AxisAlignedBoudingBoxTree {
 public:
     struct Node {
-        AxisAlignedBoudingBox boundingBox;
-        Vector3 center;
-        std::vector<size_t> boxIndices;
-        Node* left = nullptr;
-        Node* right = nullptr;
+        Vector3 lowerBound;
+        Vector3 upperBound;
+        size_t begin = 0;
+        size_t end = 0;
+        size_t right = 0;
 
         bool isLeaf() const
         {
-            return nullptr == left && nullptr == right;
-        };
+            return 0 == right;
+        }
+
+        size_t size() const
+        {
+            return end - begin;
+        }
+
+        bool intersectWith(const Node& other) const
+        {
+            for (size_t i = 0; i < 3; ++i) {
+                if (lowerBound[i] <= other.upperBound[i] && upperBound[i] >= other.lowerBound[i])
+                    continue;
+                return false;
+            }
+            return true;
+        }
     };
 
+    static bool intersectRayAndBox(const Vector3& rayOrigin, const Vector3& rayDirection,
+        const Vector3& lowerBound, const Vector3& upperBound)
+    {
+        double nearest = 0.0;
+        double farthest = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < 3; ++i) {
+            if (0.0 == rayDirection[i]) {
+                if (rayOrigin[i] < lowerBound[i] || rayOrigin[i] > upperBound[i])
+                    return false;
+                continue;
+            }
+            double enter = (lowerBound[i] - rayOrigin[i]) / rayDirection[i];
+            double leave = (upperBound[i] - rayOrigin[i]) / rayDirection[i];
+            if (enter > leave)
+                std::swap(enter, leave);
+            nearest = std::max(nearest, enter);
+            farthest = std::min(farthest, leave);
+            if (nearest > farthest)
+                return false;
+        }
+        return true;
+    }
+
     AxisAlignedBoudingBoxTree(const std::vector<AxisAlignedBoudingBox>* boxes,
         const std::vector<size_t>& boxIndices,
         const AxisAlignedBoudingBox& outterBox);
-    const Node* root() const;
     const std::vector<AxisAlignedBoudingBox>* boxes() const;
-    ~AxisAlignedBoudingBoxTree();
-    void splitNode(Node* node);
-    void deleteNode(Node* node);
-
-    void testNodes(const Node* first,
-        const Node* second,
-        const std::vector<AxisAlignedBoudingBox>* secondBoxes,
-        std::vector<std::pair<size_t, size_t>>* pairs) const
+    const std::vector<Node>& nodes() const;
+    const std::vector<size_t>& boxIndices() const;
+    void test(const AxisAlignedBoudingBoxTree& other,
+        std::vector<std::pair<size_t, size_t>>* pairs) const;
+
+    // All the rays share one direction and walk the tree together,
+    // each node is only tested against the rays which reached its parent.
+    template <typename Visitor>
+    void intersectRays(const std::vector<Vector3>& rayOrigins, const Vector3& rayDirection, Visitor&& visit) const
     {
-        if (first->boundingBox.intersectWith(second->boundingBox)) {
-            if (first->isLeaf()) {
-                if (second->isLeaf()) {
-                    for (const auto& a : first->boxIndices) {
-                        for (const auto& b : second->boxIndices) {
-                            if ((*m_boxes)[a].intersectWith((*secondBoxes)[b])) {
-                                pairs->push_back(std::make_pair(a, b));
-                            }
-                        }
-                    }
-                } else {
-                    testNodes(first, second->left, secondBoxes, pairs);
-                    testNodes(first, second->right, secondBoxes, pairs);
-                }
-            } else {
-                if (second->isLeaf()) {
-                    testNodes(first->left, second, secondBoxes, pairs);
-                    testNodes(first->right, second, secondBoxes, pairs);
-                } else {
-                    if (first->boxIndices.size() < second->boxIndices.size()) {
-                        testNodes(first, second->left, secondBoxes, pairs);
-                        testNodes(first, second->right, secondBoxes, pairs);
-                    } else {
-                        testNodes(first->left, second, secondBoxes, pairs);
-                        testNodes(first->right, second, secondBoxes, pairs);
+        std::vector<size_t> rays(rayOrigins.size());
+        std::iota(rays.begin(), rays.end(), 0);
+        std::vector<std::tuple<size_t, size_t, size_t>> stack;
+        stack.reserve(64);
+        stack.push_back({ 0, 0, rays.size() });
+        while (!stack.empty()) {
+            auto [nodeIndex, begin, end] = stack.back();
+            stack.pop_back();
+            rays.resize(end);
+            const Node& node = m_nodes[nodeIndex];
+            size_t hitBegin = rays.size();
+            for (size_t i = begin; i < end; ++i) {
+                size_t rayIndex = rays[i];
+                if (intersectRayAndBox(rayOrigins[rayIndex], rayDirection, node.lowerBound, node.upperBound))
+                    rays.push_back(rayIndex);
+            }
+            size_t hitEnd = rays.size();
+            if (hitBegin == hitEnd)
+                continue;
+            if (node.isLeaf()) {
+                for (size_t i = node.begin; i < node.end; ++i) {
+                    size_t boxIndex = m_boxIndices[i];
+                    const auto& box = (*m_boxes)[boxIndex];
+                    for (size_t j = hitBegin; j < hitEnd; ++j) {
+                        if (intersectRayAndBox(rayOrigins[rays[j]], rayDirection, box.lowerBound(), box.upperBound()))
+                            visit(rays[j], boxIndex);
                     }
                 }
+                continue;
             }
+            stack.push_back({ node.right, hitBegin, hitEnd });
+            stack.push_back({ nodeIndex + 1, hitBegin, hitEnd });
         }
     }
 
-    void test(const Node* first, const Node* second,
-        const std::vector<AxisAlignedBoudingBox>* secondBoxes,
-        std::vector<std::pair<size_t, size_t>>* pairs) const
-    {
-        testNodes(first, second, secondBoxes, pairs);
-    }
-
 private:
     const std::vector<AxisAlignedBoudingBox>* m_boxes = nullptr;
-    Node* m_root = nullptr;
-    std::vector<size_t> m_boxIndicesOrderList;
-    std::vector<std::pair<size_t, float>> m_spans = std::vector<std::pair<size_t, float>>(3);
+    std::vector<Node> m_nodes;
+    std::vector<size_t> m_boxIndices;
 
     static const size_t m_leafMaxNodeSize;
+
+    void splitNode(size_t nodeIndex, const Vector3& center, std::vector<size_t>& boxIndicesOrderList);
 };
 
 }
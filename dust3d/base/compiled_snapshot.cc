@@ -0,0 +1,234 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <dust3d/base/compiled_snapshot.h>
+#include <dust3d/base/string.h>
+
+namespace dust3d {
+
+static const std::string* findValue(const std::map<std::string, std::string>& attributes, const char* key)
+{
+    auto it = attributes.find(key);
+    if (it == attributes.end() || it->second.empty())
+        return nullptr;
+    return &it->second;
+}
+
+static float toFloat(const std::map<std::string, std::string>& attributes, const char* key, float defaultValue)
+{
+    const std::string* value = findValue(attributes, key);
+    return nullptr == value ? defaultValue : String::toFloat(*value);
+}
+
+static bool toBool(const std::map<std::string, std::string>& attributes, const char* key)
+{
+    const std::string* value = findValue(attributes, key);
+    return nullptr != value && String::isTrue(*value);
+}
+
+static std::string toString(const std::map<std::string, std::string>& attributes, const char* key)
+{
+    const std::string* value = findValue(attributes, key);
+    return nullptr == value ? std::string() : *value;
+}
+
+static void compileComponent(const std::map<std::string, std::string>& attributes, CompiledSnapshot::Component* component)
+{
+    component->dirty = toBool(attributes, "__dirty");
+    component->combineMode = CombineModeFromString(toString(attributes, "combineMode").c_str());
+    if (CombineMode::Normal == component->combineMode && toBool(attributes, "inverse"))
+        component->combineMode = CombineMode::Inversion;
+    component->linksToPart = "partId" == toString(attributes, "linkDataType");
+    if (component->linksToPart)
+        component->linkedPartIdString = toString(attributes, "linkData");
+}
+
+CompiledSnapshot::CompiledSnapshot(const Snapshot& snapshot)
+{
+    m_originX = toFloat(snapshot.canvas, "originX", 0.0);
+    m_originY = toFloat(snapshot.canvas, "originY", 0.0);
+    m_originZ = toFloat(snapshot.canvas, "originZ", 0.0);
+
+    m_parts.reserve(snapshot.parts.size());
+    m_partIndices.reserve(snapshot.parts.size());
+    for (const auto& it : snapshot.parts) {
+        const auto& attributes = it.second;
+        Part part;
+        part.id = Uuid(it.first);
+        part.idString = it.first;
+        part.target = PartTargetFromString(toString(attributes, "target").c_str());
+        part.disabled = toBool(attributes, "disabled");
+        part.dirty = toBool(attributes, "__dirty");
+        part.subdived = toBool(attributes, "subdived");
+        part.rounded = toBool(attributes, "rounded");
+        part.chamfered = toBool(attributes, "chamfered");
+        part.countershaded = toBool(attributes, "countershaded");
+        part.deformUnified = toBool(attributes, "deformUnified");
+        const std::string* colorString = findValue(attributes, "color");
+        if (nullptr != colorString) {
+            part.hasColor = true;
+            part.color = Color(*colorString);
+        }
+        part.deformThickness = toFloat(attributes, "deformThickness", 1.0);
+        part.deformWidth = toFloat(attributes, "deformWidth", 1.0);
+        part.cutRotation = toFloat(attributes, "cutRotation", 0.0);
+        part.hollowThickness = toFloat(attributes, "hollowThickness", 0.0);
+        part.smoothCutoffDegrees = toFloat(attributes, "smoothCutoffDegrees", 0.0);
+        part.colorSolubility = toFloat(attributes, "colorSolubility", 0.0);
+        part.metalness = toFloat(attributes, "metallic", 0.0);
+        part.roughness = toFloat(attributes, "roughness", 1.0);
+        const std::string* materialIdString = findValue(attributes, "materialId");
+        if (nullptr != materialIdString)
+            part.materialId = Uuid(*materialIdString);
+        part.cutFace = toString(attributes, "cutFace");
+        part.mirrorFromPartIdString = toString(attributes, "__mirrorFromPartId");
+        part.mirroredByPartIdString = toString(attributes, "__mirroredByPartId");
+        m_partIndices.insert({ it.first, m_parts.size() });
+        m_parts.emplace_back(std::move(part));
+    }
+
+    std::unordered_map<std::string, size_t> nodeIndices;
+    nodeIndices.reserve(snapshot.nodes.size());
+    m_nodes.reserve(snapshot.nodes.size());
+    for (const auto& it : snapshot.nodes) {
+        const auto& attributes = it.second;
+        Node node;
+        node.id = Uuid(it.first);
+        node.idString = it.first;
+        node.radius = toFloat(attributes, "radius", 0.0);
+        node.x = toFloat(attributes, "x", 0.0);
+        node.y = toFloat(attributes, "y", 0.0);
+        node.z = toFloat(attributes, "z", 0.0);
+        node.cutFace = toString(attributes, "cutFace");
+        auto findPart = m_partIndices.find(toString(attributes, "partId"));
+        if (findPart != m_partIndices.end())
+            m_parts[findPart->second].nodeIndices.push_back(m_nodes.size());
+        nodeIndices.insert({ it.first, m_nodes.size() });
+        m_nodes.emplace_back(std::move(node));
+    }
+
+    m_edges.reserve(snapshot.edges.size());
+    for (const auto& it : snapshot.edges) {
+        const auto& attributes = it.second;
+        Edge edge;
+        edge.id = Uuid(it.first);
+        edge.idString = it.first;
+        auto findFrom = nodeIndices.find(toString(attributes, "from"));
+        if (findFrom != nodeIndices.end())
+            edge.fromNodeIndex = findFrom->second;
+        auto findTo = nodeIndices.find(toString(attributes, "to"));
+        if (findTo != nodeIndices.end())
+            edge.toNodeIndex = findTo->second;
+        auto findPart = m_partIndices.find(toString(attributes, "partId"));
+        if (findPart != m_partIndices.end())
+            m_parts[findPart->second].edgeIndices.push_back(m_edges.size());
+        m_edges.emplace_back(std::move(edge));
+    }
+
+    m_components.reserve(snapshot.components.size() + 1);
+    m_componentIndices.reserve(snapshot.components.size() + 1);
+    Component rootComponent;
+    rootComponent.idString = to_string(rootComponent.id);
+    compileComponent(snapshot.rootComponent, &rootComponent);
+    m_componentIndices.insert({ rootComponent.idString, m_components.size() });
+    m_components.emplace_back(std::move(rootComponent));
+    for (const auto& it : snapshot.components) {
+        Component component;
+        component.id = Uuid(it.first);
+        component.idString = it.first;
+        compileComponent(it.second, &component);
+        m_componentIndices.insert({ it.first, m_components.size() });
+        m_components.emplace_back(std::move(component));
+    }
+
+    auto resolveChildren = [&](const std::map<std::string, std::string>& attributes, Component* component) {
+        for (const auto& childIdString : String::split(toString(attributes, "children"), ',')) {
+            if (childIdString.empty())
+                continue;
+            auto findChild = m_componentIndices.find(childIdString);
+            if (findChild == m_componentIndices.end())
+                continue;
+            component->childIndices.push_back(findChild->second);
+        }
+    };
+    resolveChildren(snapshot.rootComponent, &m_components[0]);
+    for (const auto& it : snapshot.components)
+        resolveChildren(it.second, &m_components[m_componentIndices[it.first]]);
+}
+
+float CompiledSnapshot::originX() const
+{
+    return m_originX;
+}
+
+float CompiledSnapshot::originY() const
+{
+    return m_originY;
+}
+
+float CompiledSnapshot::originZ() const
+{
+    return m_originZ;
+}
+
+const std::vector<CompiledSnapshot::Node>& CompiledSnapshot::nodes() const
+{
+    return m_nodes;
+}
+
+const std::vector<CompiledSnapshot::Edge>& CompiledSnapshot::edges() const
+{
+    return m_edges;
+}
+
+const std::vector<CompiledSnapshot::Part>& CompiledSnapshot::parts() const
+{
+    return m_parts;
+}
+
+const std::vector<CompiledSnapshot::Component>& CompiledSnapshot::components() const
+{
+    return m_components;
+}
+
+const CompiledSnapshot::Component& CompiledSnapshot::rootComponent() const
+{
+    return m_components[0];
+}
+
+const CompiledSnapshot::Part* CompiledSnapshot::findPart(const std::string& partIdString) const
+{
+    auto it = m_partIndices.find(partIdString);
+    if (it == m_partIndices.end())
+        return nullptr;
+    return &m_parts[it->second];
+}
+
+const CompiledSnapshot::Component* CompiledSnapshot::findComponent(const std::string& componentIdString) const
+{
+    auto it = m_componentIndices.find(componentIdString);
+    if (it == m_componentIndices.end())
+        return nullptr;
+    return &m_components[it->second];
+}
+
+}
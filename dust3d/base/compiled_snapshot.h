@@ -0,0 +1,126 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_BASE_COMPILED_SNAPSHOT_H_
+#define DUST3D_BASE_COMPILED_SNAPSHOT_H_
+
+#include <dust3d/base/color.h>
+#include <dust3d/base/combine_mode.h>
+#include <dust3d/base/part_target.h>
+#include <dust3d/base/snapshot.h>
+#include <dust3d/base/uuid.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dust3d {
+
+// Typed, index linked form of a Snapshot, built once before generation,
+// so the generator stops looking up and parsing attribute strings for every node and part.
+class CompiledSnapshot {
+public:
+    static constexpr size_t npos = (size_t)-1;
+
+    struct Node {
+        Uuid id;
+        std::string idString;
+        float radius = 0.0;
+        float x = 0.0;
+        float y = 0.0;
+        float z = 0.0;
+        std::string cutFace;
+    };
+
+    struct Edge {
+        Uuid id;
+        std::string idString;
+        size_t fromNodeIndex = npos;
+        size_t toNodeIndex = npos;
+    };
+
+    struct Part {
+        Uuid id;
+        std::string idString;
+        PartTarget target = PartTarget::Model;
+        bool disabled = false;
+        bool dirty = false;
+        bool subdived = false;
+        bool rounded = false;
+        bool chamfered = false;
+        bool countershaded = false;
+        bool deformUnified = false;
+        bool hasColor = false;
+        Color color;
+        float deformThickness = 1.0;
+        float deformWidth = 1.0;
+        float cutRotation = 0.0;
+        float hollowThickness = 0.0;
+        float smoothCutoffDegrees = 0.0;
+        float colorSolubility = 0.0;
+        float metalness = 0.0;
+        float roughness = 1.0;
+        Uuid materialId;
+        std::string cutFace;
+        std::string mirrorFromPartIdString;
+        std::string mirroredByPartIdString;
+        std::vector<size_t> nodeIndices;
+        std::vector<size_t> edgeIndices;
+    };
+
+    struct Component {
+        Uuid id;
+        std::string idString;
+        bool dirty = false;
+        CombineMode combineMode = CombineMode::Normal;
+        bool linksToPart = false;
+        std::string linkedPartIdString;
+        std::vector<size_t> childIndices;
+    };
+
+    CompiledSnapshot(const Snapshot& snapshot);
+
+    float originX() const;
+    float originY() const;
+    float originZ() const;
+    const std::vector<Node>& nodes() const;
+    const std::vector<Edge>& edges() const;
+    const std::vector<Part>& parts() const;
+    const std::vector<Component>& components() const;
+    const Component& rootComponent() const;
+    const Part* findPart(const std::string& partIdString) const;
+    const Component* findComponent(const std::string& componentIdString) const;
+
+private:
+    float m_originX = 0.0;
+    float m_originY = 0.0;
+    float m_originZ = 0.0;
+    std::vector<Node> m_nodes;
+    std::vector<Edge> m_edges;
+    std::vector<Part> m_parts;
+    std::vector<Component> m_components;
+    std::unordered_map<std::string, size_t> m_partIndices;
+    std::unordered_map<std::string, size_t> m_componentIndices;
+};
+
+}
+
+#endif
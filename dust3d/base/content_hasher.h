@@ -0,0 +1,81 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_BASE_CONTENT_HASHER_H_
+#define DUST3D_BASE_CONTENT_HASHER_H_
+
+#include <cstdint>
+#include <string>
+
+namespace dust3d {
+
+// Streaming 64 bit hash for content addressed caching, the exact bit patterns of the values are hashed,
+// so the result is only stable for the same build and platform. Not meant for anything adversarial.
+class ContentHasher {
+public:
+    void addBytes(const void* data, size_t size)
+    {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < size; ++i) {
+            m_state ^= bytes[i];
+            m_state *= 0x100000001b3ull;
+        }
+    }
+
+    void addInteger(uint64_t value)
+    {
+        addBytes(&value, sizeof(value));
+    }
+
+    void addDouble(double value)
+    {
+        // Both zeros compare equal, so they must hash equal too
+        if (0.0 == value)
+            value = 0.0;
+        addBytes(&value, sizeof(value));
+    }
+
+    void addString(const std::string& value)
+    {
+        addInteger(value.size());
+        addBytes(value.data(), value.size());
+    }
+
+    uint64_t result() const
+    {
+        uint64_t h = m_state;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        // Zero is kept for "no content hash"
+        return 0 == h ? 1 : h;
+    }
+
+private:
+    uint64_t m_state = 0xcbf29ce484222325ull;
+};
+
+}
+
+#endif
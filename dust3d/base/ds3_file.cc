@@ -24,9 +24,24 @@
 #include <dust3d/base/debug.h>
 #include <dust3d/base/ds3_file.h>
 #include <dust3d/base/string.h>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <rapidxml.hpp>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace dust3d {
 
@@ -48,6 +63,92 @@ std::string Ds3FileReader::readFirstLine(const std::uint8_t* data, size_t size)
 
 Ds3FileReader::Ds3FileReader(const std::uint8_t* fileData, size_t fileSize)
 {
+    m_fileContent = std::vector<std::uint8_t>(fileData, fileData + fileSize);
+    m_fileData = m_fileContent.data();
+    m_fileSize = m_fileContent.size();
+    parseHeader();
+}
+
+Ds3FileReader::Ds3FileReader(const std::string& filename)
+{
+    if (!mapFile(filename)) {
+        dust3dDebug << "Map file failed:" << filename;
+        return;
+    }
+    parseHeader();
+}
+
+Ds3FileReader::~Ds3FileReader()
+{
+    unmapFile();
+}
+
+bool Ds3FileReader::mapFile(const std::string& filename)
+{
+#ifdef _WIN32
+    int wideLength = MultiByteToWideChar(CP_UTF8, 0, filename.c_str(), -1, nullptr, 0);
+    if (wideLength <= 0)
+        return false;
+    std::vector<wchar_t> wideFilename(wideLength);
+    MultiByteToWideChar(CP_UTF8, 0, filename.c_str(), -1, wideFilename.data(), wideLength);
+    HANDLE file = CreateFileW(wideFilename.data(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (INVALID_HANDLE_VALUE == file)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || 0 == fileSize.QuadPart) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (nullptr == mapping)
+        return false;
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (nullptr == data) {
+        CloseHandle(mapping);
+        return false;
+    }
+    m_fileMapping = mapping;
+    m_mappedData = data;
+    m_fileSize = (size_t)fileSize.QuadPart;
+#else
+    int file = open(filename.c_str(), O_RDONLY);
+    if (-1 == file)
+        return false;
+    struct stat fileStat;
+    if (0 != fstat(file, &fileStat) || 0 == fileStat.st_size) {
+        close(file);
+        return false;
+    }
+    void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (MAP_FAILED == data)
+        return false;
+    m_mappedData = data;
+    m_fileSize = (size_t)fileStat.st_size;
+#endif
+    m_fileData = (const std::uint8_t*)m_mappedData;
+    return true;
+}
+
+void Ds3FileReader::unmapFile()
+{
+    if (nullptr == m_mappedData)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(m_mappedData);
+    CloseHandle((HANDLE)m_fileMapping);
+#else
+    munmap(m_mappedData, m_fileSize);
+#endif
+    m_mappedData = nullptr;
+    m_fileMapping = nullptr;
+}
+
+void Ds3FileReader::parseHeader()
+{
+    const std::uint8_t* fileData = m_fileData;
+    size_t fileSize = m_fileSize;
     m_headerIsGood = false;
     std::string firstLine = readFirstLine(fileData, fileSize);
     std::vector<std::string> tokens = String::split(firstLine, ' ');
@@ -83,8 +184,6 @@ Ds3FileReader::Ds3FileReader(const std::uint8_t* fileData, size_t fileSize)
         if (nullptr == rootNode)
             return;
         m_headerIsGood = true;
-        m_fileContent = std::vector<std::uint8_t>(fileSize);
-        std::memcpy(m_fileContent.data(), fileData, fileSize);
         for (rapidxml::xml_node<>* node = rootNode->first_node(); nullptr != node; node = node->next_sibling()) {
             Ds3ReaderItem readerItem;
             rapidxml::xml_attribute<>* attribute;
@@ -97,7 +196,7 @@ Ds3FileReader::Ds3FileReader(const std::uint8_t* fileData, size_t fileSize)
                 readerItem.size = std::stoull(attribute->value());
             if (readerItem.offset > (long long)fileSize)
                 continue;
-            if (readerItem.offset + readerItem.size > (long long)fileSize)
+            if (m_binaryOffset + readerItem.offset + readerItem.size > (long long)fileSize)
                 continue;
             m_items.push_back(readerItem);
             m_itemsMap[readerItem.name] = readerItem;
@@ -124,10 +223,23 @@ void Ds3FileReader::loadItem(const std::string& name, std::vector<std::uint8_t>*
     Ds3ReaderItem readerItem = m_itemsMap[name];
     byteArray->resize(readerItem.size, 0);
     std::memcpy((char*)byteArray->data(),
-        m_fileContent.data() + m_binaryOffset + readerItem.offset,
+        m_fileData + m_binaryOffset + readerItem.offset,
         byteArray->size());
 }
 
+Ds3ReaderItemView Ds3FileReader::itemView(const std::string& name) const
+{
+    Ds3ReaderItemView view;
+    if (!m_headerIsGood)
+        return view;
+    auto findItem = m_itemsMap.find(name);
+    if (findItem == m_itemsMap.end())
+        return view;
+    view.data = m_fileData + m_binaryOffset + findItem->second.offset;
+    view.size = (size_t)findItem->second.size;
+    return view;
+}
+
 const std::vector<Ds3ReaderItem>& Ds3FileReader::items() const
 {
     return m_items;
@@ -135,38 +247,62 @@ const std::vector<Ds3ReaderItem>& Ds3FileReader::items() const
 
 bool Ds3FileWriter::add(const std::string& name, const std::string& type, const void* buffer, size_t bufferSize)
 {
-    if (m_itemsMap.find(name) != m_itemsMap.end()) {
+    if (m_itemNames.find(name) != m_itemNames.end()) {
         return false;
     }
+    m_itemNames.insert(name);
     Ds3WriterItem writerItem;
     writerItem.type = type;
     writerItem.name = name;
-    writerItem.byteArray.resize(bufferSize);
-    for (size_t i = 0; i < bufferSize; ++i)
-        writerItem.byteArray[i] = ((const std::uint8_t*)buffer)[i];
-    m_itemsMap[name] = writerItem;
-    m_items.push_back(writerItem);
+    writerItem.byteArray.assign((const std::uint8_t*)buffer, (const std::uint8_t*)buffer + bufferSize);
+    writerItem.size = bufferSize;
+    m_items.emplace_back(std::move(writerItem));
     return true;
 }
 
-bool Ds3FileWriter::save(const std::string& filename)
+bool Ds3FileWriter::addReference(const std::string& name, const std::string& type, const void* buffer, size_t bufferSize)
 {
-    std::ofstream file(filename, std::ios::out | std::ios::trunc | std::ios::binary);
-    if (!file.is_open())
+    if (m_itemNames.find(name) != m_itemNames.end()) {
         return false;
+    }
+    m_itemNames.insert(name);
+    Ds3WriterItem writerItem;
+    writerItem.type = type;
+    writerItem.name = name;
+    writerItem.buffer = buffer;
+    writerItem.size = bufferSize;
+    m_items.emplace_back(std::move(writerItem));
+    return true;
+}
 
+bool Ds3FileWriter::addProducer(const std::string& name, const std::string& type, size_t size, Ds3WriterItem::Producer producer)
+{
+    if (m_itemNames.find(name) != m_itemNames.end()) {
+        return false;
+    }
+    m_itemNames.insert(name);
+    Ds3WriterItem writerItem;
+    writerItem.type = type;
+    writerItem.name = name;
+    writerItem.size = size;
+    writerItem.producer = std::move(producer);
+    m_items.emplace_back(std::move(writerItem));
+    return true;
+}
+
+bool Ds3FileWriter::writeItems(std::ofstream& file)
+{
     std::ostringstream headerXmlStream;
     headerXmlStream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << std::endl;
     headerXmlStream << "<ds3>" << std::endl;
     {
         long long offset = 0;
-        for (int i = 0; i < m_items.size(); i++) {
-            Ds3WriterItem* writerItem = &m_items[i];
-            headerXmlStream << "    <" << writerItem->type;
-            headerXmlStream << " name=\"" << String::doubleQuoteEscapedForXml(writerItem->name) << "\"";
+        for (const auto& writerItem : m_items) {
+            headerXmlStream << "    <" << writerItem.type;
+            headerXmlStream << " name=\"" << String::doubleQuoteEscapedForXml(writerItem.name) << "\"";
             headerXmlStream << " offset=\"" << std::to_string(offset) << "\"";
-            headerXmlStream << " size=\"" << std::to_string(writerItem->byteArray.size()) << "\"";
-            offset += writerItem->byteArray.size();
+            headerXmlStream << " size=\"" << std::to_string(writerItem.size) << "\"";
+            offset += writerItem.size;
             headerXmlStream << "/>" << std::endl;
         }
     }
@@ -183,12 +319,52 @@ bool Ds3FileWriter::save(const std::string& filename)
     file.write(firstLine, firstLineSizeExcludeSizeSelf);
     file.write(headerSizeString, strlen(headerSizeString));
     file << headerXml;
-    for (int i = 0; i < m_items.size(); i++) {
-        Ds3WriterItem* writerItem = &m_items[i];
-        file.write((char*)writerItem->byteArray.data(), writerItem->byteArray.size());
+    for (const auto& writerItem : m_items) {
+        if (writerItem.producer) {
+            size_t writtenSize = 0;
+            auto write = [&](const void* buffer, size_t bufferSize) {
+                if (writtenSize + bufferSize > writerItem.size)
+                    return false;
+                file.write((const char*)buffer, bufferSize);
+                writtenSize += bufferSize;
+                return file.good();
+            };
+            if (!writerItem.producer(write) || writtenSize != writerItem.size) {
+                dust3dDebug << "Item size mismatch:" << writerItem.name;
+                return false;
+            }
+        } else if (nullptr != writerItem.buffer) {
+            file.write((const char*)writerItem.buffer, writerItem.size);
+        } else {
+            file.write((const char*)writerItem.byteArray.data(), writerItem.byteArray.size());
+        }
+        if (!file.good())
+            return false;
     }
-
     return true;
 }
 
+bool Ds3FileWriter::save(const std::string& filename)
+{
+    // Write into a sibling temporary file and swap it in, so an interrupted save never leaves a truncated document
+    std::string temporaryFilename = filename + ".saving";
+    std::ofstream file(temporaryFilename, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    bool succeed = writeItems(file);
+    file.close();
+    succeed = succeed && !file.fail();
+
+    std::error_code errorCode;
+    if (succeed) {
+        std::filesystem::rename(temporaryFilename, filename, errorCode);
+        if (!errorCode)
+            return true;
+        dust3dDebug << "Rename failed:" << errorCode.message();
+    }
+    std::filesystem::remove(temporaryFilename, errorCode);
+    return false;
+}
+
 }
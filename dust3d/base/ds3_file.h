@@ -23,7 +23,11 @@
 #ifndef DUST3D_BASE_DS3_FILE_H_
 #define DUST3D_BASE_DS3_FILE_H_
 
+#include <cstdint>
+#include <fstream>
+#include <functional>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -37,10 +41,21 @@ public:
     long long size;
 };
 
+class Ds3ReaderItemView {
+public:
+    const std::uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
 class Ds3FileReader {
 public:
     Ds3FileReader(const std::uint8_t* fileData, size_t fileSize);
+    Ds3FileReader(const std::string& filename);
+    ~Ds3FileReader();
+    Ds3FileReader(const Ds3FileReader&) = delete;
+    Ds3FileReader& operator=(const Ds3FileReader&) = delete;
     void loadItem(const std::string& name, std::vector<std::uint8_t>* byteArray);
+    Ds3ReaderItemView itemView(const std::string& name) const;
     const std::vector<Ds3ReaderItem>& items() const;
     static std::string m_applicationName;
     static std::string m_fileFormatVersion;
@@ -50,29 +65,46 @@ private:
     std::map<std::string, Ds3ReaderItem> m_itemsMap;
     std::vector<Ds3ReaderItem> m_items;
     std::vector<std::uint8_t> m_fileContent;
+    const std::uint8_t* m_fileData = nullptr;
+    size_t m_fileSize = 0;
+    void* m_mappedData = nullptr;
+    void* m_fileMapping = nullptr;
 
 private:
     static std::string readFirstLine(const std::uint8_t* data, size_t size);
+    void parseHeader();
+    bool mapFile(const std::string& filename);
+    void unmapFile();
     bool m_headerIsGood = false;
     long long m_binaryOffset = 0;
 };
 
 class Ds3WriterItem {
 public:
+    typedef std::function<bool(const void* buffer, size_t bufferSize)> Sink;
+    typedef std::function<bool(const Sink& write)> Producer;
+
     std::string type;
     std::string name;
     std::vector<std::uint8_t> byteArray;
+    const void* buffer = nullptr;
+    size_t size = 0;
+    Producer producer;
 };
 
 class Ds3FileWriter {
 public:
     bool add(const std::string& name, const std::string& type, const void* buffer, size_t bufferSize);
+    bool addReference(const std::string& name, const std::string& type, const void* buffer, size_t bufferSize);
+    bool addProducer(const std::string& name, const std::string& type, size_t size, Ds3WriterItem::Producer producer);
     bool save(const std::string& filename);
 
 private:
-    std::map<std::string, Ds3WriterItem> m_itemsMap;
+    std::set<std::string> m_itemNames;
     std::vector<Ds3WriterItem> m_items;
     std::string m_filename;
+
+    bool writeItems(std::ofstream& file);
 };
 
 }
@@ -0,0 +1,225 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_BASE_INDEXED_MESH_H_
+#define DUST3D_BASE_INDEXED_MESH_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace dust3d {
+
+typedef std::array<uint32_t, 3> IndexedTriangle;
+typedef std::vector<IndexedTriangle> IndexedTriangles;
+
+// Faces of any size in one flat index buffer, face i spans indices [offsets[i], offsets[i + 1]).
+class IndexedPolygons {
+public:
+    template <typename Index>
+    class FaceView {
+    public:
+        FaceView(Index* begin, Index* end)
+            : m_begin(begin)
+            , m_end(end)
+        {
+        }
+
+        size_t size() const
+        {
+            return m_end - m_begin;
+        }
+
+        Index& operator[](size_t index) const
+        {
+            return m_begin[index];
+        }
+
+        Index* begin() const
+        {
+            return m_begin;
+        }
+
+        Index* end() const
+        {
+            return m_end;
+        }
+
+    private:
+        Index* m_begin = nullptr;
+        Index* m_end = nullptr;
+    };
+
+    typedef FaceView<uint32_t> Face;
+    typedef FaceView<const uint32_t> ConstFace;
+
+    class ConstIterator {
+    public:
+        ConstIterator(const IndexedPolygons* polygons, size_t index)
+            : m_polygons(polygons)
+            , m_index(index)
+        {
+        }
+
+        ConstFace operator*() const
+        {
+            return (*m_polygons)[m_index];
+        }
+
+        ConstIterator& operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+
+        bool operator!=(const ConstIterator& other) const
+        {
+            return m_index != other.m_index;
+        }
+
+    private:
+        const IndexedPolygons* m_polygons = nullptr;
+        size_t m_index = 0;
+    };
+
+    size_t size() const
+    {
+        return m_offsets.size() - 1;
+    }
+
+    bool empty() const
+    {
+        return 1 == m_offsets.size();
+    }
+
+    void clear()
+    {
+        m_indices.clear();
+        m_offsets.resize(1);
+    }
+
+    void reserve(size_t faceCount, size_t indexCount)
+    {
+        m_offsets.reserve(faceCount + 1);
+        m_indices.reserve(indexCount);
+    }
+
+    template <typename Container>
+    void push_back(const Container& face)
+    {
+        for (const auto& index : face)
+            m_indices.push_back((uint32_t)index);
+        m_offsets.push_back((uint32_t)m_indices.size());
+    }
+
+    template <typename Index>
+    void push_back(std::initializer_list<Index> face)
+    {
+        for (const auto& index : face)
+            m_indices.push_back((uint32_t)index);
+        m_offsets.push_back((uint32_t)m_indices.size());
+    }
+
+    Face operator[](size_t index)
+    {
+        return Face(m_indices.data() + m_offsets[index], m_indices.data() + m_offsets[index + 1]);
+    }
+
+    ConstFace operator[](size_t index) const
+    {
+        return ConstFace(m_indices.data() + m_offsets[index], m_indices.data() + m_offsets[index + 1]);
+    }
+
+    Face back()
+    {
+        return (*this)[size() - 1];
+    }
+
+    ConstIterator begin() const
+    {
+        return ConstIterator(this, 0);
+    }
+
+    ConstIterator end() const
+    {
+        return ConstIterator(this, size());
+    }
+
+    const std::vector<uint32_t>& indices() const
+    {
+        return m_indices;
+    }
+
+    const std::vector<uint32_t>& offsets() const
+    {
+        return m_offsets;
+    }
+
+    static IndexedPolygons fromFaces(const std::vector<std::vector<size_t>>& faces)
+    {
+        IndexedPolygons polygons;
+        size_t indexCount = 0;
+        for (const auto& face : faces)
+            indexCount += face.size();
+        polygons.reserve(faces.size(), indexCount);
+        for (const auto& face : faces)
+            polygons.push_back(face);
+        return polygons;
+    }
+
+    void toFaces(std::vector<std::vector<size_t>>* faces) const
+    {
+        faces->resize(size());
+        for (size_t i = 0; i < size(); ++i) {
+            auto face = (*this)[i];
+            (*faces)[i].assign(face.begin(), face.end());
+        }
+    }
+
+private:
+    std::vector<uint32_t> m_indices;
+    std::vector<uint32_t> m_offsets = { 0 };
+};
+
+inline void toFaces(const IndexedTriangles& triangles, std::vector<std::vector<size_t>>* faces)
+{
+    faces->resize(triangles.size());
+    for (size_t i = 0; i < triangles.size(); ++i)
+        (*faces)[i].assign(triangles[i].begin(), triangles[i].end());
+}
+
+inline void toIndexedTriangles(const std::vector<std::vector<size_t>>& triangles, IndexedTriangles* indexedTriangles)
+{
+    indexedTriangles->clear();
+    indexedTriangles->reserve(triangles.size());
+    for (const auto& triangle : triangles) {
+        if (triangle.size() < 3)
+            continue;
+        indexedTriangles->push_back({ (uint32_t)triangle[0], (uint32_t)triangle[1], (uint32_t)triangle[2] });
+    }
+}
+
+}
+
+#endif
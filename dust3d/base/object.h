@@ -27,6 +27,7 @@
 #include <dust3d/base/color.h>
 #include <dust3d/base/position_key.h>
 #include <dust3d/base/rectangle.h>
+#include <dust3d/base/spatial_hash_map.h>
 #include <dust3d/base/uuid.h>
 #include <dust3d/base/vector2.h>
 #include <dust3d/base/vector3.h>
@@ -58,12 +59,12 @@ struct ObjectNode {
 class Object {
 public:
     std::vector<Vector3> vertices;
-    std::map<PositionKey, Uuid> positionToNodeIdMap;
+    SpatialHashMap<PositionKey, Uuid> positionToNodeIdMap;
     std::map<Uuid, ObjectNode> nodeMap;
     std::vector<std::vector<size_t>> triangleAndQuads;
     std::vector<std::vector<size_t>> triangles;
-    std::unordered_map<Uuid, std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>>> partTriangleUvs;
-    std::vector<std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>>> seamTriangleUvs;
+    std::unordered_map<Uuid, SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>>> partTriangleUvs;
+    std::vector<SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>>> seamTriangleUvs;
     std::vector<Vector3> triangleNormals;
     std::vector<Color> vertexColors;
     std::vector<float> vertexSmoothCutoffDegrees;
@@ -38,6 +38,15 @@ PositionKey::PositionKey(double x, double y, double z)
     m_intZ = (long)(z * m_toIntFactor);
 }
 
+PositionKey PositionKey::fromIntegers(long intX, long intY, long intZ)
+{
+    PositionKey key;
+    key.m_intX = intX;
+    key.m_intY = intY;
+    key.m_intZ = intZ;
+    return key;
+}
+
 bool PositionKey::operator<(const PositionKey& right) const
 {
     if (m_intX < right.m_intX)
@@ -23,7 +23,9 @@
 #ifndef DUST3D_BASE_POSITION_KEY_H_
 #define DUST3D_BASE_POSITION_KEY_H_
 
+#include <cstdint>
 #include <dust3d/base/vector3.h>
+#include <functional>
 
 namespace dust3d {
 
@@ -31,10 +33,41 @@ class PositionKey {
 public:
     PositionKey(const Vector3& v);
     PositionKey(double x, double y, double z);
+    static PositionKey fromIntegers(long intX, long intY, long intZ);
     bool operator<(const PositionKey& right) const;
     bool operator==(const PositionKey& right) const;
 
+    size_t hash() const
+    {
+        uint64_t h = (uint64_t)m_intX * 0x9e3779b97f4a7c15ull;
+        h ^= (uint64_t)m_intY * 0xc2b2ae3d27d4eb4full;
+        h ^= (uint64_t)m_intZ * 0x165667b19e3779f9ull;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return (size_t)h;
+    }
+
+    long intX() const
+    {
+        return m_intX;
+    }
+
+    long intY() const
+    {
+        return m_intY;
+    }
+
+    long intZ() const
+    {
+        return m_intZ;
+    }
+
 private:
+    PositionKey() = default;
+
     long m_intX;
     long m_intY;
     long m_intZ;
@@ -44,4 +77,16 @@ private:
 
 }
 
+namespace std {
+
+template <>
+struct hash<dust3d::PositionKey> {
+    size_t operator()(const dust3d::PositionKey& key) const
+    {
+        return key.hash();
+    }
+};
+
+}
+
 #endif
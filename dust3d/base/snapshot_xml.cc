@@ -20,6 +20,7 @@
  *  SOFTWARE.
  */
 
+#include <dust3d/base/content_hasher.h>
 #include <dust3d/base/debug.h>
 #include <dust3d/base/snapshot_xml.h>
 #include <dust3d/base/string.h>
@@ -49,6 +50,23 @@ static std::string loadComponentReturnChildrenList(Snapshot* snapshot, rapidxml:
     return String::join(children, ",");
 }
 
+// Files from before components only list the parts, each part gets a component whose id is derived
+// from the part id, so loading the same file gives the same ids on any thread
+static std::string legacyComponentIdOfPart(const std::string& partId)
+{
+    ContentHasher highHasher;
+    highHasher.addString("legacyComponent");
+    highHasher.addString(partId);
+    uint64_t high = highHasher.result();
+    ContentHasher lowHasher = highHasher;
+    lowHasher.addInteger(high);
+    uint64_t low = lowHasher.result();
+    // Custom version 8, RFC 4122 variant
+    high = (high & ~uint64_t(0xf000)) | uint64_t(0x8000);
+    low = (low & ~(uint64_t(0xc) << 60)) | (uint64_t(0x8) << 60);
+    return to_string(Uuid(high, low));
+}
+
 void loadSnapshotFromXmlString(Snapshot* snapshot, char* xmlString)
 {
     try {
@@ -128,7 +146,7 @@ void loadSnapshotFromXmlString(Snapshot* snapshot, char* xmlString)
                 for (rapidxml::xml_node<>* partId = partIdList->first_node(); nullptr != partId; partId = partId->next_sibling()) {
                     rapidxml::xml_attribute<>* idAttribute = partId->first_attribute("id");
                     if (nullptr != idAttribute) {
-                        std::string componentId = to_string(Uuid::createUuid());
+                        std::string componentId = legacyComponentIdOfPart(idAttribute->value());
                         auto& component = snapshot->components[componentId];
                         component["id"] = componentId;
                         component["linkData"] = idAttribute->value();
@@ -0,0 +1,203 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_BASE_SPATIAL_HASH_MAP_H_
+#define DUST3D_BASE_SPATIAL_HASH_MAP_H_
+
+#include <array>
+#include <cstdint>
+#include <dust3d/base/position_key.h>
+#include <utility>
+#include <vector>
+
+namespace dust3d {
+
+struct PositionKeyHash {
+    size_t operator()(const PositionKey& key) const
+    {
+        return key.hash();
+    }
+
+    template <size_t N>
+    size_t operator()(const std::array<PositionKey, N>& keys) const
+    {
+        size_t h = 0;
+        for (const auto& key : keys)
+            h ^= key.hash() + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+// Open addressing map with linear probing, the slots only hold indices into a dense entry array,
+// so iteration follows insertion order and is as cheap as walking a vector.
+// Entries cannot be erased, which is all the position dedup maps in the mesh pipeline need.
+template <typename Key, typename Value, typename Hash = PositionKeyHash>
+class SpatialHashMap {
+public:
+    typedef std::pair<Key, Value> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+    size_t size() const
+    {
+        return m_entries.size();
+    }
+
+    bool empty() const
+    {
+        return m_entries.empty();
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+        m_slots.clear();
+    }
+
+    void reserve(size_t count)
+    {
+        m_entries.reserve(count);
+        if (count * 2 > m_slots.size())
+            rehash(count * 2);
+    }
+
+    iterator begin()
+    {
+        return m_entries.begin();
+    }
+
+    iterator end()
+    {
+        return m_entries.end();
+    }
+
+    const_iterator begin() const
+    {
+        return m_entries.begin();
+    }
+
+    const_iterator end() const
+    {
+        return m_entries.end();
+    }
+
+    iterator find(const Key& key)
+    {
+        size_t entryIndex = findEntry(key);
+        if (entryIndex >= m_entries.size())
+            return m_entries.end();
+        return m_entries.begin() + entryIndex;
+    }
+
+    const_iterator find(const Key& key) const
+    {
+        size_t entryIndex = findEntry(key);
+        if (entryIndex >= m_entries.size())
+            return m_entries.end();
+        return m_entries.begin() + entryIndex;
+    }
+
+    size_t count(const Key& key) const
+    {
+        return findEntry(key) < m_entries.size() ? 1 : 0;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        return insertEntry(value_type(value));
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        return insertEntry(std::move(value));
+    }
+
+    std::pair<iterator, bool> emplace(const value_type& value)
+    {
+        return insertEntry(value_type(value));
+    }
+
+    std::pair<iterator, bool> emplace(value_type&& value)
+    {
+        return insertEntry(std::move(value));
+    }
+
+    Value& operator[](const Key& key)
+    {
+        return insertEntry(value_type(key, Value())).first->second;
+    }
+
+private:
+    std::vector<value_type> m_entries;
+    std::vector<uint32_t> m_slots;
+
+    size_t findEntry(const Key& key) const
+    {
+        if (m_slots.empty())
+            return m_entries.size();
+        size_t mask = m_slots.size() - 1;
+        for (size_t slot = Hash()(key) & mask;; slot = (slot + 1) & mask) {
+            uint32_t entry = m_slots[slot];
+            if (0 == entry)
+                return m_entries.size();
+            if (m_entries[entry - 1].first == key)
+                return entry - 1;
+        }
+    }
+
+    std::pair<iterator, bool> insertEntry(value_type&& value)
+    {
+        if ((m_entries.size() + 1) * 2 > m_slots.size())
+            rehash((m_entries.size() + 1) * 2);
+        size_t mask = m_slots.size() - 1;
+        size_t slot = Hash()(value.first) & mask;
+        for (;; slot = (slot + 1) & mask) {
+            uint32_t entry = m_slots[slot];
+            if (0 == entry)
+                break;
+            if (m_entries[entry - 1].first == value.first)
+                return { m_entries.begin() + (entry - 1), false };
+        }
+        m_entries.emplace_back(std::move(value));
+        m_slots[slot] = (uint32_t)m_entries.size();
+        return { m_entries.end() - 1, true };
+    }
+
+    void rehash(size_t minimalSlotCount)
+    {
+        size_t slotCount = 16;
+        while (slotCount < minimalSlotCount)
+            slotCount <<= 1;
+        m_slots.assign(slotCount, 0);
+        size_t mask = slotCount - 1;
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            size_t slot = Hash()(m_entries[i].first) & mask;
+            while (0 != m_slots[slot])
+                slot = (slot + 1) & mask;
+            m_slots[slot] = (uint32_t)(i + 1);
+        }
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <algorithm>
+#include <dust3d/base/task_group.h>
+
+namespace dust3d {
+
+ThreadBudget::ThreadBudget(size_t threadCount)
+    : m_threadCount(std::max((size_t)1, threadCount))
+    , m_available(m_threadCount - 1)
+{
+}
+
+size_t ThreadBudget::threadCount() const
+{
+    return m_threadCount;
+}
+
+size_t ThreadBudget::hardwareThreadCount()
+{
+    return std::max((unsigned int)1, std::thread::hardware_concurrency());
+}
+
+size_t ThreadBudget::acquire(size_t wanted)
+{
+    size_t available = m_available.load();
+    for (;;) {
+        size_t granted = std::min(available, wanted);
+        if (0 == granted)
+            return 0;
+        if (m_available.compare_exchange_weak(available, available - granted))
+            return granted;
+    }
+}
+
+void ThreadBudget::release(size_t count)
+{
+    m_available += count;
+}
+
+TaskGroup::TaskGroup(ThreadBudget* threadBudget)
+    : m_threadBudget(threadBudget)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    wait();
+}
+
+void TaskGroup::run(std::function<void()>&& task)
+{
+    if (nullptr == m_threadBudget || 0 == m_threadBudget->acquire(1)) {
+        task();
+        return;
+    }
+    ThreadBudget* threadBudget = m_threadBudget;
+    m_threads.emplace_back([threadBudget, task = std::move(task)]() {
+        task();
+        threadBudget->release(1);
+    });
+}
+
+void TaskGroup::wait()
+{
+    for (auto& thread : m_threads)
+        thread.join();
+    m_threads.clear();
+}
+
+void parallelFor(ThreadBudget* threadBudget, size_t count,
+    const std::function<void(size_t begin, size_t end)>& task, size_t minimalChunkSize)
+{
+    if (0 == count)
+        return;
+    size_t maxChunkCount = (count + minimalChunkSize - 1) / std::max((size_t)1, minimalChunkSize);
+    size_t extraThreadCount = 0;
+    if (nullptr != threadBudget && maxChunkCount > 1)
+        extraThreadCount = threadBudget->acquire(maxChunkCount - 1);
+    if (0 == extraThreadCount) {
+        task(0, count);
+        return;
+    }
+    size_t chunkCount = extraThreadCount + 1;
+    size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    std::vector<std::thread> threads;
+    threads.reserve(extraThreadCount);
+    for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+        size_t begin = chunk * chunkSize;
+        size_t end = std::min(count, begin + chunkSize);
+        if (begin >= end)
+            break;
+        threads.emplace_back([&task, begin, end]() {
+            task(begin, end);
+        });
+    }
+    task(0, std::min(count, chunkSize));
+    for (auto& thread : threads)
+        thread.join();
+    threadBudget->release(extraThreadCount);
+}
+
+}
@@ -0,0 +1,67 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_BASE_TASK_GROUP_H_
+#define DUST3D_BASE_TASK_GROUP_H_
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace dust3d {
+
+// Shared limit of how many threads may work at the same time, the calling thread included.
+// Nested task groups and parallel loops draw from the same budget, so recursion never oversubscribes.
+class ThreadBudget {
+public:
+    ThreadBudget(size_t threadCount);
+    size_t acquire(size_t wanted);
+    void release(size_t count);
+    size_t threadCount() const;
+
+    static size_t hardwareThreadCount();
+
+private:
+    size_t m_threadCount = 1;
+    std::atomic<size_t> m_available;
+};
+
+// Runs each task on an extra thread while the budget allows it, otherwise inline on the caller.
+class TaskGroup {
+public:
+    TaskGroup(ThreadBudget* threadBudget);
+    ~TaskGroup();
+    void run(std::function<void()>&& task);
+    void wait();
+
+private:
+    ThreadBudget* m_threadBudget = nullptr;
+    std::vector<std::thread> m_threads;
+};
+
+void parallelFor(ThreadBudget* threadBudget, size_t count,
+    const std::function<void(size_t begin, size_t end)>& task, size_t minimalChunkSize = 1);
+
+}
+
+#endif
@@ -26,4 +26,9 @@ namespace dust3d {
 
 Uuid::RandomGenerator* Uuid::m_generator = new Uuid::RandomGenerator;
 
+static_assert(sizeof(Uuid) == 16);
+static_assert(Uuid("{01234567-89ab-cdef-0123-456789ABCDEF}") == Uuid(0x0123456789abcdefULL, 0x0123456789abcdefULL));
+static_assert(Uuid("01234567-89ab-cdef-0123-456789abcdef").toChars()[36] == 'f');
+static_assert(Uuid("{01234567-89ab-cdef-0123-456789abcdeg}").isNull());
+
 } // namespace dust3d
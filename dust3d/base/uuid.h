@@ -23,10 +23,13 @@
 #ifndef DUST3D_BASE_UUID_H_
 #define DUST3D_BASE_UUID_H_
 
+#include <array>
 #include <chrono>
-#include <ctime>
+#include <cstdint>
+#include <functional>
 #include <random>
-#include <sstream>
+#include <string>
+#include <string_view>
 
 namespace dust3d {
 
@@ -36,122 +39,161 @@ public:
     public:
         RandomGenerator()
             : m_randomGenerator(m_randomDevice() + std::chrono::time_point_cast<std::chrono::seconds>(std::chrono::system_clock::now()).time_since_epoch().count())
-            , m_randomDistribution(0, 15)
         {
         }
 
-        int generate()
+        uint64_t generate()
         {
-            return m_randomDistribution(m_randomGenerator);
+            return m_randomGenerator();
         }
 
     private:
         std::random_device m_randomDevice;
-        std::mt19937 m_randomGenerator;
-        std::uniform_int_distribution<int> m_randomDistribution;
+        std::mt19937_64 m_randomGenerator;
     };
 
     static RandomGenerator* m_generator;
 
-    Uuid() = default;
+    constexpr Uuid() = default;
 
-    Uuid(const std::string& string)
+    constexpr Uuid(uint64_t high, uint64_t low)
+        : m_high(high)
+        , m_low(low)
+    {
+    }
+
+    constexpr Uuid(std::string_view string)
     {
-        if (sizeof("{hhhhhhhh-hhhh-hhhh-hhhh-hhhhhhhhhhhh}") - 1 == string.length() && '{' == string[0] && validate(&string[1], string.length() - 2)) {
-            m_uuid = string.substr(1, string.length() - 2);
+        if (sizeof("{hhhhhhhh-hhhh-hhhh-hhhh-hhhhhhhhhhhh}") - 1 == string.length() && '{' == string.front() && '}' == string.back())
+            string = string.substr(1, string.length() - 2);
+        if (!validate(string.data(), string.length()))
             return;
+        uint64_t values[2] = { 0, 0 };
+        size_t digitCount = 0;
+        for (char c : string) {
+            if ('-' == c)
+                continue;
+            values[digitCount / 16] = (values[digitCount / 16] << 4) | hexValue(c);
+            ++digitCount;
         }
-        if (sizeof("hhhhhhhh-hhhh-hhhh-hhhh-hhhhhhhhhhhh") - 1 == string.length() && validate(&string[0], string.length())) {
-            m_uuid = string;
-            return;
+        m_high = values[0];
+        m_low = values[1];
+    }
+
+    constexpr Uuid(const char* string)
+        : Uuid(std::string_view(string))
+    {
+    }
+
+    Uuid(const std::string& string)
+        : Uuid(std::string_view(string))
+    {
+    }
+
+    static constexpr bool validate(const char* string, size_t length)
+    {
+        if (sizeof("hhhhhhhh-hhhh-hhhh-hhhh-hhhhhhhhhhhh") - 1 != length)
+            return false;
+        for (size_t i = 0; i < length; ++i) {
+            if (8 == i || 13 == i || 18 == i || 23 == i) {
+                if ('-' != string[i])
+                    return false;
+            } else if (hexValue(string[i]) < 0) {
+                return false;
+            }
         }
+        return true;
+    }
+
+    constexpr bool isNull() const
+    {
+        return 0 == m_high && 0 == m_low;
+    }
+
+    constexpr uint64_t high() const
+    {
+        return m_high;
     }
 
-    static bool validate(const char* string, size_t length)
+    constexpr uint64_t low() const
     {
-        return length >= 24 && '-' == string[8] && '-' == string[13] && '-' == string[18] && '-' == string[23];
+        return m_low;
     }
 
-    bool isNull() const
+    // Always emits all 32 digits; toString() keeps "{}" for the null uuid
+    constexpr std::array<char, 38> toChars() const
     {
-        return m_uuid.empty();
+        constexpr char digits[] = "0123456789abcdef";
+        std::array<char, 38> chars = {};
+        chars[0] = '{';
+        chars[37] = '}';
+        size_t position = 1;
+        for (size_t i = 0; i < 32; ++i) {
+            if (8 == i || 12 == i || 16 == i || 20 == i)
+                chars[position++] = '-';
+            uint64_t value = i < 16 ? m_high : m_low;
+            chars[position++] = digits[(value >> ((15 - (i % 16)) * 4)) & 0xf];
+        }
+        return chars;
     }
 
     std::string toString() const
     {
-        return "{" + m_uuid + "}";
+        if (isNull())
+            return "{}";
+        auto chars = toChars();
+        return std::string(chars.data(), chars.size());
     }
 
     static Uuid createUuid()
     {
-        std::ostringstream ss;
-        ss << std::hex;
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << "-";
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << "-";
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << "-";
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << "-";
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        ss << m_generator->generate();
-        return Uuid(ss.str());
+        uint64_t high = m_generator->generate();
+        uint64_t low = m_generator->generate();
+        // Random version 4, RFC 4122 variant
+        high = (high & ~uint64_t(0xf000)) | uint64_t(0x4000);
+        low = (low & ~(uint64_t(0xc) << 60)) | (uint64_t(0x8) << 60);
+        return Uuid(high, low);
     }
 
 private:
-    friend std::string to_string(const Uuid& uuid);
-    friend struct std::hash<Uuid>;
-    friend bool operator==(const Uuid& lhs, const Uuid& rhs);
-    friend bool operator!=(const Uuid& lhs, const Uuid& rhs);
-    friend bool operator<(const Uuid& lhs, const Uuid& rhs);
-    std::string m_uuid;
+    friend constexpr bool operator==(const Uuid& lhs, const Uuid& rhs);
+    friend constexpr bool operator!=(const Uuid& lhs, const Uuid& rhs);
+    friend constexpr bool operator<(const Uuid& lhs, const Uuid& rhs);
+    uint64_t m_high = 0;
+    uint64_t m_low = 0;
+
+    static constexpr int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
 };
 
 inline std::string to_string(const Uuid& uuid)
 {
-    return "{" + uuid.m_uuid + "}";
+    return uuid.toString();
 }
 
-inline bool operator==(const Uuid& lhs, const Uuid& rhs)
+constexpr bool operator==(const Uuid& lhs, const Uuid& rhs)
 {
-    return lhs.m_uuid == rhs.m_uuid;
+    return lhs.m_high == rhs.m_high && lhs.m_low == rhs.m_low;
 }
 
-inline bool operator!=(const Uuid& lhs, const Uuid& rhs)
+constexpr bool operator!=(const Uuid& lhs, const Uuid& rhs)
 {
-    return lhs.m_uuid != rhs.m_uuid;
+    return !(lhs == rhs);
 }
 
-inline bool operator<(const Uuid& lhs, const Uuid& rhs)
+constexpr bool operator<(const Uuid& lhs, const Uuid& rhs)
 {
-    return lhs.m_uuid < rhs.m_uuid;
+    if (lhs.m_high != rhs.m_high)
+        return lhs.m_high < rhs.m_high;
+    return lhs.m_low < rhs.m_low;
 }
 
 }
@@ -162,7 +204,11 @@ template <>
 struct hash<dust3d::Uuid> {
     size_t operator()(const dust3d::Uuid& uuid) const
     {
-        return std::hash<std::string>()(uuid.m_uuid);
+        uint64_t value = uuid.high() ^ (uuid.low() * 0x9e3779b97f4a7c15ULL);
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdULL;
+        value ^= value >> 33;
+        return (size_t)value;
     }
 };
 
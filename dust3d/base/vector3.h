@@ -304,6 +304,33 @@ public:
         return true;
     }
 
+    inline static bool intersectRayAndTriangle(const Vector3& rayOrigin, const Vector3& rayDirection,
+        const Vector3& a, const Vector3& b, const Vector3& c,
+        double* distance)
+    {
+        auto edge1 = b - a;
+        auto edge2 = c - a;
+        auto p = Vector3::crossProduct(rayDirection, edge2);
+        auto determinant = Vector3::dotProduct(edge1, p);
+        if (0.0 == determinant || std::isnan(determinant))
+            return false;
+        auto inverseDeterminant = 1.0 / determinant;
+        auto s = rayOrigin - a;
+        auto u = Vector3::dotProduct(s, p) * inverseDeterminant;
+        if (u <= 0.0 || u >= 1.0)
+            return false;
+        auto q = Vector3::crossProduct(s, edge1);
+        auto v = Vector3::dotProduct(rayDirection, q) * inverseDeterminant;
+        if (v <= 0.0 || u + v >= 1.0)
+            return false;
+        auto t = Vector3::dotProduct(edge2, q) * inverseDeterminant;
+        if (t < 0.0 || std::isinf(t))
+            return false;
+        if (nullptr != distance)
+            *distance = t;
+        return true;
+    }
+
     inline static Vector3 projectPointOnLine(const Vector3& point, const Vector3& linePointA, const Vector3& linePointB)
     {
         auto aToPoint = point - linePointA;
@@ -0,0 +1,63 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_MESH_HALF_EDGE_MAP_H_
+#define DUST3D_MESH_HALF_EDGE_MAP_H_
+
+#include <cstdint>
+#include <dust3d/base/spatial_hash_map.h>
+
+namespace dust3d {
+
+// Directed edge from the first to the second vertex index, packed into one key
+inline uint64_t makeHalfEdgeKey(size_t first, size_t second)
+{
+    return ((uint64_t)first << 32) | (uint32_t)second;
+}
+
+inline size_t halfEdgeKeyFirst(uint64_t key)
+{
+    return (size_t)(key >> 32);
+}
+
+inline size_t halfEdgeKeySecond(uint64_t key)
+{
+    return (size_t)(key & 0xffffffffull);
+}
+
+// Consecutive indices make consecutive keys, mix them before they are masked into slots
+struct HalfEdgeKeyHash {
+    size_t operator()(uint64_t key) const
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        return (size_t)key;
+    }
+};
+
+template <typename Value>
+using HalfEdgeMap = SpatialHashMap<uint64_t, Value, HalfEdgeKeyHash>;
+
+}
+
+#endif
@@ -21,6 +21,7 @@
  */
 
 #include <dust3d/base/position_key.h>
+#include <dust3d/base/spatial_hash_map.h>
 #include <dust3d/mesh/mesh_combiner.h>
 #include <dust3d/mesh/solid_mesh_boolean_operation.h>
 #include <dust3d/mesh/triangulate.h>
@@ -29,57 +30,88 @@ namespace dust3d {
 
 MeshCombiner::Mesh::Mesh(const std::vector<Vector3>& vertices, const std::vector<std::vector<size_t>>& faces)
 {
-    m_vertices = std::make_unique<std::vector<Vector3>>(vertices);
-    m_triangles = std::make_unique<std::vector<std::vector<size_t>>>();
-    triangulate(vertices, faces, m_triangles.get());
-    m_solidMesh = std::make_unique<SolidMesh>();
-    m_solidMesh->setVertices(m_vertices.get());
-    m_solidMesh->setTriangles(m_triangles.get());
-    m_solidMesh->prepare();
+    IndexedTriangles triangles;
+    triangulate(vertices, faces, &triangles);
+    prepare(std::vector<Vector3>(vertices), std::move(triangles));
 }
 
-MeshCombiner::Mesh::Mesh(const Mesh& other)
+MeshCombiner::Mesh::Mesh(const std::vector<Vector3>& vertices, const IndexedPolygons& faces)
 {
-    m_vertices = std::make_unique<std::vector<Vector3>>();
-    m_triangles = std::make_unique<std::vector<std::vector<size_t>>>();
-    other.fetch(*m_vertices, *m_triangles);
-    m_solidMesh = std::make_unique<SolidMesh>();
-    m_solidMesh->setVertices(m_vertices.get());
-    m_solidMesh->setTriangles(m_triangles.get());
-    m_solidMesh->prepare();
+    IndexedTriangles triangles;
+    triangulate(vertices, faces, &triangles);
+    prepare(std::vector<Vector3>(vertices), std::move(triangles));
+}
+
+MeshCombiner::Mesh::Mesh(std::vector<Vector3>&& vertices, IndexedTriangles&& triangles)
+{
+    prepare(std::move(vertices), std::move(triangles));
 }
 
 MeshCombiner::Mesh::~Mesh()
 {
 }
 
+void MeshCombiner::Mesh::prepare(std::vector<Vector3>&& vertices, IndexedTriangles&& triangles)
+{
+    auto geometry = std::make_shared<Geometry>();
+    geometry->vertices = std::move(vertices);
+    geometry->triangles = std::move(triangles);
+    geometry->solidMesh.setVertices(&geometry->vertices);
+    geometry->solidMesh.setTriangles(&geometry->triangles);
+    geometry->solidMesh.prepare();
+    m_geometry = std::move(geometry);
+}
+
+std::unique_ptr<MeshCombiner::Mesh> MeshCombiner::Mesh::share() const
+{
+    auto mesh = std::make_unique<Mesh>();
+    mesh->m_geometry = m_geometry;
+    return mesh;
+}
+
+bool MeshCombiner::Mesh::sharesGeometryWith(const Mesh& other) const
+{
+    return nullptr != m_geometry && m_geometry == other.m_geometry;
+}
+
 void MeshCombiner::Mesh::fetch(std::vector<Vector3>& vertices, std::vector<std::vector<size_t>>& faces) const
 {
-    if (nullptr != m_vertices)
-        vertices = *m_vertices;
+    if (nullptr == m_geometry)
+        return;
+
+    vertices = m_geometry->vertices;
+    toFaces(m_geometry->triangles, &faces);
+}
+
+void MeshCombiner::Mesh::fetch(std::vector<Vector3>& vertices, IndexedTriangles& triangles) const
+{
+    if (nullptr == m_geometry)
+        return;
 
-    if (nullptr != m_triangles)
-        faces = *m_triangles;
+    vertices = m_geometry->vertices;
+    triangles = m_geometry->triangles;
 }
 
 bool MeshCombiner::Mesh::isNull() const
 {
-    return nullptr == m_vertices || m_vertices->empty();
+    return nullptr == m_geometry || m_geometry->vertices.empty();
 }
 
 MeshCombiner::Mesh* MeshCombiner::combine(const Mesh& firstMesh, const Mesh& secondMesh, Method method,
-    std::vector<std::pair<Source, size_t>>* combinedVerticesComeFrom)
+    std::vector<std::pair<Source, size_t>>* combinedVerticesComeFrom,
+    ThreadBudget* threadBudget)
 {
     if (firstMesh.isNull() || secondMesh.isNull())
         return nullptr;
 
-    SolidMeshBooleanOperation booleanOperation(firstMesh.m_solidMesh.get(), secondMesh.m_solidMesh.get());
+    SolidMeshBooleanOperation booleanOperation(&firstMesh.m_geometry->solidMesh, &secondMesh.m_geometry->solidMesh);
+    booleanOperation.setThreadBudget(threadBudget);
     if (!booleanOperation.combine())
         return nullptr;
 
-    std::map<PositionKey, std::pair<Source, size_t>> verticesSourceMap;
+    SpatialHashMap<PositionKey, std::pair<Source, size_t>> verticesSourceMap;
 
-    auto addToSourceMap = [&](SolidMesh* solidMesh, Source source) {
+    auto addToSourceMap = [&](const SolidMesh* solidMesh, Source source) {
         size_t vertexIndex = 0;
         const std::vector<Vector3>* vertices = solidMesh->vertices();
         if (nullptr == vertices)
@@ -91,11 +123,11 @@ MeshCombiner::Mesh* MeshCombiner::combine(const Mesh& firstMesh, const Mesh& sec
         }
     };
     if (nullptr != combinedVerticesComeFrom) {
-        addToSourceMap(firstMesh.m_solidMesh.get(), Source::First);
-        addToSourceMap(secondMesh.m_solidMesh.get(), Source::Second);
+        addToSourceMap(&firstMesh.m_geometry->solidMesh, Source::First);
+        addToSourceMap(&secondMesh.m_geometry->solidMesh, Source::Second);
     }
 
-    std::vector<std::vector<size_t>> resultTriangles;
+    IndexedTriangles resultTriangles;
     if (Method::Union == method) {
         booleanOperation.fetchUnion(resultTriangles);
     } else if (Method::Diff == method) {
@@ -117,7 +149,7 @@ MeshCombiner::Mesh* MeshCombiner::combine(const Mesh& firstMesh, const Mesh& sec
         }
     }
 
-    return new Mesh(resultVertices, resultTriangles);
+    return new Mesh(std::vector<Vector3>(resultVertices), std::move(resultTriangles));
 }
 
 }
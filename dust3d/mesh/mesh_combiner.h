@@ -23,6 +23,8 @@
 #ifndef DUST3D_MESH_MESH_COMBINER_H_
 #define DUST3D_MESH_MESH_COMBINER_H_
 
+#include <dust3d/base/indexed_mesh.h>
+#include <dust3d/base/task_group.h>
 #include <dust3d/base/vector3.h>
 #include <dust3d/mesh/solid_mesh.h>
 #include <memory>
@@ -47,21 +49,37 @@ public:
     public:
         Mesh() = default;
         Mesh(const std::vector<Vector3>& vertices, const std::vector<std::vector<size_t>>& faces);
-        Mesh(const Mesh& other);
+        Mesh(const std::vector<Vector3>& vertices, const IndexedPolygons& faces);
+        Mesh(std::vector<Vector3>&& vertices, IndexedTriangles&& triangles);
+        Mesh(Mesh&& other) = default;
+        Mesh(const Mesh& other) = delete;
         ~Mesh();
+        Mesh& operator=(Mesh&& other) = default;
+        Mesh& operator=(const Mesh& other) = delete;
+        std::unique_ptr<Mesh> share() const;
+        bool sharesGeometryWith(const Mesh& other) const;
         void fetch(std::vector<Vector3>& vertices, std::vector<std::vector<size_t>>& faces) const;
+        void fetch(std::vector<Vector3>& vertices, IndexedTriangles& triangles) const;
         bool isNull() const;
 
         friend MeshCombiner;
 
     private:
-        std::unique_ptr<SolidMesh> m_solidMesh;
-        std::unique_ptr<std::vector<Vector3>> m_vertices;
-        std::unique_ptr<std::vector<std::vector<size_t>>> m_triangles;
+        // Never changed once prepared, so every mesh sharing it reads it without copying or locking
+        struct Geometry {
+            std::vector<Vector3> vertices;
+            IndexedTriangles triangles;
+            SolidMesh solidMesh;
+        };
+
+        std::shared_ptr<const Geometry> m_geometry;
+
+        void prepare(std::vector<Vector3>&& vertices, IndexedTriangles&& triangles);
     };
 
     static Mesh* combine(const Mesh& firstMesh, const Mesh& secondMesh, Method method,
-        std::vector<std::pair<Source, size_t>>* combinedVerticesComeFrom = nullptr);
+        std::vector<std::pair<Source, size_t>>* combinedVerticesComeFrom = nullptr,
+        ThreadBudget* threadBudget = nullptr);
 };
 
 }
@@ -0,0 +1,494 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <dust3d/base/content_hasher.h>
+#include <dust3d/base/debug.h>
+#include <dust3d/mesh/mesh_disk_cache.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace dust3d {
+
+// Entries are written in native byte order, the version has to be bumped whenever the layout changes
+static const char g_entryMagic[4] = { 'D', '3', 'M', 'C' };
+static const uint32_t g_entryVersion = 1;
+
+namespace {
+
+    class ByteWriter {
+    public:
+        ByteWriter(std::vector<uint8_t>* bytes)
+            : m_bytes(bytes)
+        {
+        }
+
+        template <typename T>
+        void write(const T& value)
+        {
+            size_t offset = m_bytes->size();
+            m_bytes->resize(offset + sizeof(T));
+            std::memcpy(m_bytes->data() + offset, &value, sizeof(T));
+        }
+
+        void writeVector3(const Vector3& v)
+        {
+            write(v.x());
+            write(v.y());
+            write(v.z());
+        }
+
+        void writeVector2(const Vector2& v)
+        {
+            write(v.x());
+            write(v.y());
+        }
+
+        void writeVertices(const std::vector<Vector3>& vertices)
+        {
+            write((uint32_t)vertices.size());
+            for (const auto& it : vertices)
+                writeVector3(it);
+        }
+
+    private:
+        std::vector<uint8_t>* m_bytes = nullptr;
+    };
+
+    class ByteReader {
+    public:
+        ByteReader(const std::vector<uint8_t>& bytes)
+            : m_bytes(bytes)
+        {
+        }
+
+        template <typename T>
+        bool read(T* value)
+        {
+            if (m_offset + sizeof(T) > m_bytes.size())
+                return false;
+            std::memcpy(value, m_bytes.data() + m_offset, sizeof(T));
+            m_offset += sizeof(T);
+            return true;
+        }
+
+        // Reject counts that could not possibly fit in the rest of the payload before allocating for them
+        bool readCount(uint32_t* count, size_t minimalItemSize)
+        {
+            if (!read(count))
+                return false;
+            return (uint64_t)*count * minimalItemSize <= m_bytes.size() - m_offset;
+        }
+
+        bool readVector3(Vector3* v)
+        {
+            double x, y, z;
+            if (!read(&x) || !read(&y) || !read(&z))
+                return false;
+            *v = Vector3(x, y, z);
+            return true;
+        }
+
+        bool readVector2(Vector2* v)
+        {
+            double x, y;
+            if (!read(&x) || !read(&y))
+                return false;
+            *v = Vector2(x, y);
+            return true;
+        }
+
+        bool readVertices(std::vector<Vector3>* vertices)
+        {
+            uint32_t count = 0;
+            if (!readCount(&count, sizeof(double) * 3))
+                return false;
+            vertices->resize(count);
+            for (auto& it : *vertices) {
+                if (!readVector3(&it))
+                    return false;
+            }
+            return true;
+        }
+
+        bool atEnd() const
+        {
+            return m_offset == m_bytes.size();
+        }
+
+    private:
+        const std::vector<uint8_t>& m_bytes;
+        size_t m_offset = 0;
+    };
+
+}
+
+MeshDiskCache::MeshDiskCache(const std::string& directory, const std::string& buildId)
+    : m_directory(directory)
+{
+    ContentHasher hasher;
+    hasher.addString(buildId);
+    m_buildKey = hasher.result();
+}
+
+const std::string& MeshDiskCache::directory() const
+{
+    return m_directory;
+}
+
+void MeshDiskCache::setMaxBytes(uint64_t maxBytes)
+{
+    m_maxBytes = maxBytes;
+}
+
+uint64_t MeshDiskCache::storageKey(uint64_t key) const
+{
+    ContentHasher hasher;
+    hasher.addInteger(m_buildKey);
+    hasher.addInteger(key);
+    return hasher.result();
+}
+
+std::string MeshDiskCache::entryPath(uint64_t key, const char* extension) const
+{
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+    // Fan out over subdirectories named after the first two digits, so no single directory grows too large
+    return (std::filesystem::path(m_directory) / std::string(name, 2) / (std::string(name) + extension)).string();
+}
+
+bool MeshDiskCache::readEntry(uint64_t key, const char* extension, std::vector<uint8_t>* payload) const
+{
+    key = storageKey(key);
+    std::string path = entryPath(key, extension);
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    char magic[sizeof(g_entryMagic)];
+    uint32_t version = 0;
+    uint64_t entryKey = 0;
+    uint64_t payloadSize = 0;
+    uint64_t payloadHash = 0;
+    file.read(magic, sizeof(magic));
+    file.read((char*)&version, sizeof(version));
+    file.read((char*)&entryKey, sizeof(entryKey));
+    file.read((char*)&payloadSize, sizeof(payloadSize));
+    file.read((char*)&payloadHash, sizeof(payloadHash));
+    if (!file.good() || 0 != std::memcmp(magic, g_entryMagic, sizeof(magic)) || g_entryVersion != version || key != entryKey)
+        return false;
+
+    std::error_code errorCode;
+    auto fileSize = std::filesystem::file_size(path, errorCode);
+    if (errorCode || fileSize != (uint64_t)file.tellg() + payloadSize)
+        return false;
+    payload->resize(payloadSize);
+    file.read((char*)payload->data(), payloadSize);
+    if (!file.good())
+        return false;
+
+    ContentHasher hasher;
+    hasher.addBytes(payload->data(), payload->size());
+    if (hasher.result() != payloadHash) {
+        dust3dDebug << "Corrupted mesh cache entry:" << path;
+        return false;
+    }
+
+    // Refresh the modification time so trim() evicts the least recently used entries first
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), errorCode);
+    return true;
+}
+
+void MeshDiskCache::writeEntry(uint64_t key, const char* extension, const std::vector<uint8_t>& payload) const
+{
+    thread_local std::mt19937_64 randomGenerator(std::random_device {}());
+
+    key = storageKey(key);
+    std::string path = entryPath(key, extension);
+    std::error_code errorCode;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), errorCode);
+    if (errorCode)
+        return;
+
+    // Other threads or processes may be writing the same entry, each writes its own temporary file
+    // and the last rename wins, which is fine as they all carry the same content
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%016llx.writing", (unsigned long long)randomGenerator());
+    std::string temporaryPath = path + suffix;
+    std::ofstream file(temporaryPath, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file.is_open())
+        return;
+
+    ContentHasher hasher;
+    hasher.addBytes(payload.data(), payload.size());
+    uint64_t payloadSize = payload.size();
+    uint64_t payloadHash = hasher.result();
+    file.write(g_entryMagic, sizeof(g_entryMagic));
+    file.write((const char*)&g_entryVersion, sizeof(g_entryVersion));
+    file.write((const char*)&key, sizeof(key));
+    file.write((const char*)&payloadSize, sizeof(payloadSize));
+    file.write((const char*)&payloadHash, sizeof(payloadHash));
+    file.write((const char*)payload.data(), payload.size());
+    file.close();
+
+    if (!file.fail()) {
+        std::filesystem::rename(temporaryPath, path, errorCode);
+        if (!errorCode) {
+            // A long session keeps storing, so trim whenever another eighth of the limit has been written,
+            // whichever thread crosses the mark takes the whole count and does the trim
+            if (0 != m_maxBytes) {
+                uint64_t bytesSinceTrim = m_bytesSinceTrim += payload.size();
+                if (bytesSinceTrim >= m_maxBytes / 8 && m_bytesSinceTrim.compare_exchange_strong(bytesSinceTrim, 0))
+                    trim(m_maxBytes);
+            }
+            return;
+        }
+    }
+    std::filesystem::remove(temporaryPath, errorCode);
+}
+
+bool MeshDiskCache::loadTube(uint64_t key, Tube* tube) const
+{
+    std::vector<uint8_t> payload;
+    if (!readEntry(key, ".tube", &payload))
+        return false;
+
+    ByteReader reader(payload);
+    if (!reader.readVertices(&tube->vertices))
+        return false;
+
+    uint32_t faceCount = 0;
+    if (!reader.readCount(&faceCount, sizeof(uint32_t)))
+        return false;
+    tube->faces.clear();
+    tube->faces.reserve(faceCount, faceCount * 4);
+    std::vector<uint32_t> face;
+    for (uint32_t i = 0; i < faceCount; ++i) {
+        uint32_t indexCount = 0;
+        if (!reader.readCount(&indexCount, sizeof(uint32_t)))
+            return false;
+        face.resize(indexCount);
+        for (auto& index : face) {
+            if (!reader.read(&index) || index >= tube->vertices.size())
+                return false;
+        }
+        tube->faces.push_back(face);
+    }
+
+    uint32_t faceUvCount = 0;
+    if (!reader.readCount(&faceUvCount, sizeof(uint32_t)))
+        return false;
+    tube->faceUvs.resize(faceUvCount);
+    for (auto& uvs : tube->faceUvs) {
+        uint32_t uvCount = 0;
+        if (!reader.readCount(&uvCount, sizeof(double) * 2))
+            return false;
+        uvs.resize(uvCount);
+        for (auto& uv : uvs) {
+            if (!reader.readVector2(&uv))
+                return false;
+        }
+    }
+
+    uint32_t sourceCount = 0;
+    if (!reader.readCount(&sourceCount, sizeof(uint64_t) * 2))
+        return false;
+    tube->vertexSources.resize(sourceCount);
+    for (auto& source : tube->vertexSources) {
+        uint64_t high = 0;
+        uint64_t low = 0;
+        if (!reader.read(&high) || !reader.read(&low))
+            return false;
+        source = Uuid(high, low);
+    }
+
+    return reader.atEnd();
+}
+
+void MeshDiskCache::storeTube(uint64_t key, const Tube& tube) const
+{
+    std::vector<uint8_t> payload;
+    ByteWriter writer(&payload);
+    writer.writeVertices(tube.vertices);
+    writer.write((uint32_t)tube.faces.size());
+    for (const auto& face : tube.faces) {
+        writer.write((uint32_t)face.size());
+        for (const auto& index : face)
+            writer.write((uint32_t)index);
+    }
+    writer.write((uint32_t)tube.faceUvs.size());
+    for (const auto& uvs : tube.faceUvs) {
+        writer.write((uint32_t)uvs.size());
+        for (const auto& uv : uvs)
+            writer.writeVector2(uv);
+    }
+    writer.write((uint32_t)tube.vertexSources.size());
+    for (const auto& source : tube.vertexSources) {
+        writer.write(source.high());
+        writer.write(source.low());
+    }
+    writeEntry(key, ".tube", payload);
+}
+
+bool MeshDiskCache::loadMesh(uint64_t key, std::unique_ptr<MeshState>* meshState) const
+{
+    std::vector<uint8_t> payload;
+    if (!readEntry(key, ".mesh", &payload))
+        return false;
+
+    ByteReader reader(payload);
+    uint8_t hasMesh = 0;
+    if (!reader.read(&hasMesh))
+        return false;
+    if (0 == hasMesh) {
+        if (!reader.atEnd())
+            return false;
+        meshState->reset();
+        return true;
+    }
+
+    std::vector<Vector3> vertices;
+    if (!reader.readVertices(&vertices))
+        return false;
+    uint32_t triangleCount = 0;
+    if (!reader.readCount(&triangleCount, sizeof(uint32_t) * 3))
+        return false;
+    IndexedTriangles triangles(triangleCount);
+    for (auto& triangle : triangles) {
+        for (auto& index : triangle) {
+            if (!reader.read(&index) || index >= vertices.size())
+                return false;
+        }
+    }
+
+    auto newMeshState = std::make_unique<MeshState>();
+    uint32_t seamCount = 0;
+    if (!reader.readCount(&seamCount, sizeof(uint32_t)))
+        return false;
+    newMeshState->seamTriangleUvs.reserve(seamCount);
+    for (uint32_t i = 0; i < seamCount; ++i) {
+        uint32_t entryCount = 0;
+        if (!reader.readCount(&entryCount, sizeof(int64_t) * 9 + sizeof(double) * 6))
+            return false;
+        auto uvs = std::make_shared<SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>>>();
+        uvs->reserve(entryCount);
+        for (uint32_t j = 0; j < entryCount; ++j) {
+            int64_t ints[9];
+            for (auto& it : ints) {
+                if (!reader.read(&it))
+                    return false;
+            }
+            std::array<Vector2, 3> triangleUvs;
+            for (auto& uv : triangleUvs) {
+                if (!reader.readVector2(&uv))
+                    return false;
+            }
+            uvs->insert({ { PositionKey::fromIntegers((long)ints[0], (long)ints[1], (long)ints[2]),
+                              PositionKey::fromIntegers((long)ints[3], (long)ints[4], (long)ints[5]),
+                              PositionKey::fromIntegers((long)ints[6], (long)ints[7], (long)ints[8]) },
+                triangleUvs });
+        }
+        newMeshState->seamTriangleUvs.push_back(std::move(uvs));
+    }
+    if (!reader.atEnd())
+        return false;
+
+    newMeshState->mesh = std::make_unique<MeshCombiner::Mesh>(std::move(vertices), std::move(triangles));
+    newMeshState->contentHash = key;
+    *meshState = std::move(newMeshState);
+    return true;
+}
+
+void MeshDiskCache::storeMesh(uint64_t key, const MeshState* meshState) const
+{
+    std::vector<uint8_t> payload;
+    ByteWriter writer(&payload);
+    if (nullptr == meshState || meshState->isNull()) {
+        writer.write((uint8_t)0);
+        writeEntry(key, ".mesh", payload);
+        return;
+    }
+
+    std::vector<Vector3> vertices;
+    IndexedTriangles triangles;
+    meshState->fetch(vertices, triangles);
+    payload.reserve(1 + (4 + vertices.size() * sizeof(double) * 3) + (4 + triangles.size() * sizeof(uint32_t) * 3));
+    writer.write((uint8_t)1);
+    writer.writeVertices(vertices);
+    writer.write((uint32_t)triangles.size());
+    for (const auto& triangle : triangles) {
+        for (const auto& index : triangle)
+            writer.write(index);
+    }
+    writer.write((uint32_t)meshState->seamTriangleUvs.size());
+    for (const auto& uvs : meshState->seamTriangleUvs) {
+        writer.write((uint32_t)uvs->size());
+        for (const auto& it : *uvs) {
+            for (const auto& positionKey : it.first) {
+                writer.write((int64_t)positionKey.intX());
+                writer.write((int64_t)positionKey.intY());
+                writer.write((int64_t)positionKey.intZ());
+            }
+            for (const auto& uv : it.second)
+                writer.writeVector2(uv);
+        }
+    }
+    writeEntry(key, ".mesh", payload);
+}
+
+void MeshDiskCache::trim(uint64_t maxBytes) const
+{
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type time;
+        uint64_t size;
+    };
+    std::vector<Entry> entries;
+    uint64_t totalBytes = 0;
+    std::error_code errorCode;
+    for (std::filesystem::recursive_directory_iterator it(m_directory, errorCode), end; !errorCode && it != end; it.increment(errorCode)) {
+        if (!it->is_regular_file(errorCode))
+            continue;
+        Entry entry { it->path(), it->last_write_time(errorCode), it->file_size(errorCode) };
+        if (errorCode)
+            continue;
+        totalBytes += entry.size;
+        entries.push_back(std::move(entry));
+    }
+    if (totalBytes <= maxBytes)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& first, const Entry& second) {
+        return first.time < second.time;
+    });
+    for (const auto& entry : entries) {
+        if (totalBytes <= maxBytes)
+            break;
+        if (std::filesystem::remove(entry.path, errorCode))
+            totalBytes -= entry.size;
+    }
+}
+
+}
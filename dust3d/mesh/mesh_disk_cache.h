@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_MESH_MESH_DISK_CACHE_H_
+#define DUST3D_MESH_MESH_DISK_CACHE_H_
+
+#include <dust3d/base/indexed_mesh.h>
+#include <dust3d/base/uuid.h>
+#include <dust3d/base/vector2.h>
+#include <dust3d/base/vector3.h>
+#include <dust3d/mesh/mesh_state.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dust3d {
+
+// Content addressed store of generated tubes and combined meshes, so unchanged parts
+// and booleans survive across documents and processes. Entries are keyed by a hash
+// of their generation inputs, which the caller computes; a key is never rewritten
+// with different content, so concurrent readers and writers need no locking.
+// Every key is mixed with the build id, as the same inputs may generate differently
+// in another build, entries of other builds are never hit and age out through trim.
+class MeshDiskCache {
+public:
+    struct Tube {
+        std::vector<Vector3> vertices;
+        IndexedPolygons faces;
+        std::vector<std::vector<Vector2>> faceUvs;
+        std::vector<Uuid> vertexSources;
+    };
+
+    MeshDiskCache(const std::string& directory, const std::string& buildId);
+    const std::string& directory() const;
+    // Trim back to maxBytes from time to time while storing, zero for no limit
+    void setMaxBytes(uint64_t maxBytes);
+    bool loadTube(uint64_t key, Tube* tube) const;
+    void storeTube(uint64_t key, const Tube& tube) const;
+    // A hit may hand back a null mesh state, which records a combination known to fail
+    bool loadMesh(uint64_t key, std::unique_ptr<MeshState>* meshState) const;
+    void storeMesh(uint64_t key, const MeshState* meshState) const;
+    // Remove least recently used entries until the cache is no larger than maxBytes
+    void trim(uint64_t maxBytes) const;
+
+private:
+    std::string m_directory;
+    uint64_t m_buildKey = 0;
+    uint64_t m_maxBytes = 0;
+    mutable std::atomic<uint64_t> m_bytesSinceTrim = 0;
+
+    uint64_t storageKey(uint64_t key) const;
+    std::string entryPath(uint64_t key, const char* extension) const;
+    bool readEntry(uint64_t key, const char* extension, std::vector<uint8_t>* payload) const;
+    void writeEntry(uint64_t key, const char* extension, const std::vector<uint8_t>& payload) const;
+};
+
+}
+
+#endif
@@ -20,6 +20,7 @@
  *  SOFTWARE.
  */
 
+#include <dust3d/base/content_hasher.h>
 #include <dust3d/base/cut_face.h>
 #include <dust3d/base/part_target.h>
 #include <dust3d/base/snapshot_xml.h>
@@ -33,11 +34,13 @@
 #include <dust3d/mesh/trim_vertices.h>
 #include <dust3d/mesh/tube_mesh_builder.h>
 #include <dust3d/mesh/weld_vertices.h>
+#include <algorithm>
 #include <functional>
 
 namespace dust3d {
 
 double MeshGenerator::m_minimalRadius = 0.001;
+const uint64_t MeshGenerator::m_diskCacheKeyVersion = 1;
 
 MeshGenerator::MeshGenerator(Snapshot* snapshot)
     : m_snapshot(snapshot)
@@ -146,78 +149,55 @@ void MeshGenerator::recoverQuads(const std::vector<Vector3>& vertices, const std
     }
 }
 
-void MeshGenerator::collectParts()
+MeshGenerator::GeneratedComponent& MeshGenerator::componentCache(const std::string& componentIdString)
 {
-    for (const auto& node : m_snapshot->nodes) {
-        std::string partId = String::valueOrEmpty(node.second, "partId");
-        if (partId.empty())
-            continue;
-        m_partNodeIds[partId].insert(node.first);
-    }
-    for (const auto& edge : m_snapshot->edges) {
-        std::string partId = String::valueOrEmpty(edge.second, "partId");
-        if (partId.empty())
-            continue;
-        m_partEdgeIds[partId].insert(edge.first);
-    }
+    std::lock_guard<std::mutex> lock(m_cacheContext->mutex);
+    return m_cacheContext->components[componentIdString];
+}
+
+MeshGenerator::GeneratedPart& MeshGenerator::partCache(const std::string& partIdString)
+{
+    std::lock_guard<std::mutex> lock(m_cacheContext->mutex);
+    return m_cacheContext->parts[partIdString];
 }
 
 bool MeshGenerator::checkIsPartDirty(const std::string& partIdString)
 {
-    auto findPart = m_snapshot->parts.find(partIdString);
-    if (findPart == m_snapshot->parts.end()) {
+    const CompiledSnapshot::Part* part = m_compiledSnapshot->findPart(partIdString);
+    if (nullptr == part) {
         return false;
     }
-    return String::isTrue(String::valueOrEmpty(findPart->second, "__dirty"));
+    return part->dirty;
 }
 
 bool MeshGenerator::checkIsPartDependencyDirty(const std::string& partIdString)
 {
-    auto findPart = m_snapshot->parts.find(partIdString);
-    if (findPart == m_snapshot->parts.end()) {
+    const CompiledSnapshot::Part* part = m_compiledSnapshot->findPart(partIdString);
+    if (nullptr == part) {
         return false;
     }
-    std::string cutFaceString = String::valueOrEmpty(findPart->second, "cutFace");
-    Uuid cutFaceLinkedPartId = Uuid(cutFaceString);
+    Uuid cutFaceLinkedPartId = Uuid(part->cutFace);
     if (!cutFaceLinkedPartId.isNull()) {
-        if (checkIsPartDirty(cutFaceString))
+        if (checkIsPartDirty(part->cutFace))
             return true;
     }
-    for (const auto& nodeIdString : m_partNodeIds[partIdString]) {
-        auto findNode = m_snapshot->nodes.find(nodeIdString);
-        if (findNode == m_snapshot->nodes.end()) {
-            continue;
-        }
-        std::string cutFaceString = String::valueOrEmpty(findNode->second, "cutFace");
-        Uuid cutFaceLinkedPartId = Uuid(cutFaceString);
+    for (const auto& nodeIndex : part->nodeIndices) {
+        const auto& node = m_compiledSnapshot->nodes()[nodeIndex];
+        Uuid cutFaceLinkedPartId = Uuid(node.cutFace);
         if (!cutFaceLinkedPartId.isNull()) {
-            if (checkIsPartDirty(cutFaceString))
+            if (checkIsPartDirty(node.cutFace))
                 return true;
         }
     }
     return false;
 }
 
-bool MeshGenerator::checkIsComponentDirty(const std::string& componentIdString)
+bool MeshGenerator::checkIsComponentDirty(const CompiledSnapshot::Component& component)
 {
-    bool isDirty = false;
+    bool isDirty = component.dirty;
 
-    const std::map<std::string, std::string>* component = &m_snapshot->rootComponent;
-    if (componentIdString != to_string(Uuid())) {
-        auto findComponent = m_snapshot->components.find(componentIdString);
-        if (findComponent == m_snapshot->components.end()) {
-            return isDirty;
-        }
-        component = &findComponent->second;
-    }
-
-    if (String::isTrue(String::valueOrEmpty(*component, "__dirty"))) {
-        isDirty = true;
-    }
-
-    std::string linkDataType = String::valueOrEmpty(*component, "linkDataType");
-    if ("partId" == linkDataType) {
-        std::string partId = String::valueOrEmpty(*component, "linkData");
+    if (component.linksToPart) {
+        const std::string& partId = component.linkedPartIdString;
         if (checkIsPartDirty(partId)) {
             m_dirtyPartIds.insert(partId);
             isDirty = true;
@@ -229,62 +209,50 @@ bool MeshGenerator::checkIsComponentDirty(const std::string& componentIdString)
         }
     }
 
-    for (const auto& childId : String::split(String::valueOrEmpty(*component, "children"), ',')) {
-        if (childId.empty())
-            continue;
-        if (checkIsComponentDirty(childId)) {
+    for (const auto& childIndex : component.childIndices) {
+        if (checkIsComponentDirty(m_compiledSnapshot->components()[childIndex])) {
             isDirty = true;
         }
     }
 
     if (isDirty)
-        m_dirtyComponentIds.insert(componentIdString);
+        m_dirtyComponentIds.insert(component.idString);
 
     return isDirty;
 }
 
 void MeshGenerator::checkDirtyFlags()
 {
-    checkIsComponentDirty(to_string(Uuid()));
+    checkIsComponentDirty(m_compiledSnapshot->rootComponent());
 }
 
 void MeshGenerator::cutFaceStringToCutTemplate(const std::string& cutFaceString, std::vector<Vector2>& cutTemplate)
 {
     Uuid cutFaceLinkedPartId = Uuid(cutFaceString);
     if (!cutFaceLinkedPartId.isNull()) {
-        std::map<std::string, std::tuple<float, float, float>> cutFaceNodeMap;
-        auto findCutFaceLinkedPart = m_snapshot->parts.find(cutFaceString);
-        if (findCutFaceLinkedPart == m_snapshot->parts.end()) {
+        std::map<size_t, std::tuple<float, float, float>> cutFaceNodeMap;
+        const CompiledSnapshot::Part* cutFaceLinkedPart = m_compiledSnapshot->findPart(cutFaceString);
+        if (nullptr == cutFaceLinkedPart) {
             // void
         } else {
             // Build node info map
-            for (const auto& nodeIdString : m_partNodeIds[cutFaceString]) {
-                auto findNode = m_snapshot->nodes.find(nodeIdString);
-                if (findNode == m_snapshot->nodes.end()) {
-                    continue;
-                }
-                auto& node = findNode->second;
-                float radius = String::toFloat(String::valueOrEmpty(node, "radius"));
-                float x = (String::toFloat(String::valueOrEmpty(node, "x")) - m_mainProfileMiddleX);
-                float y = (m_mainProfileMiddleY - String::toFloat(String::valueOrEmpty(node, "y")));
-                cutFaceNodeMap.insert({ nodeIdString, std::make_tuple(radius, x, y) });
+            for (const auto& nodeIndex : cutFaceLinkedPart->nodeIndices) {
+                const auto& node = m_compiledSnapshot->nodes()[nodeIndex];
+                float radius = node.radius;
+                float x = (node.x - m_mainProfileMiddleX);
+                float y = (m_mainProfileMiddleY - node.y);
+                cutFaceNodeMap.insert({ nodeIndex, std::make_tuple(radius, x, y) });
             }
             // Build edge link
-            std::map<std::string, std::vector<std::string>> cutFaceNodeLinkMap;
-            for (const auto& edgeIdString : m_partEdgeIds[cutFaceString]) {
-                auto findEdge = m_snapshot->edges.find(edgeIdString);
-                if (findEdge == m_snapshot->edges.end()) {
-                    continue;
-                }
-                auto& edge = findEdge->second;
-                std::string fromNodeIdString = String::valueOrEmpty(edge, "from");
-                std::string toNodeIdString = String::valueOrEmpty(edge, "to");
-                cutFaceNodeLinkMap[fromNodeIdString].push_back(toNodeIdString);
-                cutFaceNodeLinkMap[toNodeIdString].push_back(fromNodeIdString);
+            std::map<size_t, std::vector<size_t>> cutFaceNodeLinkMap;
+            for (const auto& edgeIndex : cutFaceLinkedPart->edgeIndices) {
+                const auto& edge = m_compiledSnapshot->edges()[edgeIndex];
+                cutFaceNodeLinkMap[edge.fromNodeIndex].push_back(edge.toNodeIndex);
+                cutFaceNodeLinkMap[edge.toNodeIndex].push_back(edge.fromNodeIndex);
             }
             // Find endpoint
-            std::string endPointNodeIdString;
-            std::vector<std::pair<std::string, std::tuple<float, float, float>>> endpointNodes;
+            size_t endPointNodeIndex = CompiledSnapshot::npos;
+            std::vector<std::pair<size_t, std::tuple<float, float, float>>> endpointNodes;
             for (const auto& it : cutFaceNodeLinkMap) {
                 if (1 == it.second.size()) {
                     const auto& findNode = cutFaceNodeMap.find(it.first);
@@ -321,35 +289,35 @@ void MeshGenerator::cutFaceStringToCutTemplate(const std::string& cutFaceString,
                         choosenEndpoint = i;
                     }
                 }
-                endPointNodeIdString = endpointNodes[choosenEndpoint].first;
+                endPointNodeIndex = endpointNodes[choosenEndpoint].first;
             }
             // Loop all linked nodes
             std::vector<std::tuple<float, float, float, std::string>> cutFaceNodes;
-            std::set<std::string> cutFaceVisitedNodeIds;
-            std::function<void(const std::string&)> loopNodeLink;
-            loopNodeLink = [&](const std::string& fromNodeIdString) {
-                auto findCutFaceNode = cutFaceNodeMap.find(fromNodeIdString);
+            std::set<size_t> cutFaceVisitedNodeIndices;
+            std::function<void(size_t)> loopNodeLink;
+            loopNodeLink = [&](size_t fromNodeIndex) {
+                auto findCutFaceNode = cutFaceNodeMap.find(fromNodeIndex);
                 if (findCutFaceNode == cutFaceNodeMap.end())
                     return;
-                if (cutFaceVisitedNodeIds.find(fromNodeIdString) != cutFaceVisitedNodeIds.end())
+                if (cutFaceVisitedNodeIndices.find(fromNodeIndex) != cutFaceVisitedNodeIndices.end())
                     return;
-                cutFaceVisitedNodeIds.insert(fromNodeIdString);
+                cutFaceVisitedNodeIndices.insert(fromNodeIndex);
                 cutFaceNodes.push_back(std::make_tuple(std::get<0>(findCutFaceNode->second),
                     std::get<1>(findCutFaceNode->second),
                     std::get<2>(findCutFaceNode->second),
-                    fromNodeIdString));
-                auto findNeighbor = cutFaceNodeLinkMap.find(fromNodeIdString);
+                    m_compiledSnapshot->nodes()[fromNodeIndex].idString));
+                auto findNeighbor = cutFaceNodeLinkMap.find(fromNodeIndex);
                 if (findNeighbor == cutFaceNodeLinkMap.end())
                     return;
                 for (const auto& it : findNeighbor->second) {
-                    if (cutFaceVisitedNodeIds.find(it) == cutFaceVisitedNodeIds.end()) {
+                    if (cutFaceVisitedNodeIndices.find(it) == cutFaceVisitedNodeIndices.end()) {
                         loopNodeLink(it);
                         break;
                     }
                 }
             };
-            if (!endPointNodeIdString.empty()) {
-                loopNodeLink(endPointNodeIdString);
+            if (CompiledSnapshot::npos != endPointNodeIndex) {
+                loopNodeLink(endPointNodeIndex);
             }
             // Fetch points from linked nodes
             std::vector<std::string> cutTemplateNames;
@@ -402,23 +370,25 @@ void MeshGenerator::flattenLinks(const std::unordered_map<size_t, size_t>& links
 
 bool MeshGenerator::fetchPartOrderedNodes(const std::string& partIdString, std::vector<MeshNode>* meshNodes, bool* isCircle)
 {
+    const CompiledSnapshot::Part* part = m_compiledSnapshot->findPart(partIdString);
+    if (nullptr == part) {
+        dust3dDebug << "Expected at least one node in part:" << partIdString;
+        return false;
+    }
+
     std::vector<MeshNode> builderNodes;
-    std::map<std::string, size_t> builderNodeIdStringToIndexMap;
-    for (const auto& nodeIdString : m_partNodeIds[partIdString]) {
-        auto findNode = m_snapshot->nodes.find(nodeIdString);
-        if (findNode == m_snapshot->nodes.end()) {
-            continue;
-        }
-        auto& node = findNode->second;
+    std::unordered_map<size_t, size_t> builderNodeIndexMap;
+    for (const auto& nodeIndex : part->nodeIndices) {
+        const auto& node = m_compiledSnapshot->nodes()[nodeIndex];
 
-        float radius = String::toFloat(String::valueOrEmpty(node, "radius"));
-        float x = (String::toFloat(String::valueOrEmpty(node, "x")) - m_mainProfileMiddleX);
-        float y = (m_mainProfileMiddleY - String::toFloat(String::valueOrEmpty(node, "y")));
-        float z = (m_sideProfileMiddleX - String::toFloat(String::valueOrEmpty(node, "z")));
+        float radius = node.radius;
+        float x = (node.x - m_mainProfileMiddleX);
+        float y = (m_mainProfileMiddleY - node.y);
+        float z = (m_sideProfileMiddleX - node.z);
 
-        builderNodeIdStringToIndexMap.insert({ nodeIdString, builderNodes.size() });
+        builderNodeIndexMap.insert({ nodeIndex, builderNodes.size() });
         builderNodes.emplace_back(MeshNode {
-            Vector3((double)x, (double)y, (double)z), (double)radius, Uuid(nodeIdString) });
+            Vector3((double)x, (double)y, (double)z), (double)radius, node.id });
     }
 
     if (builderNodes.empty()) {
@@ -427,21 +397,14 @@ bool MeshGenerator::fetchPartOrderedNodes(const std::string& partIdString, std::
     }
 
     std::unordered_map<size_t, size_t> builderNodeLinks;
-    for (const auto& edgeIdString : m_partEdgeIds[partIdString]) {
-        auto findEdge = m_snapshot->edges.find(edgeIdString);
-        if (findEdge == m_snapshot->edges.end()) {
-            continue;
-        }
-        auto& edge = findEdge->second;
-
-        std::string fromNodeIdString = String::valueOrEmpty(edge, "from");
-        std::string toNodeIdString = String::valueOrEmpty(edge, "to");
+    for (const auto& edgeIndex : part->edgeIndices) {
+        const auto& edge = m_compiledSnapshot->edges()[edgeIndex];
 
-        auto findFrom = builderNodeIdStringToIndexMap.find(fromNodeIdString);
-        if (findFrom == builderNodeIdStringToIndexMap.end())
+        auto findFrom = builderNodeIndexMap.find(edge.fromNodeIndex);
+        if (findFrom == builderNodeIndexMap.end())
             continue;
-        auto findTo = builderNodeIdStringToIndexMap.find(toNodeIdString);
-        if (findTo == builderNodeIdStringToIndexMap.end())
+        auto findTo = builderNodeIndexMap.find(edge.toNodeIndex);
+        if (findTo == builderNodeIndexMap.end())
             continue;
         builderNodeLinks[findFrom->second] = findTo->second;
     }
@@ -484,14 +447,23 @@ std::unique_ptr<MeshState> MeshGenerator::combineStitchingMesh(const std::vector
     }
 
     auto stitchMeshBuilder = std::make_unique<StitchMeshBuilder>(std::move(splines));
+    uint64_t stitchHash = 0;
+    if (nullptr != m_diskCache) {
+        ContentHasher hasher;
+        hasher.addInteger(m_diskCacheKeyVersion);
+        hasher.addInteger(stitchMeshBuilder->inputHash());
+        stitchHash = hasher.result();
+    }
     stitchMeshBuilder->build();
 
+    IndexedPolygons stitchingFaces = IndexedPolygons::fromFaces(stitchMeshBuilder->generatedFaces());
     collectSharedQuadEdges(stitchMeshBuilder->generatedVertices(),
-        stitchMeshBuilder->generatedFaces(),
+        stitchingFaces,
         &componentCache.sharedQuadEdges);
 
     auto mesh = std::make_unique<MeshState>(stitchMeshBuilder->generatedVertices(),
-        stitchMeshBuilder->generatedFaces());
+        stitchingFaces);
+    mesh->contentHash = stitchHash;
     if (mesh && mesh->isNull())
         mesh.reset();
 
@@ -546,93 +518,39 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
     const std::string& componentIdString,
     bool* hasError)
 {
-    auto findPart = m_snapshot->parts.find(partIdString);
-    if (findPart == m_snapshot->parts.end()) {
+    const CompiledSnapshot::Part* part = m_compiledSnapshot->findPart(partIdString);
+    if (nullptr == part) {
         return nullptr;
     }
 
-    Uuid partId = Uuid(partIdString);
-    auto& part = findPart->second;
-
-    bool isDisabled = String::isTrue(String::valueOrEmpty(part, "disabled"));
-    std::string __mirroredByPartId = String::valueOrEmpty(part, "__mirroredByPartId");
-    std::string __mirrorFromPartId = String::valueOrEmpty(part, "__mirrorFromPartId");
-    bool subdived = String::isTrue(String::valueOrEmpty(part, "subdived"));
-    bool rounded = String::isTrue(String::valueOrEmpty(part, "rounded"));
-    bool chamfered = String::isTrue(String::valueOrEmpty(part, "chamfered"));
-    bool countershaded = String::isTrue(String::valueOrEmpty(part, "countershaded"));
-    std::string colorString = String::valueOrEmpty(part, "color");
-    Color partColor = colorString.empty() ? m_defaultPartColor : Color(colorString);
-    float deformThickness = 1.0;
-    float deformWidth = 1.0;
-    float cutRotation = 0.0;
-    float hollowThickness = 0.0;
-    float smoothCutoffDegrees = 0.0;
-    auto target = PartTargetFromString(String::valueOrEmpty(part, "target").c_str());
+    bool isDisabled = part->disabled;
+    const std::string& __mirrorFromPartId = part->mirrorFromPartIdString;
+    Color partColor = part->hasColor ? part->color : m_defaultPartColor;
+    float deformThickness = part->deformThickness;
+    float deformWidth = part->deformWidth;
+    float cutRotation = part->cutRotation;
+    float smoothCutoffDegrees = part->smoothCutoffDegrees;
+    auto target = part->target;
 
     std::string searchPartIdString = __mirrorFromPartId.empty() ? partIdString : __mirrorFromPartId;
 
-    std::string cutFaceString = String::valueOrEmpty(part, "cutFace");
     std::vector<Vector2> cutTemplate;
-    cutFaceStringToCutTemplate(cutFaceString, cutTemplate);
-    if (chamfered)
+    cutFaceStringToCutTemplate(part->cutFace, cutTemplate);
+    if (part->chamfered)
         chamferFace(&cutTemplate);
-    if (subdived)
+    if (part->subdived)
         subdivideFace(&cutTemplate);
 
-    std::string smoothCutoffDegreesString = String::valueOrEmpty(part, "smoothCutoffDegrees");
-    if (!smoothCutoffDegreesString.empty()) {
-        smoothCutoffDegrees = String::toFloat(smoothCutoffDegreesString);
-    }
-
-    std::string cutRotationString = String::valueOrEmpty(part, "cutRotation");
-    if (!cutRotationString.empty()) {
-        cutRotation = String::toFloat(cutRotationString);
-    }
-
-    std::string hollowThicknessString = String::valueOrEmpty(part, "hollowThickness");
-    if (!hollowThicknessString.empty()) {
-        hollowThickness = String::toFloat(hollowThicknessString);
-    }
-
-    std::string thicknessString = String::valueOrEmpty(part, "deformThickness");
-    if (!thicknessString.empty()) {
-        deformThickness = String::toFloat(thicknessString);
-    }
-
-    std::string widthString = String::valueOrEmpty(part, "deformWidth");
-    if (!widthString.empty()) {
-        deformWidth = String::toFloat(widthString);
-    }
-
-    bool deformUnified = String::isTrue(String::valueOrEmpty(part, "deformUnified"));
-
-    Uuid materialId;
-    std::string materialIdString = String::valueOrEmpty(part, "materialId");
-    if (!materialIdString.empty())
-        materialId = Uuid(materialIdString);
-
-    float colorSolubility = 0;
-    std::string colorSolubilityString = String::valueOrEmpty(part, "colorSolubility");
-    if (!colorSolubilityString.empty())
-        colorSolubility = String::toFloat(colorSolubilityString);
-
-    float metalness = 0;
-    std::string metalnessString = String::valueOrEmpty(part, "metallic");
-    if (!metalnessString.empty())
-        metalness = String::toFloat(metalnessString);
-
-    float roughness = 1.0;
-    std::string roughnessString = String::valueOrEmpty(part, "roughness");
-    if (!roughnessString.empty())
-        roughness = String::toFloat(roughnessString);
+    bool deformUnified = part->deformUnified;
+    float metalness = part->metalness;
+    float roughness = part->roughness;
 
     std::vector<MeshNode> meshNodes;
     bool isCircle = false;
     if (!fetchPartOrderedNodes(searchPartIdString, &meshNodes, &isCircle))
         return nullptr;
 
-    auto& partCache = m_cacheContext->parts[partIdString];
+    auto& partCache = this->partCache(partIdString);
     partCache.reset();
 
     partCache.color = partColor;
@@ -647,6 +565,7 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
             ObjectNode { meshNode.origin, partColor, smoothCutoffDegrees }));
     }
 
+    uint64_t tubeHash = 0;
     if (PartTarget::Model == target) {
         std::unique_ptr<TubeMeshBuilder> tubeMeshBuilder;
         TubeMeshBuilder::BuildParameters buildParameters;
@@ -655,18 +574,37 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
         buildParameters.deformUnified = deformUnified;
         buildParameters.baseNormalRotation = cutRotation * Math::Pi;
         buildParameters.cutFace = cutTemplate;
-        buildParameters.frontEndRounded = buildParameters.backEndRounded = rounded;
+        buildParameters.frontEndRounded = buildParameters.backEndRounded = part->rounded;
         tubeMeshBuilder = std::make_unique<TubeMeshBuilder>(buildParameters, std::move(meshNodes), isCircle);
-        tubeMeshBuilder->build();
-        partCache.vertices = tubeMeshBuilder->generatedVertices();
-        partCache.faces = tubeMeshBuilder->generatedFaces();
+        MeshDiskCache::Tube tube;
+        bool tubeLoaded = false;
+        if (nullptr != m_diskCache) {
+            ContentHasher hasher;
+            hasher.addInteger(m_diskCacheKeyVersion);
+            hasher.addInteger(tubeMeshBuilder->inputHash());
+            tubeHash = hasher.result();
+            tubeLoaded = m_diskCache->loadTube(tubeHash, &tube);
+        }
+        if (!tubeLoaded) {
+            tubeMeshBuilder->build();
+            tube.vertices = tubeMeshBuilder->generatedVertices();
+            tube.faces = tubeMeshBuilder->generatedFaces();
+            tube.faceUvs = tubeMeshBuilder->generatedFaceUvs();
+            tube.vertexSources = tubeMeshBuilder->generatedVertexSources();
+            if (nullptr != m_diskCache)
+                m_diskCache->storeTube(tubeHash, tube);
+        }
+        partCache.vertices = std::move(tube.vertices);
+        partCache.faces = std::move(tube.faces);
         if (!__mirrorFromPartId.empty()) {
             for (auto& it : partCache.vertices)
                 it.setX(-it.x());
-            for (auto& it : partCache.faces)
-                std::reverse(it.begin(), it.end());
+            for (size_t i = 0; i < partCache.faces.size(); ++i) {
+                auto face = partCache.faces[i];
+                std::reverse(face.begin(), face.end());
+            }
         }
-        const auto& faceUvs = tubeMeshBuilder->generatedFaceUvs();
+        const auto& faceUvs = tube.faceUvs;
         for (size_t i = 0; i < faceUvs.size(); ++i) {
             const auto& uv = faceUvs[i];
             const auto& face = partCache.faces[i];
@@ -686,7 +624,7 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
                     { uv[2], uv[3], uv[0] } });
             }
         }
-        const auto& vertexSources = tubeMeshBuilder->generatedVertexSources();
+        const auto& vertexSources = tube.vertexSources;
         for (size_t i = 0; i < vertexSources.size(); ++i) {
             partCache.positionToNodeIdMap.emplace(std::make_pair(PositionKey(partCache.vertices[i]), vertexSources[i]));
         }
@@ -699,6 +637,12 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
     if (mesh->isNull()) {
         hasMeshError = true;
     }
+    if (0 != tubeHash) {
+        ContentHasher hasher;
+        hasher.addInteger(tubeHash);
+        hasher.addInteger(!__mirrorFromPartId.empty());
+        mesh->contentHash = hasher.result();
+    }
 
     if (PartTarget::Model == target) {
         ComponentPreview preview;
@@ -730,68 +674,36 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
     return mesh;
 }
 
-const std::map<std::string, std::string>* MeshGenerator::findComponent(const std::string& componentIdString)
-{
-    const std::map<std::string, std::string>* component = &m_snapshot->rootComponent;
-    if (componentIdString != to_string(Uuid())) {
-        auto findComponent = m_snapshot->components.find(componentIdString);
-        if (findComponent == m_snapshot->components.end()) {
-            return nullptr;
-        }
-        return &findComponent->second;
-    }
-    return component;
-}
-
-CombineMode MeshGenerator::componentCombineMode(const std::map<std::string, std::string>* component)
-{
-    if (nullptr == component)
-        return CombineMode::Normal;
-    CombineMode combineMode = CombineModeFromString(String::valueOrEmpty(*component, "combineMode").c_str());
-    if (combineMode == CombineMode::Normal) {
-        if (String::isTrue(String::valueOrEmpty(*component, "inverse")))
-            combineMode = CombineMode::Inversion;
-    }
-    return combineMode;
-}
-
 std::unique_ptr<MeshState> MeshGenerator::combineComponentMesh(const std::string& componentIdString, CombineMode* combineMode)
 {
     std::unique_ptr<MeshState> mesh;
 
-    Uuid componentId;
-    const std::map<std::string, std::string>* component = &m_snapshot->rootComponent;
-    if (componentIdString != to_string(Uuid())) {
-        componentId = Uuid(componentIdString);
-        auto findComponent = m_snapshot->components.find(componentIdString);
-        if (findComponent == m_snapshot->components.end()) {
-            return nullptr;
-        }
-        component = &findComponent->second;
-    }
+    const CompiledSnapshot::Component* component = m_compiledSnapshot->findComponent(componentIdString);
+    if (nullptr == component)
+        return nullptr;
+    const Uuid& componentId = component->id;
 
-    *combineMode = componentCombineMode(component);
+    *combineMode = component->combineMode;
 
-    auto& componentCache = m_cacheContext->components[componentIdString];
+    auto& componentCache = this->componentCache(componentIdString);
 
     if (m_cacheEnabled) {
         if (m_dirtyComponentIds.find(componentIdString) == m_dirtyComponentIds.end()) {
             if (nullptr != componentCache.mesh)
-                return std::make_unique<MeshState>(*componentCache.mesh);
+                return componentCache.mesh->share();
         }
     }
 
     componentCache.reset();
 
-    std::string linkDataType = String::valueOrEmpty(*component, "linkDataType");
-    if ("partId" == linkDataType) {
-        std::string partIdString = String::valueOrEmpty(*component, "linkData");
+    if (component->linksToPart) {
+        const std::string& partIdString = component->linkedPartIdString;
         bool hasError = false;
         mesh = combinePartMesh(partIdString, componentIdString, &hasError);
         if (hasError) {
             m_isSuccessful = false;
         }
-        const auto& partCache = m_cacheContext->parts[partIdString];
+        const auto& partCache = this->partCache(partIdString);
         if (partCache.joined) {
             for (const auto& vertex : partCache.vertices)
                 componentCache.noneSeamVertices.insert(vertex);
@@ -812,24 +724,20 @@ std::unique_ptr<MeshState> MeshGenerator::combineComponentMesh(const std::string
         auto lastCombineMode = CombineMode::Count;
         std::vector<std::string> stitchingParts;
         std::vector<std::string> stitchingComponents;
-        for (const auto& childIdString : String::split(String::valueOrEmpty(*component, "children"), ',')) {
-            if (childIdString.empty())
-                continue;
-            const auto& child = findComponent(childIdString);
-            if (nullptr == child)
-                continue;
-            if ("partId" == String::valueOrEmpty(*child, "linkDataType")) {
-                auto partIdString = String::valueOrEmpty(*child, "linkData");
-                auto findPart = m_snapshot->parts.find(partIdString);
-                if (findPart != m_snapshot->parts.end()) {
-                    if ("StitchingLine" == String::valueOrEmpty(findPart->second, "target")) {
-                        stitchingParts.emplace_back(partIdString);
+        for (const auto& childIndex : component->childIndices) {
+            const auto& child = m_compiledSnapshot->components()[childIndex];
+            const std::string& childIdString = child.idString;
+            if (child.linksToPart) {
+                const CompiledSnapshot::Part* part = m_compiledSnapshot->findPart(child.linkedPartIdString);
+                if (nullptr != part) {
+                    if (PartTarget::StitchingLine == part->target) {
+                        stitchingParts.emplace_back(child.linkedPartIdString);
                         stitchingComponents.emplace_back(childIdString);
                         continue;
                     }
                 }
             }
-            auto combineMode = componentCombineMode(child);
+            auto combineMode = child.combineMode;
             if (lastCombineMode != combineMode || lastCombineMode == CombineMode::Inversion) {
                 combineGroups.push_back({ combineMode, {} });
                 ++currentGroupIndex;
@@ -840,17 +748,35 @@ std::unique_ptr<MeshState> MeshGenerator::combineComponentMesh(const std::string
             }
             combineGroups[currentGroupIndex].second.push_back(childIdString);
         }
-        std::vector<std::tuple<std::unique_ptr<MeshState>, CombineMode, std::string>> groupMeshes;
-        for (const auto& group : combineGroups) {
-            auto childMesh = combineComponentChildGroupMesh(group.second, componentCache);
+        std::vector<std::unique_ptr<MeshState>> childGroupMeshes(combineGroups.size());
+        std::vector<GeneratedComponent> childGroupCaches(combineGroups.size());
+        std::unique_ptr<MeshState> stitchingMesh;
+        GeneratedComponent stitchingCache;
+        {
+            TaskGroup taskGroup(m_threadBudget.get());
+            for (size_t i = 0; i < combineGroups.size(); ++i) {
+                taskGroup.run([&, i]() {
+                    childGroupMeshes[i] = combineComponentChildGroupMesh(combineGroups[i].second, childGroupCaches[i]);
+                });
+            }
+            if (!stitchingParts.empty()) {
+                taskGroup.run([&]() {
+                    stitchingMesh = combineStitchingMesh(stitchingParts, stitchingComponents, stitchingCache);
+                });
+            }
+        }
+        std::vector<std::tuple<std::unique_ptr<MeshState>, CombineMode, std::string, std::vector<std::string>>> groupMeshes;
+        for (size_t i = 0; i < combineGroups.size(); ++i) {
+            mergeComponentCache(componentCache, childGroupCaches[i]);
+            auto& childMesh = childGroupMeshes[i];
             if (nullptr == childMesh || childMesh->isNull())
                 continue;
-            groupMeshes.emplace_back(std::make_tuple(std::move(childMesh), group.first, String::join(group.second, "|")));
+            groupMeshes.emplace_back(std::make_tuple(std::move(childMesh), combineGroups[i].first, String::join(combineGroups[i].second, "|"), combineGroups[i].second));
         }
         if (!stitchingParts.empty()) {
-            auto stitchingMesh = combineStitchingMesh(stitchingParts, stitchingComponents, componentCache);
+            mergeComponentCache(componentCache, stitchingCache);
             if (stitchingMesh && !stitchingMesh->isNull()) {
-                groupMeshes.emplace_back(std::make_tuple(std::move(stitchingMesh), CombineMode::Normal, String::join(stitchingComponents, ":")));
+                groupMeshes.emplace_back(std::make_tuple(std::move(stitchingMesh), CombineMode::Normal, String::join(stitchingComponents, ":"), stitchingComponents));
             }
         }
         mesh = combineMultipleMeshes(std::move(groupMeshes));
@@ -861,7 +787,7 @@ std::unique_ptr<MeshState> MeshGenerator::combineComponentMesh(const std::string
     }
 
     if (nullptr != mesh)
-        componentCache.mesh = std::make_unique<MeshState>(*mesh);
+        componentCache.mesh = mesh->share();
 
     if (nullptr != mesh && mesh->isNull()) {
         mesh.reset();
@@ -870,84 +796,233 @@ std::unique_ptr<MeshState> MeshGenerator::combineComponentMesh(const std::string
     return mesh;
 }
 
-std::unique_ptr<MeshState> MeshGenerator::combineMultipleMeshes(std::vector<std::tuple<std::unique_ptr<MeshState>, CombineMode, std::string>>&& multipleMeshes)
+std::unique_ptr<MeshState> MeshGenerator::combineTwoMeshes(const MeshState& first, const MeshState& second,
+    MeshCombiner::Method method, const std::string& combinationIdString,
+    const std::vector<std::string>& componentIdStrings)
 {
-    std::unique_ptr<MeshState> mesh;
-    std::string meshIdStrings;
-    for (auto& it : multipleMeshes) {
-        auto subMesh = std::move(std::get<0>(it));
-        const auto& childCombineMode = std::get<1>(it);
-        const std::string& subMeshIdString = std::get<2>(it);
-        if (nullptr == subMesh || subMesh->isNull()) {
+    {
+        std::lock_guard<std::mutex> lock(m_cacheContext->mutex);
+        auto findCached = m_cacheContext->cachedCombination.find(combinationIdString);
+        if (findCached != m_cacheContext->cachedCombination.end()) {
+            if (nullptr == findCached->second.mesh)
+                return nullptr;
+            return findCached->second.mesh->share();
+        }
+    }
+    // Combinations of meshes with known content are looked up on disk, they only depend on their operands
+    uint64_t contentHash = 0;
+    if (nullptr != m_diskCache && 0 != first.contentHash && 0 != second.contentHash) {
+        ContentHasher hasher;
+        hasher.addInteger(m_diskCacheKeyVersion);
+        hasher.addInteger((uint64_t)method);
+        hasher.addInteger(first.contentHash);
+        hasher.addInteger(second.contentHash);
+        contentHash = hasher.result();
+    }
+    std::unique_ptr<MeshState> newMesh;
+    if (0 == contentHash || !m_diskCache->loadMesh(contentHash, &newMesh)) {
+        newMesh = MeshState::combine(first, second, method, m_threadBudget.get());
+        if (nullptr != newMesh && newMesh->isNull())
+            newMesh.reset();
+        if (0 != contentHash)
+            m_diskCache->storeMesh(contentHash, newMesh.get());
+    }
+    if (nullptr != newMesh)
+        newMesh->contentHash = contentHash;
+    std::lock_guard<std::mutex> lock(m_cacheContext->mutex);
+    auto insertResult = m_cacheContext->cachedCombination.insert({ combinationIdString,
+        CachedCombination { nullptr == newMesh ? nullptr : newMesh->share(), componentIdStrings } });
+    if (insertResult.second) {
+        for (const auto& componentIdString : componentIdStrings)
+            m_cacheContext->componentCombinationIds[componentIdString].insert(combinationIdString);
+    }
+    return newMesh;
+}
+
+void MeshGenerator::removeCachedCombinations(const std::string& componentIdString)
+{
+    auto findCombinationIds = m_cacheContext->componentCombinationIds.find(componentIdString);
+    if (findCombinationIds == m_cacheContext->componentCombinationIds.end())
+        return;
+    for (const auto& combinationIdString : findCombinationIds->second) {
+        auto findCached = m_cacheContext->cachedCombination.find(combinationIdString);
+        if (findCached == m_cacheContext->cachedCombination.end())
             continue;
+        for (const auto& dependencyIdString : findCached->second.componentIdStrings) {
+            if (dependencyIdString == componentIdString)
+                continue;
+            auto findDependency = m_cacheContext->componentCombinationIds.find(dependencyIdString);
+            if (findDependency != m_cacheContext->componentCombinationIds.end())
+                findDependency->second.erase(combinationIdString);
         }
-        if (nullptr == mesh) {
-            mesh = std::move(subMesh);
-            meshIdStrings = subMeshIdString;
+        m_cacheContext->cachedCombination.erase(findCached);
+    }
+    m_cacheContext->componentCombinationIds.erase(findCombinationIds);
+}
+
+std::unique_ptr<MeshState> MeshGenerator::combineMultipleMeshes(std::vector<std::tuple<std::unique_ptr<MeshState>, CombineMode, std::string, std::vector<std::string>>>&& multipleMeshes)
+{
+    struct Operand {
+        std::unique_ptr<MeshState> mesh;
+        std::string idString;
+        std::vector<std::string> componentIdStrings;
+        bool isCombined = false;
+    };
+    auto operandIdString = [](const Operand& operand) {
+        return operand.isCombined ? "(" + operand.idString + ")" : operand.idString;
+    };
+    auto shareOperand = [](const Operand& operand) {
+        return Operand { operand.mesh->share(), operand.idString, operand.componentIdStrings, operand.isCombined };
+    };
+
+    // The first mesh is always the base, whatever its combine mode is
+    std::vector<Operand> sources;
+    std::vector<MeshCombiner::Method> methods;
+    for (auto& it : multipleMeshes) {
+        auto& subMesh = std::get<0>(it);
+        if (nullptr == subMesh || subMesh->isNull())
             continue;
+        methods.push_back((sources.empty() || CombineMode::Inversion != std::get<1>(it)) ? MeshCombiner::Method::Union : MeshCombiner::Method::Diff);
+        sources.push_back(Operand { std::move(subMesh), std::get<2>(it), std::move(std::get<3>(it)) });
+    }
+    if (sources.empty())
+        return nullptr;
+
+    auto combineOperands = [&](const Operand& first, const Operand& second, MeshCombiner::Method method, Operand* result) {
+        std::string combinationIdString = operandIdString(first) + (MeshCombiner::Method::Union == method ? "+" : "-") + operandIdString(second);
+        std::vector<std::string> componentIdStrings = first.componentIdStrings;
+        componentIdStrings.insert(componentIdStrings.end(), second.componentIdStrings.begin(), second.componentIdStrings.end());
+        auto newMesh = combineTwoMeshes(*first.mesh, *second.mesh, method, combinationIdString, componentIdStrings);
+        if (nullptr == newMesh)
+            return false;
+        *result = Operand { std::move(newMesh), combinationIdString, std::move(componentIdStrings), true };
+        return true;
+    };
+
+    // Left fold, a mesh which fails to combine is left out
+    auto foldSources = [&]() {
+        Operand result = shareOperand(sources[0]);
+        for (size_t i = 1; i < sources.size(); ++i) {
+            Operand combined;
+            if (combineOperands(result, sources[i], methods[i], &combined))
+                result = std::move(combined);
+            else
+                m_isSuccessful = false;
         }
-        auto combinerMethod = childCombineMode == CombineMode::Inversion ? MeshCombiner::Method::Diff : MeshCombiner::Method::Union;
-        auto combinerMethodString = combinerMethod == MeshCombiner::Method::Union ? "+" : "-";
-        meshIdStrings += combinerMethodString + subMeshIdString;
-        std::unique_ptr<MeshState> newMesh;
-        auto findCached = m_cacheContext->cachedCombination.find(meshIdStrings);
-        if (findCached != m_cacheContext->cachedCombination.end()) {
-            if (nullptr != findCached->second) {
-                newMesh = std::make_unique<MeshState>(*findCached->second);
+        return result;
+    };
+
+    // Union is order independent, so consecutive unions are grouped into runs and each run is reduced pairwise
+    // as a balanced tree, which keeps operands small and lets the pairs of one level run concurrently.
+    // A diff stands alone, it must see everything before it.
+    // Whether a boolean operation succeeds depends on how the meshes are grouped, so when any combination
+    // of the tree fails, the meshes are folded from left to right instead, which drops no more than the fold does.
+    auto reduceBalanced = [&]() {
+        std::vector<std::pair<MeshCombiner::Method, std::vector<Operand>>> runs;
+        for (size_t i = 0; i < sources.size(); ++i) {
+            if (runs.empty() || MeshCombiner::Method::Diff == methods[i] || MeshCombiner::Method::Diff == runs.back().first)
+                runs.emplace_back(methods[i], std::vector<Operand>());
+            runs.back().second.push_back(shareOperand(sources[i]));
+        }
+        std::atomic<bool> hasFailure = false;
+        auto reduceUnionRun = [&](std::vector<Operand>& operands) {
+            while (operands.size() > 1 && !hasFailure) {
+                std::vector<Operand> reducedOperands((operands.size() + 1) / 2);
+                {
+                    TaskGroup taskGroup(m_threadBudget.get());
+                    for (size_t i = 0; i + 1 < operands.size(); i += 2) {
+                        taskGroup.run([&, i]() {
+                            if (!combineOperands(operands[i], operands[i + 1], MeshCombiner::Method::Union, &reducedOperands[i / 2]))
+                                hasFailure = true;
+                        });
+                    }
+                }
+                if (0 != operands.size() % 2)
+                    reducedOperands.back() = std::move(operands.back());
+                operands = std::move(reducedOperands);
+            }
+        };
+        {
+            TaskGroup taskGroup(m_threadBudget.get());
+            for (size_t i = 0; i < runs.size(); ++i) {
+                if (runs[i].second.size() <= 1)
+                    continue;
+                taskGroup.run([&, i]() {
+                    reduceUnionRun(runs[i].second);
+                });
             }
-        } else {
-            newMesh = MeshState::combine(*mesh,
-                *subMesh,
-                combinerMethod);
-            if (nullptr != newMesh)
-                m_cacheContext->cachedCombination.insert({ meshIdStrings, std::make_unique<MeshState>(*newMesh) });
-            else
-                m_cacheContext->cachedCombination.insert({ meshIdStrings, nullptr });
         }
-        if (newMesh && !newMesh->isNull()) {
-            mesh = std::move(newMesh);
-        } else {
-            m_isSuccessful = false;
+        Operand result;
+        if (!hasFailure) {
+            result = std::move(runs[0].second[0]);
+            for (size_t i = 1; i < runs.size(); ++i) {
+                Operand combined;
+                if (!combineOperands(result, runs[i].second[0], runs[i].first, &combined)) {
+                    hasFailure = true;
+                    break;
+                }
+                result = std::move(combined);
+            }
         }
-    }
-    if (nullptr != mesh && mesh->isNull()) {
-        mesh.reset();
-    }
-    return mesh;
+        if (hasFailure)
+            return foldSources();
+        return result;
+    };
+
+    Operand result = m_balancedUnionEnabled ? reduceBalanced() : foldSources();
+    if (nullptr != result.mesh && result.mesh->isNull())
+        return nullptr;
+    return std::move(result.mesh);
 }
 
 std::unique_ptr<MeshState> MeshGenerator::combineComponentChildGroupMesh(const std::vector<std::string>& componentIdStrings, GeneratedComponent& componentCache)
 {
-    std::vector<std::tuple<std::unique_ptr<MeshState>, CombineMode, std::string>> multipleMeshes;
-    for (const auto& childIdString : componentIdStrings) {
-        CombineMode childCombineMode = CombineMode::Normal;
-        std::unique_ptr<MeshState> subMesh = combineComponentMesh(childIdString, &childCombineMode);
+    std::vector<std::unique_ptr<MeshState>> subMeshes(componentIdStrings.size());
+    std::vector<CombineMode> childCombineModes(componentIdStrings.size(), CombineMode::Normal);
+    {
+        TaskGroup taskGroup(m_threadBudget.get());
+        for (size_t i = 0; i < componentIdStrings.size(); ++i) {
+            taskGroup.run([&, i]() {
+                subMeshes[i] = combineComponentMesh(componentIdStrings[i], &childCombineModes[i]);
+            });
+        }
+    }
+
+    std::vector<std::tuple<std::unique_ptr<MeshState>, CombineMode, std::string, std::vector<std::string>>> multipleMeshes;
+    for (size_t i = 0; i < componentIdStrings.size(); ++i) {
+        const auto& childIdString = componentIdStrings[i];
+        CombineMode childCombineMode = childCombineModes[i];
+        std::unique_ptr<MeshState>& subMesh = subMeshes[i];
 
         if (CombineMode::Uncombined == childCombineMode) {
             continue;
         }
 
-        const auto& childComponentCache = m_cacheContext->components[childIdString];
-        for (const auto& vertex : childComponentCache.noneSeamVertices)
-            componentCache.noneSeamVertices.insert(vertex);
-        for (const auto& it : childComponentCache.sharedQuadEdges)
-            componentCache.sharedQuadEdges.insert(it);
-        for (const auto& it : childComponentCache.partTriangleUvs)
-            componentCache.partTriangleUvs.insert({ it.first, it.second });
-        for (const auto& it : childComponentCache.positionToNodeIdMap)
-            componentCache.positionToNodeIdMap.emplace(it);
-        for (const auto& it : childComponentCache.nodeMap)
-            componentCache.nodeMap.emplace(it);
+        mergeComponentCache(componentCache, this->componentCache(childIdString));
 
         if (nullptr == subMesh || subMesh->isNull()) {
             continue;
         }
 
-        multipleMeshes.emplace_back(std::make_tuple(std::move(subMesh), childCombineMode, childIdString));
+        multipleMeshes.emplace_back(std::make_tuple(std::move(subMesh), childCombineMode, childIdString, std::vector<std::string> { childIdString }));
     }
     return combineMultipleMeshes(std::move(multipleMeshes));
 }
 
+void MeshGenerator::mergeComponentCache(GeneratedComponent& componentCache, const GeneratedComponent& childComponentCache)
+{
+    for (const auto& vertex : childComponentCache.noneSeamVertices)
+        componentCache.noneSeamVertices.insert(vertex);
+    for (const auto& it : childComponentCache.sharedQuadEdges)
+        componentCache.sharedQuadEdges.insert(it);
+    for (const auto& it : childComponentCache.partTriangleUvs)
+        componentCache.partTriangleUvs.insert({ it.first, it.second });
+    for (const auto& it : childComponentCache.positionToNodeIdMap)
+        componentCache.positionToNodeIdMap.emplace(it);
+    for (const auto& it : childComponentCache.nodeMap)
+        componentCache.nodeMap.emplace(it);
+}
+
 void MeshGenerator::makeXmirror(const std::vector<Vector3>& sourceVertices, const std::vector<std::vector<size_t>>& sourceFaces,
     std::vector<Vector3>* destVertices, std::vector<std::vector<size_t>>* destFaces)
 {
@@ -962,7 +1037,7 @@ void MeshGenerator::makeXmirror(const std::vector<Vector3>& sourceVertices, cons
     }
 }
 
-void MeshGenerator::collectSharedQuadEdges(const std::vector<Vector3>& vertices, const std::vector<std::vector<size_t>>& faces,
+void MeshGenerator::collectSharedQuadEdges(const std::vector<Vector3>& vertices, const IndexedPolygons& faces,
     std::set<std::pair<PositionKey, PositionKey>>* sharedQuadEdges)
 {
     for (const auto& face : faces) {
@@ -990,37 +1065,104 @@ void MeshGenerator::setWeldEnabled(bool enabled)
     m_weldEnabled = enabled;
 }
 
-void MeshGenerator::postprocessObject(Object* object)
+void MeshGenerator::setBalancedUnionEnabled(bool enabled)
+{
+    m_balancedUnionEnabled = enabled;
+}
+
+void MeshGenerator::setThreadCount(size_t threadCount)
 {
-    std::vector<Vector3> combinedFacesNormals;
-    for (const auto& face : object->triangles) {
-        combinedFacesNormals.push_back(Vector3::normal(
-            object->vertices[face[0]],
-            object->vertices[face[1]],
-            object->vertices[face[2]]));
+    if (threadCount <= 1) {
+        m_threadBudget.reset();
+        return;
     }
+    m_threadBudget = std::make_unique<ThreadBudget>(threadCount);
+}
 
-    object->triangleNormals = combinedFacesNormals;
+void MeshGenerator::setDiskCache(const MeshDiskCache* diskCache)
+{
+    m_diskCache = diskCache;
+}
 
-    object->vertexColors.resize(object->vertices.size(), Color::createWhite());
-    object->vertexSmoothCutoffDegrees.resize(object->vertices.size(), 0.0f);
-    for (size_t i = 0; i < object->vertices.size(); ++i) {
-        auto findSourceNode = object->positionToNodeIdMap.find(object->vertices[i]);
-        if (findSourceNode == object->positionToNodeIdMap.end())
+void MeshGenerator::postprocessObjectRegion(const Object& object, const ObjectRegion& region, PostprocessedRegion* postprocessedRegion)
+{
+    std::vector<Vector3> vertices(object.vertices.begin() + region.vertexBegin, object.vertices.begin() + region.vertexEnd);
+    std::vector<std::vector<size_t>> triangles(object.triangles.begin() + region.triangleBegin, object.triangles.begin() + region.triangleEnd);
+    for (auto& triangle : triangles) {
+        for (auto& index : triangle)
+            index -= region.vertexBegin;
+    }
+
+    postprocessedRegion->triangleNormals.clear();
+    postprocessedRegion->triangleNormals.reserve(triangles.size());
+    for (const auto& face : triangles) {
+        postprocessedRegion->triangleNormals.push_back(Vector3::normal(
+            vertices[face[0]],
+            vertices[face[1]],
+            vertices[face[2]]));
+    }
+
+    // Looked up in the maps of the component the region came from, so the result only depends on the region itself
+    postprocessedRegion->vertexColors.assign(vertices.size(), Color::createWhite());
+    postprocessedRegion->vertexSmoothCutoffDegrees.assign(vertices.size(), 0.0f);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        auto findSourceNode = region.componentCache->positionToNodeIdMap.find(vertices[i]);
+        if (findSourceNode == region.componentCache->positionToNodeIdMap.end())
             continue;
-        auto findObjectNode = object->nodeMap.find(findSourceNode->second);
-        if (findObjectNode == object->nodeMap.end())
+        auto findObjectNode = region.componentCache->nodeMap.find(findSourceNode->second);
+        if (findObjectNode == region.componentCache->nodeMap.end())
             continue;
-        object->vertexColors[i] = findObjectNode->second.color;
-        object->vertexSmoothCutoffDegrees[i] = findObjectNode->second.smoothCutoffDegrees;
+        postprocessedRegion->vertexColors[i] = findObjectNode->second.color;
+        postprocessedRegion->vertexSmoothCutoffDegrees[i] = findObjectNode->second.smoothCutoffDegrees;
     }
 
-    std::vector<std::vector<Vector3>> triangleVertexNormals;
-    smoothNormal(object->vertices,
-        object->triangles,
-        object->triangleNormals,
-        &object->vertexSmoothCutoffDegrees,
-        &triangleVertexNormals);
+    postprocessedRegion->triangleVertexNormals.clear();
+    smoothNormal(vertices,
+        triangles,
+        postprocessedRegion->triangleNormals,
+        &postprocessedRegion->vertexSmoothCutoffDegrees,
+        &postprocessedRegion->triangleVertexNormals,
+        m_threadBudget.get());
+}
+
+void MeshGenerator::postprocessObject(Object* object)
+{
+    object->triangleNormals.resize(object->triangles.size());
+    object->vertexColors.resize(object->vertices.size(), Color::createWhite());
+    object->vertexSmoothCutoffDegrees.resize(object->vertices.size(), 0.0f);
+    std::vector<std::vector<Vector3>> triangleVertexNormals(object->triangles.size(), { Vector3(), Vector3(), Vector3() });
+
+    // Regions never share vertices, so each one is postprocessed on its own, and the ones generated from
+    // an unchanged mesh reuse the result of the previous generation
+    std::map<std::string, PostprocessedRegion> postprocessedRegions;
+    for (const auto& region : m_objectRegions) {
+        PostprocessedRegion postprocessedRegion;
+        auto findCached = m_cacheContext->postprocessedRegions.find(region.componentIdString);
+        if (findCached != m_cacheContext->postprocessedRegions.end()
+            && nullptr != findCached->second.mesh
+            && findCached->second.mesh->sharesGeometryWith(*region.mesh)
+            && findCached->second.welded == region.welded
+            && findCached->second.triangleNormals.size() == region.triangleEnd - region.triangleBegin
+            && findCached->second.vertexColors.size() == region.vertexEnd - region.vertexBegin) {
+            postprocessedRegion = std::move(findCached->second);
+        } else {
+            postprocessObjectRegion(*object, region, &postprocessedRegion);
+            postprocessedRegion.mesh = region.mesh->share();
+            postprocessedRegion.welded = region.welded;
+        }
+        std::copy(postprocessedRegion.triangleNormals.begin(), postprocessedRegion.triangleNormals.end(),
+            object->triangleNormals.begin() + region.triangleBegin);
+        std::copy(postprocessedRegion.vertexColors.begin(), postprocessedRegion.vertexColors.end(),
+            object->vertexColors.begin() + region.vertexBegin);
+        std::copy(postprocessedRegion.vertexSmoothCutoffDegrees.begin(), postprocessedRegion.vertexSmoothCutoffDegrees.end(),
+            object->vertexSmoothCutoffDegrees.begin() + region.vertexBegin);
+        std::copy(postprocessedRegion.triangleVertexNormals.begin(), postprocessedRegion.triangleVertexNormals.end(),
+            triangleVertexNormals.begin() + region.triangleBegin);
+        if (m_cacheEnabled)
+            postprocessedRegions.emplace(region.componentIdString, std::move(postprocessedRegion));
+    }
+    m_cacheContext->postprocessedRegions = std::move(postprocessedRegions);
+
     object->setTriangleVertexNormals(triangleVertexNormals);
 }
 
@@ -1058,22 +1200,27 @@ void MeshGenerator::collectIncombinableMesh(const MeshState* mesh, const Generat
     m_object->triangleAndQuads.insert(m_object->triangleAndQuads.end(), uncombinedTriangleAndQuads.begin(), uncombinedTriangleAndQuads.end());
 }
 
-void MeshGenerator::collectUncombinedComponent(const std::string& componentIdString)
+void MeshGenerator::collectUncombinedComponent(const CompiledSnapshot::Component& component)
 {
-    const auto& component = findComponent(componentIdString);
-    if (CombineMode::Uncombined == componentCombineMode(component)) {
-        const auto& componentCache = m_cacheContext->components[componentIdString];
+    if (CombineMode::Uncombined == component.combineMode) {
+        const auto& componentCache = m_cacheContext->components[component.idString];
         if (nullptr == componentCache.mesh || componentCache.mesh->isNull()) {
             return;
         }
+        ObjectRegion region;
+        region.componentIdString = component.idString;
+        region.mesh = componentCache.mesh.get();
+        region.componentCache = &componentCache;
+        region.vertexBegin = m_object->vertices.size();
+        region.triangleBegin = m_object->triangles.size();
         collectIncombinableMesh(componentCache.mesh.get(), componentCache);
+        region.vertexEnd = m_object->vertices.size();
+        region.triangleEnd = m_object->triangles.size();
+        m_objectRegions.push_back(std::move(region));
         return;
     }
-    for (const auto& childIdString : String::split(String::valueOrEmpty(*component, "children"), ',')) {
-        if (childIdString.empty())
-            continue;
-        collectUncombinedComponent(childIdString);
-    }
+    for (const auto& childIndex : component.childIndices)
+        collectUncombinedComponent(m_compiledSnapshot->components()[childIndex]);
 }
 
 void MeshGenerator::setDefaultPartColor(const Color& color)
@@ -1161,6 +1308,7 @@ void MeshGenerator::preprocessMirror()
 
 void MeshGenerator::addComponentPreview(const Uuid& componentId, ComponentPreview&& preview)
 {
+    std::lock_guard<std::mutex> lock(m_previewMutex);
     m_generatedPreviewComponentIds.insert(componentId);
     m_generatedComponentPreviews[componentId] = std::move(preview);
 }
@@ -1172,14 +1320,16 @@ void MeshGenerator::generate()
 
     m_isSuccessful = true;
 
-    m_mainProfileMiddleX = String::toFloat(String::valueOrEmpty(m_snapshot->canvas, "originX"));
-    m_mainProfileMiddleY = String::toFloat(String::valueOrEmpty(m_snapshot->canvas, "originY"));
-    m_sideProfileMiddleX = String::toFloat(String::valueOrEmpty(m_snapshot->canvas, "originZ"));
-
     preprocessMirror();
 
+    m_compiledSnapshot = std::make_unique<CompiledSnapshot>(*m_snapshot);
+    m_mainProfileMiddleX = m_compiledSnapshot->originX();
+    m_mainProfileMiddleY = m_compiledSnapshot->originY();
+    m_sideProfileMiddleX = m_compiledSnapshot->originZ();
+
     m_object = new Object;
     m_object->meshId = m_id;
+    m_objectRegions.clear();
 
     bool needDeleteCacheContext = false;
     if (nullptr == m_cacheContext) {
@@ -1204,13 +1354,7 @@ void MeshGenerator::generate()
         }
         for (auto it = m_cacheContext->components.begin(); it != m_cacheContext->components.end();) {
             if (m_snapshot->components.find(it->first) == m_snapshot->components.end()) {
-                for (auto combinationIt = m_cacheContext->cachedCombination.begin(); combinationIt != m_cacheContext->cachedCombination.end();) {
-                    if (std::string::npos != combinationIt->first.find(it->first)) {
-                        combinationIt = m_cacheContext->cachedCombination.erase(combinationIt);
-                        continue;
-                    }
-                    combinationIt++;
-                }
+                removeCachedCombinations(it->first);
                 it = m_cacheContext->components.erase(it);
                 continue;
             }
@@ -1218,18 +1362,10 @@ void MeshGenerator::generate()
         }
     }
 
-    collectParts();
     checkDirtyFlags();
 
-    for (const auto& dirtyComponentId : m_dirtyComponentIds) {
-        for (auto combinationIt = m_cacheContext->cachedCombination.begin(); combinationIt != m_cacheContext->cachedCombination.end();) {
-            if (std::string::npos != combinationIt->first.find(dirtyComponentId)) {
-                combinationIt = m_cacheContext->cachedCombination.erase(combinationIt);
-                continue;
-            }
-            combinationIt++;
-        }
-    }
+    for (const auto& dirtyComponentId : m_dirtyComponentIds)
+        removeCachedCombinations(dirtyComponentId);
 
     m_dirtyComponentIds.insert(to_string(Uuid()));
 
@@ -1246,28 +1382,27 @@ void MeshGenerator::generate()
     std::vector<std::vector<size_t>> combinedFaces;
     if (nullptr != combinedMesh) {
         combinedMesh->fetch(combinedVertices, combinedFaces);
-        m_object->seamTriangleUvs = combinedMesh->seamTriangleUvs;
-        if (m_weldEnabled) {
-            size_t totalAffectedNum = 0;
-            size_t affectedNum = 0;
-            do {
-                std::vector<Vector3> weldedVertices;
-                std::vector<std::vector<size_t>> weldedFaces;
-                affectedNum = weldVertices(combinedVertices, combinedFaces,
-                    m_minimalRadius, componentCache.noneSeamVertices,
-                    weldedVertices, weldedFaces);
-                combinedVertices = weldedVertices;
-                combinedFaces = weldedFaces;
-                totalAffectedNum += affectedNum;
-            } while (affectedNum > 0);
-        }
+        m_object->seamTriangleUvs.reserve(combinedMesh->seamTriangleUvs.size());
+        for (const auto& it : combinedMesh->seamTriangleUvs)
+            m_object->seamTriangleUvs.push_back(*it);
+        if (m_weldEnabled)
+            weldVertices(combinedVertices, combinedFaces, m_minimalRadius, componentCache.noneSeamVertices);
         recoverQuads(combinedVertices, combinedFaces, componentCache.sharedQuadEdges, m_object->triangleAndQuads);
         m_object->vertices = combinedVertices;
         m_object->triangles = combinedFaces;
+
+        ObjectRegion region;
+        region.componentIdString = to_string(Uuid());
+        region.mesh = combinedMesh.get();
+        region.componentCache = &componentCache;
+        region.welded = m_weldEnabled;
+        region.vertexEnd = m_object->vertices.size();
+        region.triangleEnd = m_object->triangles.size();
+        m_objectRegions.push_back(std::move(region));
     }
 
     // Recursively check uncombined components
-    collectUncombinedComponent(to_string(Uuid()));
+    collectUncombinedComponent(m_compiledSnapshot->rootComponent());
 
     postprocessObject(m_object);
 
@@ -24,13 +24,20 @@
 #define DUST3D_MESH_MESH_GENERATOR_H_
 
 #include <dust3d/base/combine_mode.h>
+#include <dust3d/base/compiled_snapshot.h>
+#include <dust3d/base/indexed_mesh.h>
 #include <dust3d/base/object.h>
 #include <dust3d/base/position_key.h>
 #include <dust3d/base/snapshot.h>
+#include <dust3d/base/spatial_hash_map.h>
+#include <dust3d/base/task_group.h>
 #include <dust3d/base/uuid.h>
 #include <dust3d/mesh/mesh_combiner.h>
+#include <dust3d/mesh/mesh_disk_cache.h>
 #include <dust3d/mesh/mesh_node.h>
 #include <dust3d/mesh/mesh_state.h>
+#include <atomic>
+#include <mutex>
 #include <set>
 #include <tuple>
 #include <unordered_map>
@@ -41,13 +48,15 @@ namespace dust3d {
 class MeshGenerator {
 public:
     static double m_minimalRadius;
+    // Mixed into every disk cache key, bump it whenever tubes, stitching or combining change their output
+    static const uint64_t m_diskCacheKeyVersion;
 
     struct GeneratedPart {
         std::vector<Vector3> vertices;
-        std::map<PositionKey, Uuid> positionToNodeIdMap;
+        SpatialHashMap<PositionKey, Uuid> positionToNodeIdMap;
         std::map<Uuid, ObjectNode> nodeMap;
-        std::vector<std::vector<size_t>> faces;
-        std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>> triangleUvs;
+        IndexedPolygons faces;
+        SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>> triangleUvs;
         Color color = Color(1.0, 1.0, 1.0);
         float metalness = 0.0;
         float roughness = 1.0;
@@ -71,10 +80,10 @@ public:
     struct GeneratedComponent {
         std::unique_ptr<MeshState> mesh;
         std::set<std::pair<PositionKey, PositionKey>> sharedQuadEdges;
-        std::unordered_map<Uuid, std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>>> partTriangleUvs;
-        std::vector<std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>>> seamTriangleUvs;
+        std::unordered_map<Uuid, SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>>> partTriangleUvs;
+        std::vector<SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>>> seamTriangleUvs;
         std::set<PositionKey> noneSeamVertices;
-        std::map<PositionKey, Uuid> positionToNodeIdMap;
+        SpatialHashMap<PositionKey, Uuid> positionToNodeIdMap;
         std::map<Uuid, ObjectNode> nodeMap;
         void reset()
         {
@@ -88,17 +97,38 @@ public:
         }
     };
 
+    struct CachedCombination {
+        std::unique_ptr<MeshState> mesh;
+        std::vector<std::string> componentIdStrings;
+    };
+
+    // Normals and colors of the object triangles and vertices that came from one mesh,
+    // reused as long as the next generation gets the same mesh again
+    struct PostprocessedRegion {
+        std::unique_ptr<MeshState> mesh;
+        bool welded = false;
+        std::vector<Vector3> triangleNormals;
+        std::vector<Color> vertexColors;
+        std::vector<float> vertexSmoothCutoffDegrees;
+        std::vector<std::vector<Vector3>> triangleVertexNormals;
+    };
+
     struct GeneratedCacheContext {
         std::map<std::string, GeneratedComponent> components;
         std::map<std::string, GeneratedPart> parts;
         std::map<std::string, std::string> partMirrorIdMap;
-        std::map<std::string, std::unique_ptr<MeshState>> cachedCombination;
+        std::map<std::string, CachedCombination> cachedCombination;
+        // Reverse index from component id to the keys of the cached combinations built from it
+        std::unordered_map<std::string, std::unordered_set<std::string>> componentCombinationIds;
+        // Keyed by the id of the component the region was collected from, the root id for the combined mesh
+        std::map<std::string, PostprocessedRegion> postprocessedRegions;
+        std::mutex mutex;
     };
 
     struct ComponentPreview {
         std::vector<Vector3> vertices;
         std::vector<std::vector<size_t>> triangles;
-        std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>> triangleUvs;
+        SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>> triangleUvs;
         Color color = Color(1.0, 1.0, 1.0);
         float metalness = 0.0;
         float roughness = 1.0;
@@ -118,6 +148,9 @@ public:
     void setDefaultPartColor(const Color& color);
     void setId(uint64_t id);
     void setWeldEnabled(bool enabled);
+    void setBalancedUnionEnabled(bool enabled);
+    void setThreadCount(size_t threadCount);
+    void setDiskCache(const MeshDiskCache* diskCache);
     uint64_t id();
 
 protected:
@@ -126,25 +159,42 @@ protected:
     Object* m_object = nullptr;
 
 private:
+    // Contiguous range of the object vertices and triangles generated from one mesh
+    struct ObjectRegion {
+        std::string componentIdString;
+        const MeshState* mesh = nullptr;
+        const GeneratedComponent* componentCache = nullptr;
+        bool welded = false;
+        size_t vertexBegin = 0;
+        size_t vertexEnd = 0;
+        size_t triangleBegin = 0;
+        size_t triangleEnd = 0;
+    };
+
     Color m_defaultPartColor = Color::createWhite();
     Snapshot* m_snapshot = nullptr;
+    std::unique_ptr<CompiledSnapshot> m_compiledSnapshot;
     GeneratedCacheContext* m_cacheContext = nullptr;
     std::set<std::string> m_dirtyComponentIds;
     std::set<std::string> m_dirtyPartIds;
     float m_mainProfileMiddleX = 0;
     float m_sideProfileMiddleX = 0;
     float m_mainProfileMiddleY = 0;
-    std::map<std::string, std::set<std::string>> m_partNodeIds;
-    std::map<std::string, std::set<std::string>> m_partEdgeIds;
-    bool m_isSuccessful = false;
+    std::atomic<bool> m_isSuccessful = false;
     bool m_cacheEnabled = false;
     float m_smoothShadingThresholdAngleDegrees = 60;
     uint64_t m_id = 0;
     bool m_weldEnabled = true;
-
-    void collectParts();
+    bool m_balancedUnionEnabled = false;
+    std::unique_ptr<ThreadBudget> m_threadBudget;
+    const MeshDiskCache* m_diskCache = nullptr;
+    std::vector<ObjectRegion> m_objectRegions;
+    std::mutex m_previewMutex;
+
+    GeneratedComponent& componentCache(const std::string& componentIdString);
+    GeneratedPart& partCache(const std::string& partIdString);
     void collectIncombinableMesh(const MeshState* mesh, const GeneratedComponent& componentCache);
-    bool checkIsComponentDirty(const std::string& componentIdString);
+    bool checkIsComponentDirty(const CompiledSnapshot::Component& component);
     bool checkIsPartDirty(const std::string& partIdString);
     bool checkIsPartDependencyDirty(const std::string& partIdString);
     void checkDirtyFlags();
@@ -154,19 +204,23 @@ private:
     std::unique_ptr<MeshState> combineComponentMesh(const std::string& componentIdString, CombineMode* combineMode);
     void makeXmirror(const std::vector<Vector3>& sourceVertices, const std::vector<std::vector<size_t>>& sourceFaces,
         std::vector<Vector3>* destVertices, std::vector<std::vector<size_t>>* destFaces);
-    void collectSharedQuadEdges(const std::vector<Vector3>& vertices, const std::vector<std::vector<size_t>>& faces,
+    void collectSharedQuadEdges(const std::vector<Vector3>& vertices, const IndexedPolygons& faces,
         std::set<std::pair<PositionKey, PositionKey>>* sharedQuadEdges);
-    const std::map<std::string, std::string>* findComponent(const std::string& componentIdString);
-    CombineMode componentCombineMode(const std::map<std::string, std::string>* component);
     std::unique_ptr<MeshState> combineComponentChildGroupMesh(const std::vector<std::string>& componentIdStrings,
         GeneratedComponent& componentCache);
-    std::unique_ptr<MeshState> combineMultipleMeshes(std::vector<std::tuple<std::unique_ptr<MeshState>, CombineMode, std::string>>&& multipleMeshes);
+    std::unique_ptr<MeshState> combineTwoMeshes(const MeshState& first, const MeshState& second,
+        MeshCombiner::Method method, const std::string& combinationIdString,
+        const std::vector<std::string>& componentIdStrings);
+    std::unique_ptr<MeshState> combineMultipleMeshes(std::vector<std::tuple<std::unique_ptr<MeshState>, CombineMode, std::string, std::vector<std::string>>>&& multipleMeshes);
+    void removeCachedCombinations(const std::string& componentIdString);
     std::unique_ptr<MeshState> combineStitchingMesh(const std::vector<std::string>& partIdStrings,
         const std::vector<std::string>& componentIdStrings,
         GeneratedComponent& componentCache);
-    void collectUncombinedComponent(const std::string& componentIdString);
+    void collectUncombinedComponent(const CompiledSnapshot::Component& component);
+    static void mergeComponentCache(GeneratedComponent& componentCache, const GeneratedComponent& childComponentCache);
     void cutFaceStringToCutTemplate(const std::string& cutFaceString, std::vector<Vector2>& cutTemplate);
     void postprocessObject(Object* object);
+    void postprocessObjectRegion(const Object& object, const ObjectRegion& region, PostprocessedRegion* postprocessedRegion);
     void preprocessMirror();
     std::string reverseUuid(const std::string& uuidString);
     void recoverQuads(const std::vector<Vector3>& vertices, const std::vector<std::vector<size_t>>& triangles, const std::set<std::pair<PositionKey, PositionKey>>& sharedQuadEdges, std::vector<std::vector<size_t>>& triangleAndQuads);
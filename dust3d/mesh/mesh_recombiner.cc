@@ -20,18 +20,17 @@
  *  SOFTWARE.
  */
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <dust3d/base/position_key.h>
 #include <dust3d/mesh/hole_wrapper.h>
 #include <dust3d/mesh/mesh_recombiner.h>
+#include <limits>
 #include <queue>
-#include <set>
 
 namespace dust3d {
 
-#define MAX_EDGE_LOOP_LENGTH 1000
-
 void MeshRecombiner::setVertices(const std::vector<Vector3>* vertices,
     const std::vector<std::pair<MeshCombiner::Source, size_t>>* verticesSourceIndices)
 {
@@ -47,25 +46,41 @@ void MeshRecombiner::setFaces(const std::vector<std::vector<size_t>>* faces)
 bool MeshRecombiner::convertHalfEdgesToEdgeLoops(const std::vector<std::pair<size_t, size_t>>& halfEdges,
     std::vector<std::vector<size_t>>* edgeLoops)
 {
-    std::map<size_t, size_t> vertexLinkMap;
-    for (const auto& halfEdge : halfEdges) {
-        auto inserResult = vertexLinkMap.insert(halfEdge);
-        if (!inserResult.second) {
+    std::vector<std::pair<size_t, size_t>> links = halfEdges;
+    std::sort(links.begin(), links.end());
+    for (size_t i = 1; i < links.size(); ++i) {
+        if (links[i - 1].first == links[i].first)
             return false;
-        }
     }
-    while (!vertexLinkMap.empty()) {
+    std::vector<char> consumed(links.size(), 0);
+    auto findLink = [&](size_t vertex) {
+        auto it = std::lower_bound(links.begin(), links.end(), vertex,
+            [](const std::pair<size_t, size_t>& link, size_t vertex) {
+                return link.first < vertex;
+            });
+        if (it == links.end() || it->first != vertex)
+            return links.size();
+        size_t linkIndex = it - links.begin();
+        return consumed[linkIndex] ? links.size() : linkIndex;
+    };
+    std::vector<size_t> loopLinks;
+    for (size_t startLink = 0; startLink < links.size(); ++startLink) {
+        if (consumed[startLink])
+            continue;
         std::vector<size_t> edgeLoop;
-        size_t vertex = vertexLinkMap.begin()->first;
+        loopLinks.clear();
+        size_t vertex = links[startLink].first;
         size_t head = vertex;
         bool loopBack = false;
-        size_t limitLoop = MAX_EDGE_LOOP_LENGTH;
+        // No closed loop is longer than the number of links, a longer walk is stuck in a cycle missing the head
+        size_t limitLoop = links.size();
         while ((limitLoop--) > 0) {
             edgeLoop.push_back(vertex);
-            auto findNext = vertexLinkMap.find(vertex);
-            if (findNext == vertexLinkMap.end())
+            size_t linkIndex = findLink(vertex);
+            if (linkIndex == links.size())
                 break;
-            vertex = findNext->second;
+            loopLinks.push_back(linkIndex);
+            vertex = links[linkIndex].second;
             if (vertex == head) {
                 loopBack = true;
                 break;
@@ -77,52 +92,49 @@ bool MeshRecombiner::convertHalfEdgesToEdgeLoops(const std::vector<std::pair<siz
         if (edgeLoop.size() < 3) {
             return false;
         }
-        for (const auto& vertex : edgeLoop) {
-            vertexLinkMap.erase(vertex);
+        for (const auto& linkIndex : loopLinks) {
+            consumed[linkIndex] = 1;
         }
         edgeLoops->push_back(edgeLoop);
     }
     return true;
 }
 
-size_t MeshRecombiner::splitSeamVerticesToIslands(const std::map<size_t, std::vector<size_t>>& seamEdges,
-    std::map<size_t, size_t>* vertexToIslandMap)
+size_t MeshRecombiner::splitSeamVerticesToIslands(const std::vector<size_t>& seamLinkOffsets,
+    const std::vector<size_t>& seamLinks,
+    std::vector<size_t>* vertexToIslandMap)
 {
-    std::set<size_t> visited;
     size_t nextIslandId = 0;
-    for (const auto& it : seamEdges) {
-        std::queue<size_t> vertices;
-        vertices.push(it.first);
-        bool hasVertexJoin = false;
+    std::queue<size_t> vertices;
+    for (size_t startVertex = 0; startVertex + 1 < seamLinkOffsets.size(); ++startVertex) {
+        if (seamLinkOffsets[startVertex] == seamLinkOffsets[startVertex + 1])
+            continue;
+        if (std::numeric_limits<size_t>::max() != (*vertexToIslandMap)[startVertex])
+            continue;
+        vertices.push(startVertex);
         while (!vertices.empty()) {
             auto v = vertices.front();
             vertices.pop();
-            if (visited.find(v) != visited.end())
+            if (std::numeric_limits<size_t>::max() != (*vertexToIslandMap)[v])
                 continue;
-            visited.insert(v);
-            vertexToIslandMap->insert({ v, nextIslandId });
-            hasVertexJoin = true;
-            const auto findNeighbors = seamEdges.find(v);
-            if (findNeighbors != seamEdges.end()) {
-                for (const auto& neighbor : findNeighbors->second) {
-                    vertices.push(neighbor);
-                }
-            }
+            (*vertexToIslandMap)[v] = nextIslandId;
+            for (size_t i = seamLinkOffsets[v]; i < seamLinkOffsets[v + 1]; ++i)
+                vertices.push(seamLinks[i]);
         }
-        if (hasVertexJoin)
-            ++nextIslandId;
+        ++nextIslandId;
     }
     return nextIslandId;
 }
 
-bool MeshRecombiner::buildHalfEdgeToFaceMap(std::map<std::pair<size_t, size_t>, size_t>& halfEdgeToFaceMap)
+bool MeshRecombiner::buildHalfEdgeToFaceMap(HalfEdgeMap<size_t>& halfEdgeToFaceMap)
 {
     bool isSuccessful = true;
+    halfEdgeToFaceMap.reserve(m_faces->size() * 3);
     for (size_t faceIndex = 0; faceIndex < m_faces->size(); ++faceIndex) {
         const auto& face = (*m_faces)[faceIndex];
         for (size_t i = 0; i < face.size(); ++i) {
             size_t j = (i + 1) % face.size();
-            const auto insertResult = halfEdgeToFaceMap.insert({ { face[i], face[j] }, faceIndex });
+            const auto insertResult = halfEdgeToFaceMap.insert({ makeHalfEdgeKey(face[i], face[j]), faceIndex });
             if (!insertResult.second) {
                 isSuccessful = false;
             }
@@ -135,24 +147,35 @@ bool MeshRecombiner::recombine()
 {
     buildHalfEdgeToFaceMap(m_halfEdgeToFaceMap);
 
-    std::map<size_t, std::vector<size_t>> seamLink;
+    auto isSeamVertex = [&](size_t index) {
+        return MeshCombiner::Source::None == (*m_verticesSourceIndices)[index].first;
+    };
+
+    // Seam links grouped by source vertex, each group keeps the face order
+    size_t vertexCount = m_vertices->size();
+    std::vector<size_t> seamLinkOffsets(vertexCount + 1, 0);
     for (const auto& face : *m_faces) {
         for (size_t i = 0; i < face.size(); ++i) {
-            const auto& index = face[i];
-            auto source = (*m_verticesSourceIndices)[index];
-            if (MeshCombiner::Source::None == source.first) {
-                auto next = face[(i + 1) % face.size()];
-                auto nextSource = (*m_verticesSourceIndices)[next];
-                if (MeshCombiner::Source::None == nextSource.first) {
-                    seamLink[index].push_back(next);
-                }
-            }
+            if (isSeamVertex(face[i]) && isSeamVertex(face[(i + 1) % face.size()]))
+                ++seamLinkOffsets[face[i] + 1];
         }
     }
-    std::map<size_t, size_t> seamVertexToIslandMap;
-    splitSeamVerticesToIslands(seamLink, &seamVertexToIslandMap);
+    for (size_t v = 0; v < vertexCount; ++v)
+        seamLinkOffsets[v + 1] += seamLinkOffsets[v];
+    std::vector<size_t> seamLinks(seamLinkOffsets[vertexCount]);
+    std::vector<size_t> seamLinkEnds(seamLinkOffsets.begin(), seamLinkOffsets.end() - 1);
+    for (const auto& face : *m_faces) {
+        for (size_t i = 0; i < face.size(); ++i) {
+            auto next = face[(i + 1) % face.size()];
+            if (isSeamVertex(face[i]) && isSeamVertex(next))
+                seamLinks[seamLinkEnds[face[i]]++] = next;
+        }
+    }
+    std::vector<size_t> seamVertexToIslandMap(vertexCount, std::numeric_limits<size_t>::max());
+    size_t islandCount = splitSeamVerticesToIslands(seamLinkOffsets, seamLinks, &seamVertexToIslandMap);
 
-    std::map<std::pair<size_t, size_t>, std::pair<size_t, bool>> edgesInSeamArea;
+    m_facesInSeamArea.assign(m_faces->size(), std::numeric_limits<size_t>::max());
+    HalfEdgeMap<std::pair<size_t, bool>> edgesInSeamArea;
     for (size_t faceIndex = 0; faceIndex < (*m_faces).size(); ++faceIndex) {
         const auto& face = (*m_faces)[faceIndex];
         bool containsSeamVertex = false;
@@ -162,22 +185,20 @@ bool MeshRecombiner::recombine()
             const auto& index = face[i];
             auto source = (*m_verticesSourceIndices)[index];
             if (MeshCombiner::Source::None == source.first) {
-                const auto& findIsland = seamVertexToIslandMap.find(index);
-                if (findIsland != seamVertexToIslandMap.end()) {
+                if (std::numeric_limits<size_t>::max() != seamVertexToIslandMap[index]) {
                     containsSeamVertex = true;
-                    island = findIsland->second;
+                    island = seamVertexToIslandMap[index];
                 }
             } else if (MeshCombiner::Source::First == source.first) {
                 inFirstGroup = true;
             }
         }
         if (containsSeamVertex) {
-            m_facesInSeamArea.insert({ faceIndex, island });
+            m_facesInSeamArea[faceIndex] = island;
             for (size_t i = 0; i < face.size(); ++i) {
                 const auto& index = face[i];
                 const auto& next = face[(i + 1) % face.size()];
-                std::pair<size_t, size_t> edge = { index, next };
-                edgesInSeamArea.insert({ edge, { island, inFirstGroup } });
+                edgesInSeamArea.insert({ makeHalfEdgeKey(index, next), { island, inFirstGroup } });
             }
         }
     }
@@ -186,38 +207,43 @@ bool MeshRecombiner::recombine()
         std::vector<std::pair<size_t, size_t>> halfedges[2];
         std::vector<std::vector<size_t>> edgeLoops[2];
     };
-    std::map<size_t, IslandData> islandsMap;
+    std::vector<IslandData> islands(islandCount);
 
     for (const auto& edge : edgesInSeamArea) {
-        if (edgesInSeamArea.find({ edge.first.second, edge.first.first }) == edgesInSeamArea.end()) {
-            islandsMap[edge.second.first].halfedges[edge.second.second ? 0 : 1].push_back(edge.first);
+        size_t first = halfEdgeKeyFirst(edge.first);
+        size_t second = halfEdgeKeySecond(edge.first);
+        if (edgesInSeamArea.find(makeHalfEdgeKey(second, first)) == edgesInSeamArea.end()) {
+            islands[edge.second.first].halfedges[edge.second.second ? 0 : 1].push_back({ first, second });
         }
     }
-    for (auto& it : islandsMap) {
+    for (auto& island : islands) {
         for (size_t side = 0; side < 2; ++side) {
-            if (!convertHalfEdgesToEdgeLoops(it.second.halfedges[side], &it.second.edgeLoops[side])) {
-                it.second.edgeLoops[side].clear();
+            if (!convertHalfEdgesToEdgeLoops(island.halfedges[side], &island.edgeLoops[side])) {
+                island.edgeLoops[side].clear();
             }
         }
     }
 
-    for (auto& it : islandsMap) {
+    for (size_t islandIndex = 0; islandIndex < islands.size(); ++islandIndex) {
+        auto& island = islands[islandIndex];
         for (size_t side = 0; side < 2; ++side) {
-            for (size_t i = 0; i < it.second.edgeLoops[side].size(); ++i) {
-                auto& edgeLoop = it.second.edgeLoops[side][i];
+            for (size_t i = 0; i < island.edgeLoops[side].size(); ++i) {
+                auto& edgeLoop = island.edgeLoops[side][i];
                 size_t totalAdjustedTriangles = 0;
                 size_t adjustedTriangles = 0;
-                while ((adjustedTriangles = adjustTrianglesFromSeam(edgeLoop, it.first)) > 0) {
+                while ((adjustedTriangles = adjustTrianglesFromSeam(edgeLoop, islandIndex)) > 0) {
                     totalAdjustedTriangles += adjustedTriangles;
                 }
             }
         }
     }
 
-    for (auto& it : islandsMap) {
-        if (1 == it.second.edgeLoops[0].size() && it.second.edgeLoops[0].size() == it.second.edgeLoops[1].size()) {
-            if (bridge(it.second.edgeLoops[0][0], it.second.edgeLoops[1][0])) {
-                m_goodSeams.insert(it.first);
+    m_goodSeams.assign(islands.size(), 0);
+    for (size_t islandIndex = 0; islandIndex < islands.size(); ++islandIndex) {
+        auto& island = islands[islandIndex];
+        if (1 == island.edgeLoops[0].size() && island.edgeLoops[0].size() == island.edgeLoops[1].size()) {
+            if (bridge(island.edgeLoops[0][0], island.edgeLoops[1][0])) {
+                m_goodSeams[islandIndex] = 1;
             }
         }
     }
@@ -236,7 +262,7 @@ size_t MeshRecombiner::adjustTrianglesFromSeam(std::vector<size_t>& edgeLoop, si
     std::vector<size_t> halfEdgeToFaces;
     for (size_t i = 0; i < edgeLoop.size(); ++i) {
         size_t j = (i + 1) % edgeLoop.size();
-        auto findFace = m_halfEdgeToFaceMap.find({ edgeLoop[j], edgeLoop[i] });
+        auto findFace = m_halfEdgeToFaceMap.find(makeHalfEdgeKey(edgeLoop[j], edgeLoop[i]));
         if (findFace == m_halfEdgeToFaceMap.end()) {
             return 0;
         }
@@ -244,32 +270,36 @@ size_t MeshRecombiner::adjustTrianglesFromSeam(std::vector<size_t>& edgeLoop, si
     }
 
     std::vector<size_t> removedFaceIndices;
-    std::set<size_t> ignored;
+    std::vector<char> ignored(edgeLoop.size(), 0);
+    size_t ignoredCount = 0;
     for (size_t i = 0; i < edgeLoop.size(); ++i) {
         size_t j = (i + 1) % edgeLoop.size();
         if (halfEdgeToFaces[i] == halfEdgeToFaces[j]) {
             removedFaceIndices.push_back(halfEdgeToFaces[i]);
-            ignored.insert(edgeLoop[j]);
+            ignored[j] = 1;
+            ++ignoredCount;
             ++i;
             continue;
         }
     }
 
-    if (!ignored.empty()) {
+    if (ignoredCount > 0) {
         std::vector<size_t> newEdgeLoop;
-        for (const auto& v : edgeLoop) {
-            if (ignored.find(v) != ignored.end())
+        for (size_t i = 0; i < edgeLoop.size(); ++i) {
+            if (ignored[i])
                 continue;
-            newEdgeLoop.push_back(v);
+            newEdgeLoop.push_back(edgeLoop[i]);
         }
         if (newEdgeLoop.size() < 3)
             return 0;
         edgeLoop = newEdgeLoop;
-        for (const auto& faceIndex : removedFaceIndices)
-            m_facesInSeamArea.insert({ faceIndex, seamIndex });
+        for (const auto& faceIndex : removedFaceIndices) {
+            if (std::numeric_limits<size_t>::max() == m_facesInSeamArea[faceIndex])
+                m_facesInSeamArea[faceIndex] = seamIndex;
+        }
     }
 
-    return ignored.size();
+    return ignoredCount;
 }
 
 size_t MeshRecombiner::otherVertexOfTriangle(const std::vector<size_t>& face, const std::vector<size_t>& indices)
@@ -286,8 +316,8 @@ size_t MeshRecombiner::otherVertexOfTriangle(const std::vector<size_t>& face, co
 void MeshRecombiner::copyNonSeamFacesAsRegenerated()
 {
     for (size_t faceIndex = 0; faceIndex < m_faces->size(); ++faceIndex) {
-        const auto& findFaceInSeam = m_facesInSeamArea.find(faceIndex);
-        if (findFaceInSeam != m_facesInSeamArea.end() && m_goodSeams.find(findFaceInSeam->second) != m_goodSeams.end())
+        size_t seamIndex = m_facesInSeamArea[faceIndex];
+        if (std::numeric_limits<size_t>::max() != seamIndex && m_goodSeams[seamIndex])
             continue;
         m_regeneratedFaces.push_back((*m_faces)[faceIndex]);
     }
@@ -329,18 +359,15 @@ bool MeshRecombiner::bridge(const std::vector<size_t>& first, const std::vector<
     if (large->size() < small->size())
         std::swap(large, small);
     std::vector<std::pair<size_t, size_t>> matchedPairs;
-    std::map<size_t, size_t> nearestIndicesFromLargeToSmall;
+    std::vector<size_t> nearestIndicesFromLargeToSmall(large->size(), std::numeric_limits<size_t>::max());
     for (size_t i = 0; i < small->size(); ++i) {
         const auto& positionOnSmall = (*m_vertices)[(*small)[i]];
         size_t nearestIndexOnLarge = nearestIndex(positionOnSmall, *large);
-        auto matchResult = nearestIndicesFromLargeToSmall.find(nearestIndexOnLarge);
-        size_t nearestIndexOnSmall;
-        if (matchResult == nearestIndicesFromLargeToSmall.end()) {
+        size_t nearestIndexOnSmall = nearestIndicesFromLargeToSmall[nearestIndexOnLarge];
+        if (std::numeric_limits<size_t>::max() == nearestIndexOnSmall) {
             const auto& positionOnLarge = (*m_vertices)[(*large)[nearestIndexOnLarge]];
             nearestIndexOnSmall = nearestIndex(positionOnLarge, *small);
-            nearestIndicesFromLargeToSmall.insert({ nearestIndexOnLarge, nearestIndexOnSmall });
-        } else {
-            nearestIndexOnSmall = matchResult->second;
+            nearestIndicesFromLargeToSmall[nearestIndexOnLarge] = nearestIndexOnSmall;
         }
         if (nearestIndexOnSmall == i) {
             matchedPairs.push_back({ nearestIndexOnSmall, nearestIndexOnLarge });
@@ -449,18 +476,17 @@ void MeshRecombiner::fillPairs(const std::vector<size_t>& small, const std::vect
 void MeshRecombiner::removeReluctantVertices()
 {
     std::vector<std::vector<size_t>> rearrangedFaces;
-    std::map<size_t, size_t> oldToNewIndexMap;
+    std::vector<size_t> oldToNewIndexMap(m_vertices->size(), std::numeric_limits<size_t>::max());
     for (const auto& face : m_regeneratedFaces) {
         std::vector<size_t> newFace;
         for (const auto& index : face) {
-            const auto& findIndex = oldToNewIndexMap.find(index);
-            if (findIndex != oldToNewIndexMap.end()) {
-                newFace.push_back(findIndex->second);
+            if (std::numeric_limits<size_t>::max() != oldToNewIndexMap[index]) {
+                newFace.push_back(oldToNewIndexMap[index]);
             } else {
                 size_t newIndex = m_regeneratedVertices.size();
                 m_regeneratedVertices.push_back((*m_vertices)[index]);
                 m_regeneratedVerticesSourceIndices.push_back((*m_verticesSourceIndices)[index]);
-                oldToNewIndexMap.insert({ index, newIndex });
+                oldToNewIndexMap[index] = newIndex;
                 newFace.push_back(newIndex);
             }
         }
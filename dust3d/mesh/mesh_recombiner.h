@@ -24,9 +24,8 @@
 #define DUST3D_MESH_MESH_RECOMBINER_H_
 
 #include <dust3d/base/vector2.h>
+#include <dust3d/mesh/half_edge_map.h>
 #include <dust3d/mesh/mesh_combiner.h>
-#include <map>
-#include <set>
 #include <vector>
 
 namespace dust3d {
@@ -49,18 +48,18 @@ private:
     std::vector<Vector3> m_regeneratedVertices;
     std::vector<std::pair<MeshCombiner::Source, size_t>> m_regeneratedVerticesSourceIndices;
     std::vector<std::vector<size_t>> m_regeneratedFaces;
-    std::map<std::pair<size_t, size_t>, size_t> m_halfEdgeToFaceMap;
-    std::map<size_t, size_t> m_facesInSeamArea;
-    std::set<size_t> m_goodSeams;
+    HalfEdgeMap<size_t> m_halfEdgeToFaceMap;
+    // Seam island of each face, npos for faces away from the seams
+    std::vector<size_t> m_facesInSeamArea;
+    std::vector<char> m_goodSeams;
     std::vector<std::vector<std::pair<std::array<Vector3, 3>, std::array<Vector2, 3>>>> m_generatedBridgingTriangleUvs;
 
-    bool addFaceToHalfEdgeToFaceMap(size_t faceIndex,
-        std::map<std::pair<size_t, size_t>, size_t>& halfEdgeToFaceMap);
-    bool buildHalfEdgeToFaceMap(std::map<std::pair<size_t, size_t>, size_t>& halfEdgeToFaceMap);
+    bool buildHalfEdgeToFaceMap(HalfEdgeMap<size_t>& halfEdgeToFaceMap);
     bool convertHalfEdgesToEdgeLoops(const std::vector<std::pair<size_t, size_t>>& halfEdges,
         std::vector<std::vector<size_t>>* edgeLoops);
-    size_t splitSeamVerticesToIslands(const std::map<size_t, std::vector<size_t>>& seamEdges,
-        std::map<size_t, size_t>* vertexToIslandMap);
+    size_t splitSeamVerticesToIslands(const std::vector<size_t>& seamLinkOffsets,
+        const std::vector<size_t>& seamLinks,
+        std::vector<size_t>* vertexToIslandMap);
     void copyNonSeamFacesAsRegenerated();
     size_t adjustTrianglesFromSeam(std::vector<size_t>& edgeLoop, size_t seamIndex);
     size_t otherVertexOfTriangle(const std::vector<size_t>& face, const std::vector<size_t>& indices);
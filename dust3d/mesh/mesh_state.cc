@@ -24,6 +24,7 @@
 #include <dust3d/base/debug.h>
 #include <dust3d/mesh/mesh_recombiner.h>
 #include <dust3d/mesh/mesh_state.h>
+#include <dust3d/mesh/mesh_validation.h>
 
 namespace dust3d {
 
@@ -32,11 +33,24 @@ MeshState::MeshState(const std::vector<Vector3>& vertices, const std::vector<std
     mesh = std::make_unique<MeshCombiner::Mesh>(vertices, faces);
 }
 
-MeshState::MeshState(const MeshState& other)
+MeshState::MeshState(const std::vector<Vector3>& vertices, const IndexedPolygons& faces)
 {
-    if (nullptr != other.mesh)
-        mesh = std::make_unique<MeshCombiner::Mesh>(*other.mesh);
-    seamTriangleUvs = other.seamTriangleUvs;
+    mesh = std::make_unique<MeshCombiner::Mesh>(vertices, faces);
+}
+
+std::unique_ptr<MeshState> MeshState::share() const
+{
+    auto meshState = std::make_unique<MeshState>();
+    if (nullptr != mesh)
+        meshState->mesh = mesh->share();
+    meshState->seamTriangleUvs = seamTriangleUvs;
+    meshState->contentHash = contentHash;
+    return meshState;
+}
+
+bool MeshState::sharesGeometryWith(const MeshState& other) const
+{
+    return nullptr != mesh && nullptr != other.mesh && mesh->sharesGeometryWith(*other.mesh);
 }
 
 void MeshState::fetch(std::vector<Vector3>& vertices, std::vector<std::vector<size_t>>& faces) const
@@ -45,6 +59,12 @@ void MeshState::fetch(std::vector<Vector3>& vertices, std::vector<std::vector<si
         mesh->fetch(vertices, faces);
 }
 
+void MeshState::fetch(std::vector<Vector3>& vertices, IndexedTriangles& triangles) const
+{
+    if (mesh)
+        mesh->fetch(vertices, triangles);
+}
+
 bool MeshState::isNull() const
 {
     if (nullptr == mesh)
@@ -53,7 +73,7 @@ bool MeshState::isNull() const
 }
 
 std::unique_ptr<MeshState> MeshState::combine(const MeshState& first, const MeshState& second,
-    MeshCombiner::Method method)
+    MeshCombiner::Method method, ThreadBudget* threadBudget)
 {
     if (first.mesh->isNull() || second.mesh->isNull())
         return nullptr;
@@ -62,7 +82,8 @@ std::unique_ptr<MeshState> MeshState::combine(const MeshState& first, const Mesh
     auto newMesh = std::unique_ptr<MeshCombiner::Mesh>(MeshCombiner::combine(*first.mesh,
         *second.mesh,
         method,
-        &combinedVerticesSources));
+        &combinedVerticesSources,
+        threadBudget));
     if (nullptr == newMesh)
         return nullptr;
     if (!newMesh->isNull()) {
@@ -73,21 +94,21 @@ std::unique_ptr<MeshState> MeshState::combine(const MeshState& first, const Mesh
         recombiner.setVertices(&combinedVertices, &combinedVerticesSources);
         recombiner.setFaces(&combinedFaces);
         if (recombiner.recombine()) {
-            if (MeshState::isWatertight(recombiner.regeneratedFaces())) {
+            if (isMeshWatertight(recombiner.regeneratedFaces())) {
                 auto reMesh = std::make_unique<MeshCombiner::Mesh>(recombiner.regeneratedVertices(), recombiner.regeneratedFaces());
                 if (!reMesh->isNull()) {
                     for (const auto& uvSeams : recombiner.generatedBridgingTriangleUvs()) {
-                        std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>> uvs;
+                        auto uvs = std::make_shared<SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>>>();
                         for (const auto& it : uvSeams) {
-                            uvs.insert(std::make_pair(std::array<PositionKey, 3> {
+                            uvs->insert(std::make_pair(std::array<PositionKey, 3> {
                                                           PositionKey(it.first[0]),
                                                           PositionKey(it.first[1]),
                                                           PositionKey(it.first[2]) },
                                 it.second));
                         }
-                        if (uvs.empty())
+                        if (uvs->empty())
                             continue;
-                        newMeshState->seamTriangleUvs.push_back(uvs);
+                        newMeshState->seamTriangleUvs.push_back(std::move(uvs));
                     }
                     newMesh = std::move(reMesh);
                 }
@@ -105,22 +126,4 @@ std::unique_ptr<MeshState> MeshState::combine(const MeshState& first, const Mesh
     return newMeshState;
 }
 
-bool MeshState::isWatertight(const std::vector<std::vector<size_t>>& faces)
-{
-    std::set<std::pair<size_t, size_t>> halfEdges;
-    for (const auto& face : faces) {
-        for (size_t i = 0; i < face.size(); ++i) {
-            size_t j = (i + 1) % face.size();
-            auto insertResult = halfEdges.insert({ face[i], face[j] });
-            if (!insertResult.second)
-                return false;
-        }
-    }
-    for (const auto& it : halfEdges) {
-        if (halfEdges.find({ it.second, it.first }) == halfEdges.end())
-            return false;
-    }
-    return true;
-}
-
 }
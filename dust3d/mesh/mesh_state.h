@@ -24,24 +24,35 @@
 #define DUST3D_MESH_MESH_STATE_H_
 
 #include <dust3d/base/position_key.h>
+#include <dust3d/base/spatial_hash_map.h>
 #include <dust3d/mesh/mesh_combiner.h>
 #include <map>
+#include <memory>
 
 namespace dust3d {
 
 class MeshState {
 public:
     std::unique_ptr<MeshCombiner::Mesh> mesh;
-    std::vector<std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>>> seamTriangleUvs;
+    std::vector<std::shared_ptr<const SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>>>> seamTriangleUvs;
+    // Hash of everything the mesh was generated from, zero when unknown
+    uint64_t contentHash = 0;
 
     MeshState() = default;
     MeshState(const std::vector<Vector3>& vertices, const std::vector<std::vector<size_t>>& faces);
-    MeshState(const MeshState& other);
+    MeshState(const std::vector<Vector3>& vertices, const IndexedPolygons& faces);
+    MeshState(MeshState&& other) = default;
+    MeshState(const MeshState& other) = delete;
+    MeshState& operator=(MeshState&& other) = default;
+    MeshState& operator=(const MeshState& other) = delete;
+    std::unique_ptr<MeshState> share() const;
+    // True when both were shared from the same generated mesh, which means the same vertices and triangles
+    bool sharesGeometryWith(const MeshState& other) const;
     void fetch(std::vector<Vector3>& vertices, std::vector<std::vector<size_t>>& faces) const;
+    void fetch(std::vector<Vector3>& vertices, IndexedTriangles& triangles) const;
     bool isNull() const;
     static std::unique_ptr<MeshState> combine(const MeshState& first, const MeshState& second,
-        MeshCombiner::Method method);
-    static bool isWatertight(const std::vector<std::vector<size_t>>& faces);
+        MeshCombiner::Method method, ThreadBudget* threadBudget = nullptr);
 };
 
 }
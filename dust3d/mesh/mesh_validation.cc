@@ -0,0 +1,249 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <GuigueDevillers03/tri_tri_intersect.h>
+#include <algorithm>
+#include <dust3d/mesh/mesh_validation.h>
+#include <dust3d/mesh/solid_mesh.h>
+#include <numeric>
+
+namespace dust3d {
+
+namespace {
+
+    // Face corners grouped by vertex, each corner keeps the vertex before it and the one after it in its face,
+    // so the half-edges leaving a vertex are the next vertices of its corners.
+    // Within a group the corners are ordered by their next vertex, and again by their previous vertex in byPrevious,
+    // so any half-edge is found by a binary search in one group instead of a scan of it
+    struct CornerTable {
+        std::vector<size_t> offsets;
+        std::vector<size_t> next;
+        std::vector<size_t> previous;
+        std::vector<size_t> previousSorted;
+        std::vector<size_t> byPrevious;
+    };
+
+    // One stable counting sort pass, two of them make a radix sort of the corners by (vertex, key)
+    void sortCornersByKey(const std::vector<size_t>& keys, size_t keyCount, std::vector<size_t>* order)
+    {
+        std::vector<size_t> offsets(keyCount + 1, 0);
+        for (const auto& corner : *order)
+            ++offsets[keys[corner] + 1];
+        for (size_t i = 0; i < keyCount; ++i)
+            offsets[i + 1] += offsets[i];
+        std::vector<size_t> sorted(order->size());
+        for (const auto& corner : *order)
+            sorted[offsets[keys[corner]]++] = corner;
+        order->swap(sorted);
+    }
+
+    void buildCornerTable(const std::vector<std::vector<size_t>>& faces, bool withPrevious, CornerTable* table)
+    {
+        size_t vertexCount = 0;
+        size_t cornerCount = 0;
+        for (const auto& face : faces) {
+            for (const auto& index : face)
+                vertexCount = std::max(vertexCount, index + 1);
+            cornerCount += face.size();
+        }
+        std::vector<size_t> cornerVertices;
+        std::vector<size_t> cornerNexts;
+        std::vector<size_t> cornerPrevious;
+        cornerVertices.reserve(cornerCount);
+        cornerNexts.reserve(cornerCount);
+        if (withPrevious)
+            cornerPrevious.reserve(cornerCount);
+        for (const auto& face : faces) {
+            for (size_t i = 0; i < face.size(); ++i) {
+                cornerVertices.push_back(face[i]);
+                cornerNexts.push_back(face[(i + 1) % face.size()]);
+                if (withPrevious)
+                    cornerPrevious.push_back(face[(i + face.size() - 1) % face.size()]);
+            }
+        }
+
+        std::vector<size_t> order(cornerCount);
+        std::iota(order.begin(), order.end(), 0);
+        sortCornersByKey(cornerNexts, vertexCount, &order);
+        sortCornersByKey(cornerVertices, vertexCount, &order);
+
+        table->offsets.assign(vertexCount + 1, 0);
+        for (const auto& vertex : cornerVertices)
+            ++table->offsets[vertex + 1];
+        for (size_t v = 0; v < vertexCount; ++v)
+            table->offsets[v + 1] += table->offsets[v];
+        table->next.resize(cornerCount);
+        for (size_t i = 0; i < cornerCount; ++i)
+            table->next[i] = cornerNexts[order[i]];
+        if (!withPrevious)
+            return;
+
+        table->previous.resize(cornerCount);
+        for (size_t i = 0; i < cornerCount; ++i)
+            table->previous[i] = cornerPrevious[order[i]];
+        for (size_t v = 0; v < vertexCount; ++v)
+            std::fill(cornerVertices.begin() + table->offsets[v], cornerVertices.begin() + table->offsets[v + 1], v);
+        table->byPrevious.resize(cornerCount);
+        std::iota(table->byPrevious.begin(), table->byPrevious.end(), 0);
+        sortCornersByKey(table->previous, vertexCount, &table->byPrevious);
+        sortCornersByKey(cornerVertices, vertexCount, &table->byPrevious);
+        table->previousSorted.resize(cornerCount);
+        for (size_t i = 0; i < cornerCount; ++i)
+            table->previousSorted[i] = table->previous[table->byPrevious[i]];
+    }
+
+    // Position of the vertex in the sorted range, end when it is not there
+    size_t findCorner(const std::vector<size_t>& sortedVertices, size_t begin, size_t end, size_t vertex)
+    {
+        auto it = std::lower_bound(sortedVertices.begin() + begin, sortedVertices.begin() + end, vertex);
+        if (it == sortedVertices.begin() + end || *it != vertex)
+            return end;
+        return it - sortedVertices.begin();
+    }
+
+}
+
+bool isMeshWatertight(const std::vector<std::vector<size_t>>& faces)
+{
+    CornerTable table;
+    buildCornerTable(faces, false, &table);
+    const auto& offsets = table.offsets;
+    for (size_t v = 0; v + 1 < offsets.size(); ++v) {
+        for (size_t corner = offsets[v]; corner < offsets[v + 1]; ++corner) {
+            size_t next = table.next[corner];
+            if (corner > offsets[v] && table.next[corner - 1] == next)
+                return false;
+            if (findCorner(table.next, offsets[next], offsets[next + 1], v) == offsets[next + 1])
+                return false;
+        }
+    }
+    return true;
+}
+
+MeshValidationReport validateMesh(const std::vector<Vector3>& vertices, const std::vector<std::vector<size_t>>& faces,
+    bool checkSelfIntersections, ThreadBudget* threadBudget)
+{
+    MeshValidationReport report;
+
+    CornerTable table;
+    buildCornerTable(faces, true, &table);
+    const auto& offsets = table.offsets;
+    std::vector<char> visited;
+    for (size_t v = 0; v + 1 < offsets.size(); ++v) {
+        size_t begin = offsets[v];
+        size_t end = offsets[v + 1];
+        for (size_t corner = begin; corner < end; ++corner) {
+            size_t next = table.next[corner];
+            if (corner > begin && table.next[corner - 1] == next)
+                ++report.duplicatedHalfEdgeCount;
+            if (findCorner(table.next, offsets[next], offsets[next + 1], v) == offsets[next + 1])
+                ++report.boundaryHalfEdgeCount;
+        }
+
+        // The face across the outgoing half-edge of a corner comes back in along it, open fans are walked from their first corner
+        size_t fanCount = 0;
+        visited.assign(end - begin, 0);
+        auto walkFan = [&](size_t corner) {
+            ++fanCount;
+            while (corner != end && !visited[corner - begin]) {
+                visited[corner - begin] = 1;
+                size_t successor = findCorner(table.previousSorted, begin, end, table.next[corner]);
+                corner = successor == end ? end : table.byPrevious[successor];
+            }
+        };
+        for (size_t corner = begin; corner < end; ++corner) {
+            if (findCorner(table.next, begin, end, table.previous[corner]) == end)
+                walkFan(corner);
+        }
+        for (size_t corner = begin; corner < end; ++corner) {
+            if (!visited[corner - begin])
+                walkFan(corner);
+        }
+        if (fanCount > 1)
+            ++report.nonManifoldVertexCount;
+    }
+
+    IndexedTriangles triangles;
+    for (const auto& face : faces) {
+        bool isDegenerated = face.size() < 3;
+        for (size_t i = 1; i < face.size() && !isDegenerated; ++i) {
+            if (std::find(face.begin(), face.begin() + i, face[i]) != face.begin() + i)
+                isDegenerated = true;
+        }
+        if (!isDegenerated) {
+            Vector3 area;
+            for (size_t i = 2; i < face.size(); ++i) {
+                area += Vector3::crossProduct(vertices[face[i - 1]] - vertices[face[0]],
+                    vertices[face[i]] - vertices[face[0]]);
+            }
+            isDegenerated = area.isZero();
+        }
+        if (isDegenerated) {
+            ++report.degenerateFaceCount;
+            continue;
+        }
+        for (size_t i = 2; i < face.size(); ++i)
+            triangles.push_back({ (uint32_t)face[0], (uint32_t)face[i - 1], (uint32_t)face[i] });
+    }
+
+    if (!checkSelfIntersections || triangles.empty())
+        return report;
+
+    SolidMesh solidMesh;
+    solidMesh.setVertices(&vertices);
+    solidMesh.setTriangles(&triangles);
+    solidMesh.prepare();
+    std::vector<std::pair<size_t, size_t>> pairs;
+    solidMesh.axisAlignedBoundingBoxTree()->test(*solidMesh.axisAlignedBoundingBoxTree(), &pairs);
+
+    // The tree reports each pair in both orders, neighbors touching at a shared vertex are not intersections
+    std::vector<char> intersectedFlags(pairs.size(), 0);
+    parallelFor(
+        threadBudget, pairs.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (pairs[i].first >= pairs[i].second)
+                    continue;
+                const auto& first = triangles[pairs[i].first];
+                const auto& second = triangles[pairs[i].second];
+                if (std::find_first_of(first.begin(), first.end(), second.begin(), second.end()) != first.end())
+                    continue;
+                int coplanar = 0;
+                Vector3 sourcePoint;
+                Vector3 targetPoint;
+                intersectedFlags[i] = tri_tri_intersection_test_3d((double*)vertices[first[0]].constData(),
+                    (double*)vertices[first[1]].constData(),
+                    (double*)vertices[first[2]].constData(),
+                    (double*)vertices[second[0]].constData(),
+                    (double*)vertices[second[1]].constData(),
+                    (double*)vertices[second[2]].constData(),
+                    &coplanar,
+                    (double*)sourcePoint.constData(),
+                    (double*)targetPoint.constData());
+            }
+        },
+        256);
+    report.selfIntersectionCount = std::count(intersectedFlags.begin(), intersectedFlags.end(), 1);
+
+    return report;
+}
+
+}
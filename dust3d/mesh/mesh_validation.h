@@ -0,0 +1,63 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_MESH_MESH_VALIDATION_H_
+#define DUST3D_MESH_MESH_VALIDATION_H_
+
+#include <dust3d/base/task_group.h>
+#include <dust3d/base/vector3.h>
+#include <vector>
+
+namespace dust3d {
+
+struct MeshValidationReport {
+    // Half-edges without the opposite half-edge
+    size_t boundaryHalfEdgeCount = 0;
+    // Half-edges repeated by another face, the edge is shared by more than two faces or they disagree on orientation
+    size_t duplicatedHalfEdgeCount = 0;
+    // Vertices whose faces do not form one single fan around them
+    size_t nonManifoldVertexCount = 0;
+    // Faces with less than three distinct vertices or without area
+    size_t degenerateFaceCount = 0;
+    // Intersecting pairs of triangles, which share no vertex, from the fan triangulation of the faces
+    size_t selfIntersectionCount = 0;
+
+    bool isWatertight() const
+    {
+        return 0 == boundaryHalfEdgeCount && 0 == duplicatedHalfEdgeCount;
+    }
+
+    bool isManifold() const
+    {
+        return 0 == duplicatedHalfEdgeCount && 0 == nonManifoldVertexCount;
+    }
+};
+
+// Every half-edge appears once and has its opposite half-edge
+bool isMeshWatertight(const std::vector<std::vector<size_t>>& faces);
+
+MeshValidationReport validateMesh(const std::vector<Vector3>& vertices, const std::vector<std::vector<size_t>>& faces,
+    bool checkSelfIntersections = true, ThreadBudget* threadBudget = nullptr);
+
+}
+
+#endif
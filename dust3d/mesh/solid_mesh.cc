@@ -36,7 +36,7 @@ void SolidMesh::setVertices(const std::vector<Vector3>* vertices)
     m_vertices = vertices;
 }
 
-void SolidMesh::setTriangles(const std::vector<std::vector<size_t>>* triangles)
+void SolidMesh::setTriangles(const IndexedTriangles* triangles)
 {
     m_triangles = triangles;
 }
@@ -25,6 +25,7 @@
 
 #include <dust3d/base/axis_aligned_bounding_box.h>
 #include <dust3d/base/axis_aligned_bounding_box_tree.h>
+#include <dust3d/base/indexed_mesh.h>
 #include <dust3d/base/vector3.h>
 
 namespace dust3d {
@@ -33,14 +34,14 @@ class SolidMesh {
 public:
     ~SolidMesh();
     void setVertices(const std::vector<Vector3>* vertices);
-    void setTriangles(const std::vector<std::vector<size_t>>* triangles);
+    void setTriangles(const IndexedTriangles* triangles);
 
     const std::vector<Vector3>* vertices() const
     {
         return m_vertices;
     }
 
-    const std::vector<std::vector<size_t>>* triangles() const
+    const IndexedTriangles* triangles() const
     {
         return m_triangles;
     }
@@ -63,14 +64,14 @@ public:
     void prepare();
 
 private:
-    void addTriagleToAxisAlignedBoundingBox(const std::vector<size_t>& triangle, AxisAlignedBoudingBox* box)
+    void addTriagleToAxisAlignedBoundingBox(const IndexedTriangle& triangle, AxisAlignedBoudingBox* box)
     {
         for (size_t i = 0; i < 3; ++i)
             box->update((*m_vertices)[triangle[i]]);
     }
 
     const std::vector<Vector3>* m_vertices = nullptr;
-    const std::vector<std::vector<size_t>>* m_triangles = nullptr;
+    const IndexedTriangles* m_triangles = nullptr;
     std::vector<Vector3>* m_triangleNormals = nullptr;
     AxisAlignedBoudingBoxTree* m_axisAlignedBoundingBoxTree = nullptr;
     std::vector<AxisAlignedBoudingBox>* m_triangleAxisAlignedBoundingBoxes = nullptr;
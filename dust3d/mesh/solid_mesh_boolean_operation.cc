@@ -25,16 +25,16 @@
 #include <dust3d/base/position_key.h>
 #include <dust3d/mesh/re_triangulator.h>
 #include <dust3d/mesh/solid_mesh_boolean_operation.h>
+#include <algorithm>
 #include <queue>
-#include <set>
 #include <stdio.h>
 
 namespace dust3d {
 
 static const std::vector<Vector3> g_testAxisList = {
-    { std::numeric_limits<double>::max(), std::numeric_limits<double>::epsilon(), std::numeric_limits<double>::epsilon() },
-    { std::numeric_limits<double>::epsilon(), std::numeric_limits<double>::max(), std::numeric_limits<double>::epsilon() },
-    { std::numeric_limits<double>::epsilon(), std::numeric_limits<double>::epsilon(), std::numeric_limits<double>::max() },
+    { 1.0, 0.0, 0.0 },
+    { 0.0, 1.0, 0.0 },
+    { 0.0, 0.0, 1.0 },
 };
 
 SolidMeshBooleanOperation::SolidMeshBooleanOperation(const SolidMesh* m_firstMesh,
@@ -48,49 +48,41 @@ SolidMeshBooleanOperation::~SolidMeshBooleanOperation()
 {
 }
 
-bool SolidMeshBooleanOperation::isPointInMesh(const Vector3& testPosition,
+void SolidMeshBooleanOperation::setThreadBudget(ThreadBudget* threadBudget)
+{
+    m_threadBudget = threadBudget;
+}
+
+void SolidMeshBooleanOperation::countPointsInMesh(const std::vector<Vector3>& testPositions,
     const SolidMesh* targetMesh,
     const AxisAlignedBoudingBoxTree* meshBoxTree,
-    const Vector3& testAxis)
+    const Vector3& testAxis,
+    std::vector<size_t>* insideCounts)
 {
-    Vector3 testEnd = testPosition + testAxis;
-    bool inside = false;
-    std::vector<AxisAlignedBoudingBox> rayBox(1);
-    auto& box = rayBox[0];
-    box.update(testPosition);
-    box.update(testEnd);
-    AxisAlignedBoudingBoxTree testTree(&rayBox,
-        { 0 },
-        rayBox[0]);
-    std::vector<std::pair<size_t, size_t>> pairs;
-    meshBoxTree->test(meshBoxTree->root(), testTree.root(), &rayBox, &pairs);
-    std::set<PositionKey> hits;
-
-    for (const auto& it : pairs) {
-        const auto& triangle = (*targetMesh->triangles())[it.first];
-        std::vector<Vector3> trianglePositions = {
-            (*targetMesh->vertices())[triangle[0]],
-            (*targetMesh->vertices())[triangle[1]],
-            (*targetMesh->vertices())[triangle[2]]
-        };
-        Vector3 intersection;
-        if (Vector3::intersectSegmentAndPlane(testPosition, testEnd,
-                trianglePositions[0],
-                (*targetMesh->triangleNormals())[it.first],
-                &intersection)) {
-            std::vector<Vector3> normals;
-            for (size_t i = 0; i < 3; ++i) {
-                size_t j = (i + 1) % 3;
-                normals.push_back(Vector3::normal(intersection, trianglePositions[i], trianglePositions[j]));
-            }
-            if (Vector3::dotProduct(normals[0], normals[1]) > 0 && Vector3::dotProduct(normals[0], normals[2]) > 0) {
-                hits.insert(PositionKey(intersection));
-            }
+    const auto& vertices = *targetMesh->vertices();
+    const auto& triangles = *targetMesh->triangles();
+    std::vector<std::pair<size_t, PositionKey>> hits;
+    meshBoxTree->intersectRays(testPositions, testAxis, [&](size_t rayIndex, size_t triangleIndex) {
+        const auto& triangle = triangles[triangleIndex];
+        double distance = 0.0;
+        if (Vector3::intersectRayAndTriangle(testPositions[rayIndex], testAxis,
+                vertices[triangle[0]], vertices[triangle[1]], vertices[triangle[2]],
+                &distance)) {
+            hits.push_back({ rayIndex, PositionKey(testPositions[rayIndex] + testAxis * distance) });
         }
+    });
+
+    // Rays passing through shared edges or vertices hit more than one triangle at the same position
+    std::sort(hits.begin(), hits.end());
+    hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+
+    std::vector<size_t> hitCounts(testPositions.size(), 0);
+    for (const auto& it : hits)
+        ++hitCounts[it.first];
+    for (size_t i = 0; i < hitCounts.size(); ++i) {
+        if (0 != hitCounts[i] % 2)
+            ++(*insideCounts)[i];
     }
-    inside = 0 != hits.size() % 2;
-
-    return inside;
 }
 
 void SolidMeshBooleanOperation::searchPotentialIntersectedPairs()
@@ -98,8 +90,7 @@ void SolidMeshBooleanOperation::searchPotentialIntersectedPairs()
     const AxisAlignedBoudingBoxTree* leftTree = m_firstMesh->axisAlignedBoundingBoxTree();
     const AxisAlignedBoudingBoxTree* rightTree = m_secondMesh->axisAlignedBoundingBoxTree();
 
-    leftTree->test(leftTree->root(), rightTree->root(), m_secondMesh->triangleAxisAlignedBoundingBoxes(),
-        &m_potentialIntersectedPairs);
+    leftTree->test(*rightTree, &m_potentialIntersectedPairs);
 }
 
 bool SolidMeshBooleanOperation::intersectTwoFaces(size_t firstIndex, size_t secondIndex, std::pair<Vector3, Vector3>& newEdge)
@@ -167,13 +158,13 @@ bool SolidMeshBooleanOperation::buildPolygonsFromEdges(const std::unordered_map<
 }
 
 void SolidMeshBooleanOperation::buildFaceGroups(const std::vector<std::vector<size_t>>& intersections,
-    const std::unordered_map<uint64_t, size_t>& halfEdges,
-    const std::vector<std::vector<size_t>>& triangles,
+    const HalfEdgeMap<size_t>& halfEdges,
+    const IndexedTriangles& triangles,
     size_t remainingStartTriangleIndex,
     size_t remainingTriangleCount,
     std::vector<std::vector<size_t>>& triangleGroups)
 {
-    std::unordered_map<uint64_t, size_t> halfEdgeGroupMap;
+    HalfEdgeMap<size_t> halfEdgeGroupMap;
     size_t groupIndex = 0;
     std::queue<std::pair<size_t, size_t>> waitQ;
     for (const auto& intersection : intersections) {
@@ -251,7 +242,7 @@ size_t SolidMeshBooleanOperation::addNewPoint(const Vector3& position)
 
 bool SolidMeshBooleanOperation::addUnintersectedTriangles(const SolidMesh* mesh,
     const std::unordered_set<size_t>& usedFaces,
-    std::unordered_map<uint64_t, size_t>* halfEdges)
+    HalfEdgeMap<size_t>* halfEdges)
 {
     size_t oldVertexCount = m_newVertices.size();
     const auto& vertices = *mesh->vertices();
@@ -265,9 +256,9 @@ bool SolidMeshBooleanOperation::addUnintersectedTriangles(const SolidMesh* mesh,
             continue;
         const auto& oldTriangle = (*mesh->triangles())[i];
         size_t newInsertedIndex = m_newTriangles.size();
-        m_newTriangles.push_back({ oldTriangle[0] + oldVertexCount,
-            oldTriangle[1] + oldVertexCount,
-            oldTriangle[2] + oldVertexCount });
+        m_newTriangles.push_back({ (uint32_t)(oldTriangle[0] + oldVertexCount),
+            (uint32_t)(oldTriangle[1] + oldVertexCount),
+            (uint32_t)(oldTriangle[2] + oldVertexCount) });
         const auto& newInsertedTriangle = m_newTriangles.back();
         if (!halfEdges->insert({ makeHalfEdgeKey(newInsertedTriangle[0], newInsertedTriangle[1]), newInsertedIndex }).second) {
             dust3dDebug << "Found repeated halfedge:" << newInsertedTriangle[0] << "," << newInsertedTriangle[1];
@@ -291,7 +282,7 @@ bool SolidMeshBooleanOperation::combine()
 
     struct IntersectedContext {
         std::vector<Vector3> points;
-        std::map<PositionKey, size_t> positionMap;
+        SpatialHashMap<PositionKey, size_t> positionMap;
         std::unordered_map<size_t, std::unordered_set<size_t>> neighborMap;
     };
 
@@ -305,9 +296,21 @@ bool SolidMeshBooleanOperation::combine()
         return insertResult.first->second;
     };
 
-    for (const auto& pair : m_potentialIntersectedPairs) {
-        std::pair<Vector3, Vector3> newEdge;
-        if (intersectTwoFaces(pair.first, pair.second, newEdge)) {
+    std::vector<std::pair<Vector3, Vector3>> newEdges(m_potentialIntersectedPairs.size());
+    std::vector<char> intersectedFlags(m_potentialIntersectedPairs.size(), 0);
+    parallelFor(
+        m_threadBudget, m_potentialIntersectedPairs.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const auto& pair = m_potentialIntersectedPairs[i];
+                intersectedFlags[i] = intersectTwoFaces(pair.first, pair.second, newEdges[i]);
+            }
+        },
+        256);
+
+    for (size_t i = 0; i < m_potentialIntersectedPairs.size(); ++i) {
+        const auto& pair = m_potentialIntersectedPairs[i];
+        const auto& newEdge = newEdges[i];
+        if (intersectedFlags[i]) {
             m_firstIntersectedFaces.insert(pair.first);
             m_secondIntersectedFaces.insert(pair.second);
 
@@ -337,14 +340,14 @@ bool SolidMeshBooleanOperation::combine()
     std::unordered_map<size_t, std::unordered_set<size_t>> secondEdges;
     std::vector<std::vector<size_t>> firstIntersections;
     std::vector<std::vector<size_t>> secondIntersections;
-    std::unordered_map<uint64_t, size_t> firstHalfEdges;
-    std::unordered_map<uint64_t, size_t> secondHalfEdges;
+    HalfEdgeMap<size_t> firstHalfEdges;
+    HalfEdgeMap<size_t> secondHalfEdges;
 
     auto reTriangulate = [&](const std::unordered_map<size_t, IntersectedContext>& context,
                              const SolidMesh* mesh,
                              size_t startOldVertex,
                              std::unordered_map<size_t, std::unordered_set<size_t>>& edges,
-                             std::unordered_map<uint64_t, size_t>& halfEdges) {
+                             HalfEdgeMap<size_t>& halfEdges) {
         for (const auto& it : context) {
             const auto& triangle = (*mesh->triangles())[it.first];
             ReTriangulator reTriangulator({ (*mesh->vertices())[triangle[0]],
@@ -366,9 +369,9 @@ bool SolidMeshBooleanOperation::combine()
                 newIndices.push_back(addNewPoint(point));
             for (const auto& triangle : reTriangulator.triangles()) {
                 size_t newInsertedIndex = m_newTriangles.size();
-                m_newTriangles.push_back({ newIndices[triangle[0]],
-                    newIndices[triangle[1]],
-                    newIndices[triangle[2]] });
+                m_newTriangles.push_back({ (uint32_t)newIndices[triangle[0]],
+                    (uint32_t)newIndices[triangle[1]],
+                    (uint32_t)newIndices[triangle[2]] });
                 const auto& newInsertedTriangle = m_newTriangles.back();
                 if (!halfEdges.insert({ makeHalfEdgeKey(newInsertedTriangle[0], newInsertedTriangle[1]), newInsertedIndex }).second) {
                     dust3dDebug << "Found repeated halfedge:" << newInsertedTriangle[0] << "," << newInsertedTriangle[1];
@@ -377,7 +380,7 @@ bool SolidMeshBooleanOperation::combine()
                     dust3dDebug << "Found repeated halfedge:" << newInsertedTriangle[1] << "," << newInsertedTriangle[2];
                 }
                 if (!halfEdges.insert({ makeHalfEdgeKey(newInsertedTriangle[2], newInsertedTriangle[0]), newInsertedIndex }).second) {
-                    dust3dDebug << "Found repeated halfedge:" << newInsertedTriangle[3] << "," << newInsertedTriangle[0];
+                    dust3dDebug << "Found repeated halfedge:" << newInsertedTriangle[2] << "," << newInsertedTriangle[0];
                 }
             }
             for (const auto& it : it.second.neighborMap) {
@@ -451,29 +454,24 @@ void SolidMeshBooleanOperation::decideGroupSide(const std::vector<std::vector<si
     std::vector<bool>& groupSides)
 {
     groupSides.resize(groups.size());
+    std::vector<size_t> pickedGroups;
+    std::vector<Vector3> testPositions;
     for (size_t i = 0; i < groups.size(); ++i) {
         const auto& group = groups[i];
         if (group.empty())
             continue;
-        size_t insideCount = 0;
-        size_t totalCount = 0;
-        for (size_t pickIndex = 0; pickIndex < 1 && pickIndex < group.size(); ++pickIndex) {
-            for (size_t axisIndex = 0; axisIndex < g_testAxisList.size(); ++axisIndex) {
-                const auto& pickedTriangle = m_newTriangles[group[pickIndex]];
-                bool inside = isPointInMesh((m_newVertices[pickedTriangle[0]] + m_newVertices[pickedTriangle[1]] + m_newVertices[pickedTriangle[2]]) / 3.0,
-                    mesh,
-                    tree,
-                    g_testAxisList[axisIndex]);
-                if (inside)
-                    ++insideCount;
-                ++totalCount;
-            }
-        }
-        groupSides[i] = (float)insideCount / totalCount > 0.5;
+        const auto& pickedTriangle = m_newTriangles[group[0]];
+        pickedGroups.push_back(i);
+        testPositions.push_back((m_newVertices[pickedTriangle[0]] + m_newVertices[pickedTriangle[1]] + m_newVertices[pickedTriangle[2]]) / 3.0);
     }
+    std::vector<size_t> insideCounts(testPositions.size(), 0);
+    for (const auto& testAxis : g_testAxisList)
+        countPointsInMesh(testPositions, mesh, tree, testAxis, &insideCounts);
+    for (size_t i = 0; i < pickedGroups.size(); ++i)
+        groupSides[pickedGroups[i]] = (float)insideCounts[i] / g_testAxisList.size() > 0.5;
 }
 
-void SolidMeshBooleanOperation::fetchUnion(std::vector<std::vector<size_t>>& resultTriangles)
+void SolidMeshBooleanOperation::fetchUnion(IndexedTriangles& resultTriangles)
 {
     for (size_t i = 0; i < m_firstGroupSides.size(); ++i) {
         if (m_firstGroupSides[i])
@@ -490,7 +488,7 @@ void SolidMeshBooleanOperation::fetchUnion(std::vector<std::vector<size_t>>& res
     }
 }
 
-void SolidMeshBooleanOperation::fetchDiff(std::vector<std::vector<size_t>>& resultTriangles)
+void SolidMeshBooleanOperation::fetchDiff(IndexedTriangles& resultTriangles)
 {
     for (size_t i = 0; i < m_firstGroupSides.size(); ++i) {
         if (m_firstGroupSides[i])
@@ -509,7 +507,7 @@ void SolidMeshBooleanOperation::fetchDiff(std::vector<std::vector<size_t>>& resu
     }
 }
 
-void SolidMeshBooleanOperation::fetchIntersect(std::vector<std::vector<size_t>>& resultTriangles)
+void SolidMeshBooleanOperation::fetchIntersect(IndexedTriangles& resultTriangles)
 {
     for (size_t i = 0; i < m_firstGroupSides.size(); ++i) {
         if (!m_firstGroupSides[i])
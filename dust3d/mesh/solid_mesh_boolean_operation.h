@@ -24,7 +24,10 @@
 #define DUST3D_MESH_SOLID_MESH_BOOLEAN_OPERATION_H_
 
 #include <dust3d/base/position_key.h>
+#include <dust3d/base/spatial_hash_map.h>
+#include <dust3d/base/task_group.h>
 #include <dust3d/base/vector3.h>
+#include <dust3d/mesh/half_edge_map.h>
 #include <dust3d/mesh/solid_mesh.h>
 #include <map>
 #include <unordered_map>
@@ -37,20 +40,22 @@ public:
     SolidMeshBooleanOperation(const SolidMesh* firstMesh,
         const SolidMesh* secondMesh);
     ~SolidMeshBooleanOperation();
+    void setThreadBudget(ThreadBudget* threadBudget);
     bool combine();
-    void fetchUnion(std::vector<std::vector<size_t>>& resultTriangles);
-    void fetchDiff(std::vector<std::vector<size_t>>& resultTriangles);
-    void fetchIntersect(std::vector<std::vector<size_t>>& resultTriangles);
+    void fetchUnion(IndexedTriangles& resultTriangles);
+    void fetchDiff(IndexedTriangles& resultTriangles);
+    void fetchIntersect(IndexedTriangles& resultTriangles);
 
     const std::vector<Vector3>& resultVertices();
 
 private:
     const SolidMesh* m_firstMesh = nullptr;
     const SolidMesh* m_secondMesh = nullptr;
+    ThreadBudget* m_threadBudget = nullptr;
     std::vector<std::pair<size_t, size_t>> m_potentialIntersectedPairs;
     std::vector<Vector3> m_newVertices;
-    std::vector<std::vector<size_t>> m_newTriangles;
-    std::map<PositionKey, size_t> m_newPositionMap;
+    IndexedTriangles m_newTriangles;
+    SpatialHashMap<PositionKey, size_t> m_newPositionMap;
     std::vector<std::vector<size_t>> m_firstTriangleGroups;
     std::vector<std::vector<size_t>> m_secondTriangleGroups;
     std::vector<bool> m_firstGroupSides;
@@ -60,12 +65,7 @@ private:
     std::unordered_map<size_t, std::vector<size_t>> m_firstFacesAroundVertexMap;
     std::unordered_map<size_t, std::vector<size_t>> m_secondFacesAroundVertexMap;
 
-    static inline uint64_t makeHalfEdgeKey(size_t first, size_t second)
-    {
-        return (first << 32) | second;
-    }
-
-    void addTriagleToAxisAlignedBoundingBox(const SolidMesh& mesh, const std::vector<size_t>& triangle, AxisAlignedBoudingBox* box)
+    void addTriagleToAxisAlignedBoundingBox(const SolidMesh& mesh, const IndexedTriangle& triangle, AxisAlignedBoudingBox* box)
     {
         for (size_t i = 0; i < 3; ++i)
             box->update((*mesh.vertices())[triangle[i]]);
@@ -75,20 +75,21 @@ private:
     bool intersectTwoFaces(size_t firstIndex, size_t secondIndex, std::pair<Vector3, Vector3>& newEdge);
     bool buildPolygonsFromEdges(const std::unordered_map<size_t, std::unordered_set<size_t>>& edges,
         std::vector<std::vector<size_t>>& polygons);
-    bool isPointInMesh(const Vector3& testPosition,
+    void countPointsInMesh(const std::vector<Vector3>& testPositions,
         const SolidMesh* targetMesh,
         const AxisAlignedBoudingBoxTree* meshBoxTree,
-        const Vector3& testAxis);
+        const Vector3& testAxis,
+        std::vector<size_t>* insideCounts);
     void buildFaceGroups(const std::vector<std::vector<size_t>>& intersections,
-        const std::unordered_map<uint64_t, size_t>& halfEdges,
-        const std::vector<std::vector<size_t>>& triangles,
+        const HalfEdgeMap<size_t>& halfEdges,
+        const IndexedTriangles& triangles,
         size_t remainingStartTriangleIndex,
         size_t remainingTriangleCount,
         std::vector<std::vector<size_t>>& triangleGroups);
     size_t addNewPoint(const Vector3& position);
     bool addUnintersectedTriangles(const SolidMesh* mesh,
         const std::unordered_set<size_t>& usedFaces,
-        std::unordered_map<uint64_t, size_t>* halfEdges);
+        HalfEdgeMap<size_t>* halfEdges);
     void decideGroupSide(const std::vector<std::vector<size_t>>& groups,
         const SolidMesh* mesh,
         const AxisAlignedBoudingBoxTree* tree,
@@ -20,6 +20,7 @@
  *  SOFTWARE.
  */
 
+#include <dust3d/base/content_hasher.h>
 #include <dust3d/base/debug.h>
 #include <dust3d/mesh/stitch_mesh_builder.h>
 #include <unordered_set>
@@ -31,6 +32,28 @@ StitchMeshBuilder::StitchMeshBuilder(std::vector<Spline>&& splines)
     m_splines = std::move(splines);
 }
 
+uint64_t StitchMeshBuilder::inputHash() const
+{
+    ContentHasher hasher;
+    hasher.addInteger(m_splines.size());
+    for (const auto& spline : m_splines) {
+        hasher.addInteger(spline.nodes.size());
+        for (const auto& it : spline.nodes) {
+            hasher.addDouble(it.origin.x());
+            hasher.addDouble(it.origin.y());
+            hasher.addDouble(it.origin.z());
+            hasher.addDouble(it.radius);
+            hasher.addInteger(it.sourceId.high());
+            hasher.addInteger(it.sourceId.low());
+        }
+        hasher.addInteger(spline.isCircle);
+        hasher.addInteger(spline.isClosing);
+        hasher.addInteger(spline.sourceId.high());
+        hasher.addInteger(spline.sourceId.low());
+    }
+    return hasher.result();
+}
+
 const std::vector<Vector3>& StitchMeshBuilder::generatedVertices() const
 {
     return m_generatedVertices;
@@ -40,6 +40,8 @@ public:
 
     StitchMeshBuilder(std::vector<Spline>&& splines);
     void build();
+    // Hash of all the splines, only valid before build()
+    uint64_t inputHash() const;
     const std::vector<Vector3>& generatedVertices() const;
     const std::vector<std::vector<size_t>>& generatedFaces() const;
     const std::vector<std::vector<Vector2>>& generatedFaceUvs() const;
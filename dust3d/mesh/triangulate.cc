@@ -27,17 +27,18 @@
 
 namespace dust3d {
 
-void triangulate(const std::vector<Vector3>& vertices,
-    const std::vector<size_t>& faceIndices,
-    std::vector<std::vector<size_t>>* triangles)
+template <typename Face, typename AddTriangle>
+static void triangulateFace(const std::vector<Vector3>& vertices,
+    const Face& faceIndices,
+    AddTriangle addTriangle)
 {
     if (4 == faceIndices.size()) {
-        triangles->push_back({ faceIndices[0],
+        addTriangle(faceIndices[0],
             faceIndices[1],
-            faceIndices[2] });
-        triangles->push_back({ faceIndices[2],
+            faceIndices[2]);
+        addTriangle(faceIndices[2],
             faceIndices[3],
-            faceIndices[0] });
+            faceIndices[0]);
         return;
     }
 
@@ -75,12 +76,21 @@ void triangulate(const std::vector<Vector3>& vertices,
 
     std::vector<size_t> indices = mapbox::earcut<size_t>(polygons);
     for (size_t i = 0; i < indices.size(); i += 3) {
-        triangles->push_back({ faceIndices[indices[i]],
+        addTriangle(faceIndices[indices[i]],
             faceIndices[indices[i + 1]],
-            faceIndices[indices[i + 2]] });
+            faceIndices[indices[i + 2]]);
     }
 }
 
+void triangulate(const std::vector<Vector3>& vertices,
+    const std::vector<size_t>& faceIndices,
+    std::vector<std::vector<size_t>>* triangles)
+{
+    triangulateFace(vertices, faceIndices, [&](size_t a, size_t b, size_t c) {
+        triangles->push_back({ a, b, c });
+    });
+}
+
 void triangulate(const std::vector<Vector3>& vertices,
     const std::vector<std::vector<size_t>>& faces,
     std::vector<std::vector<size_t>>* triangles)
@@ -94,4 +104,39 @@ void triangulate(const std::vector<Vector3>& vertices,
     }
 }
 
-}
\ No newline at end of file
+template <typename Faces>
+static void triangulateToIndexedTriangles(const std::vector<Vector3>& vertices,
+    const Faces& faces,
+    IndexedTriangles* triangles)
+{
+    auto addTriangle = [&](size_t a, size_t b, size_t c) {
+        triangles->push_back({ (uint32_t)a, (uint32_t)b, (uint32_t)c });
+    };
+    for (const auto& faceIndices : faces) {
+        if (faceIndices.size() < 3)
+            continue;
+        if (3 == faceIndices.size()) {
+            addTriangle(faceIndices[0], faceIndices[1], faceIndices[2]);
+            continue;
+        }
+        triangulateFace(vertices, faceIndices, addTriangle);
+    }
+}
+
+void triangulate(const std::vector<Vector3>& vertices,
+    const std::vector<std::vector<size_t>>& faces,
+    IndexedTriangles* triangles)
+{
+    triangulateToIndexedTriangles(vertices, faces, triangles);
+}
+
+void triangulate(const std::vector<Vector3>& vertices,
+    const IndexedPolygons& faces,
+    IndexedTriangles* triangles)
+{
+    if (faces.indices().size() > faces.size() * 2)
+        triangles->reserve(triangles->size() + faces.indices().size() - faces.size() * 2);
+    triangulateToIndexedTriangles(vertices, faces, triangles);
+}
+
+}
@@ -23,6 +23,7 @@
 #ifndef DUST3D_MESH_TRIANGULATE_H_
 #define DUST3D_MESH_TRIANGULATE_H_
 
+#include <dust3d/base/indexed_mesh.h>
 #include <dust3d/base/vector3.h>
 
 namespace dust3d {
@@ -35,6 +36,14 @@ void triangulate(const std::vector<Vector3>& vertices,
     const std::vector<std::vector<size_t>>& faces,
     std::vector<std::vector<size_t>>* triangles);
 
+void triangulate(const std::vector<Vector3>& vertices,
+    const std::vector<std::vector<size_t>>& faces,
+    IndexedTriangles* triangles);
+
+void triangulate(const std::vector<Vector3>& vertices,
+    const IndexedPolygons& faces,
+    IndexedTriangles* triangles);
+
 }
 
 #endif
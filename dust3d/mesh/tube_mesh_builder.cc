@@ -21,6 +21,7 @@
  */
 
 #include <algorithm>
+#include <dust3d/base/content_hasher.h>
 #include <dust3d/base/debug.h>
 #include <dust3d/mesh/base_normal.h>
 #include <dust3d/mesh/section_remesher.h>
@@ -35,6 +36,34 @@ TubeMeshBuilder::TubeMeshBuilder(const BuildParameters& buildParameters, std::ve
 {
 }
 
+uint64_t TubeMeshBuilder::inputHash() const
+{
+    ContentHasher hasher;
+    hasher.addInteger(m_buildParameters.cutFace.size());
+    for (const auto& it : m_buildParameters.cutFace) {
+        hasher.addDouble(it.x());
+        hasher.addDouble(it.y());
+    }
+    hasher.addDouble(m_buildParameters.deformThickness);
+    hasher.addDouble(m_buildParameters.deformWidth);
+    hasher.addInteger(m_buildParameters.deformUnified);
+    hasher.addDouble(m_buildParameters.baseNormalRotation);
+    hasher.addInteger(m_buildParameters.frontEndRounded);
+    hasher.addInteger(m_buildParameters.backEndRounded);
+    hasher.addInteger(m_buildParameters.interpolationEnabled);
+    hasher.addInteger(m_nodes.size());
+    for (const auto& it : m_nodes) {
+        hasher.addDouble(it.origin.x());
+        hasher.addDouble(it.origin.y());
+        hasher.addDouble(it.origin.z());
+        hasher.addDouble(it.radius);
+        hasher.addInteger(it.sourceId.high());
+        hasher.addInteger(it.sourceId.low());
+    }
+    hasher.addInteger(m_isCircle);
+    return hasher.result();
+}
+
 const Vector3& TubeMeshBuilder::generatedBaseNormal()
 {
     return m_generatedBaseNormal;
@@ -50,7 +79,7 @@ const std::vector<Uuid>& TubeMeshBuilder::generatedVertexSources()
     return m_generatedVertexSources;
 }
 
-const std::vector<std::vector<size_t>>& TubeMeshBuilder::generatedFaces()
+const IndexedPolygons& TubeMeshBuilder::generatedFaces()
 {
     return m_generatedFaces;
 }
@@ -322,8 +351,7 @@ void TubeMeshBuilder::build()
             // The following quad vertices should follow the order strictly,
             // This will group two points from I, and one point from J as a triangle in the later quad to triangles processing.
             // If not follow this order, the front triangle and back triangle maybe cross over because of not be parallel.
-            m_generatedFaces.emplace_back(std::vector<size_t> {
-                cutFaceI[m], cutFaceI[n], cutFaceJ[n], cutFaceJ[m] });
+            m_generatedFaces.push_back({ cutFaceI[m], cutFaceI[n], cutFaceJ[n], cutFaceJ[m] });
             m_generatedFaceUvs.emplace_back(std::vector<Vector2> {
                 tubeUv(cutFaceVertexUvs[i][m]),
                 tubeUv(cutFaceVertexUvs[i][m + 1]),
@@ -336,8 +364,7 @@ void TubeMeshBuilder::build()
             // The following quad vertices should follow the order strictly,
             // This will group two points from I, and one point from J as a triangle in the later quad to triangles processing.
             // If not follow this order, the front triangle and back triangle maybe cross over because of not be parallel.
-            m_generatedFaces.emplace_back(std::vector<size_t> {
-                cutFaceJ[m], cutFaceI[m], cutFaceI[n], cutFaceJ[n] });
+            m_generatedFaces.push_back({ cutFaceJ[m], cutFaceI[m], cutFaceI[n], cutFaceJ[n] });
             m_generatedFaceUvs.emplace_back(std::vector<Vector2> {
                 tubeUv(cutFaceVertexUvs[j][m]),
                 tubeUv(cutFaceVertexUvs[i][m]),
@@ -369,9 +396,9 @@ void TubeMeshBuilder::addCap(const std::vector<size_t>& section, double ringV, d
         std::vector<size_t> newFace(it.size());
         for (size_t i = 0; i < it.size(); ++i)
             newFace[i] = vertexIndices[it[i]];
-        m_generatedFaces.emplace_back(newFace);
         if (reverseU)
-            std::reverse(m_generatedFaces.back().begin(), m_generatedFaces.back().end());
+            std::reverse(newFace.begin(), newFace.end());
+        m_generatedFaces.push_back(newFace);
     }
     for (const auto& it : sectionRemesher.generatedFaceUvs()) {
         m_generatedFaceUvs.emplace_back(it);
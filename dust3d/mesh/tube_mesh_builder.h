@@ -23,6 +23,7 @@
 #ifndef DUST3D_MESH_TUBE_MESH_BUILDER_H_
 #define DUST3D_MESH_TUBE_MESH_BUILDER_H_
 
+#include <dust3d/base/indexed_mesh.h>
 #include <dust3d/base/uuid.h>
 #include <dust3d/base/vector2.h>
 #include <dust3d/base/vector3.h>
@@ -45,10 +46,12 @@ public:
 
     TubeMeshBuilder(const BuildParameters& buildParameters, std::vector<MeshNode>&& nodes, bool isCircle);
     void build();
+    // Hash of all the build inputs, only valid before build()
+    uint64_t inputHash() const;
     const Vector3& generatedBaseNormal();
     const std::vector<Vector3>& generatedVertices();
     const std::vector<Uuid>& generatedVertexSources();
-    const std::vector<std::vector<size_t>>& generatedFaces();
+    const IndexedPolygons& generatedFaces();
     const std::vector<std::vector<Vector2>>& generatedFaceUvs();
 
 private:
@@ -59,7 +62,7 @@ private:
     std::vector<double> m_nodeForwardDistances;
     std::vector<Uuid> m_generatedVertexSources;
     std::vector<Vector3> m_generatedVertices;
-    std::vector<std::vector<size_t>> m_generatedFaces;
+    IndexedPolygons m_generatedFaces;
     std::vector<std::vector<Vector2>> m_generatedFaceUvs;
     Vector3 m_generatedBaseNormal;
     bool m_isCircle = false;
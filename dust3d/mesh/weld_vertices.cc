@@ -1,152 +1,225 @@
-/*
- *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
- *
- *  Permission is hereby granted, free of charge, to any person obtaining a copy
- *  of this software and associated documentation files (the "Software"), to deal
- *  in the Software without restriction, including without limitation the rights
- *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- *  copies of the Software, and to permit persons to whom the Software is
- *  furnished to do so, subject to the following conditions:
-
- *  The above copyright notice and this permission notice shall be included in all
- *  copies or substantial portions of the Software.
-
- *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
- *  SOFTWARE.
- */
-
-#include <dust3d/mesh/weld_vertices.h>
-#include <map>
-#include <unordered_map>
-#include <unordered_set>
-
-namespace dust3d {
-
-size_t weldVertices(const std::vector<Vector3>& sourceVertices, const std::vector<std::vector<size_t>>& sourceTriangles,
-    float allowedSmallestDistance, const std::set<PositionKey>& excludePositions,
-    std::vector<Vector3>& destVertices, std::vector<std::vector<size_t>>& destTriangles)
-{
-    std::unordered_set<int> excludeVertices;
-    for (size_t i = 0; i < sourceVertices.size(); ++i) {
-        if (excludePositions.find(sourceVertices[i]) != excludePositions.end())
-            excludeVertices.insert(i);
-    }
-    float squareOfAllowedSmallestDistance = allowedSmallestDistance * allowedSmallestDistance;
-    std::map<int, int> weldVertexToMap;
-    std::unordered_set<int> weldTargetVertices;
-    std::unordered_set<int> processedFaces;
-    std::map<std::pair<int, int>, std::pair<int, int>> triangleEdgeMap;
-    std::unordered_map<int, int> vertexAdjFaceCountMap;
-    for (int i = 0; i < (int)sourceTriangles.size(); i++) {
-        const auto& faceIndices = sourceTriangles[i];
-        if (faceIndices.size() == 3) {
-            vertexAdjFaceCountMap[faceIndices[0]]++;
-            vertexAdjFaceCountMap[faceIndices[1]]++;
-            vertexAdjFaceCountMap[faceIndices[2]]++;
-            triangleEdgeMap[std::make_pair(faceIndices[0], faceIndices[1])] = std::make_pair(i, faceIndices[2]);
-            triangleEdgeMap[std::make_pair(faceIndices[1], faceIndices[2])] = std::make_pair(i, faceIndices[0]);
-            triangleEdgeMap[std::make_pair(faceIndices[2], faceIndices[0])] = std::make_pair(i, faceIndices[1]);
-        }
-    }
-    for (int i = 0; i < (int)sourceTriangles.size(); i++) {
-        if (processedFaces.find(i) != processedFaces.end())
-            continue;
-        const auto& faceIndices = sourceTriangles[i];
-        if (faceIndices.size() == 3) {
-            bool indicesSeamCheck[3] = {
-                excludeVertices.find(faceIndices[0]) == excludeVertices.end(),
-                excludeVertices.find(faceIndices[1]) == excludeVertices.end(),
-                excludeVertices.find(faceIndices[2]) == excludeVertices.end()
-            };
-            for (int j = 0; j < 3; j++) {
-                int next = (j + 1) % 3;
-                int nextNext = (j + 2) % 3;
-                if (indicesSeamCheck[j] && indicesSeamCheck[next]) {
-                    std::pair<int, int> edge = std::make_pair(faceIndices[j], faceIndices[next]);
-                    int thirdVertexIndex = faceIndices[nextNext];
-                    if ((sourceVertices[edge.first] - sourceVertices[edge.second]).lengthSquared() < squareOfAllowedSmallestDistance) {
-                        auto oppositeEdge = std::make_pair(edge.second, edge.first);
-                        auto findOppositeFace = triangleEdgeMap.find(oppositeEdge);
-                        if (findOppositeFace == triangleEdgeMap.end()) {
-                            continue;
-                        }
-                        int oppositeFaceIndex = findOppositeFace->second.first;
-                        if (((sourceVertices[edge.first] - sourceVertices[thirdVertexIndex]).lengthSquared() < (sourceVertices[edge.second] - sourceVertices[thirdVertexIndex]).lengthSquared()) && vertexAdjFaceCountMap[edge.second] <= 4 && weldVertexToMap.find(edge.second) == weldVertexToMap.end()) {
-                            weldVertexToMap[edge.second] = edge.first;
-                            weldTargetVertices.insert(edge.first);
-                            processedFaces.insert(i);
-                            processedFaces.insert(oppositeFaceIndex);
-                            break;
-                        } else if (vertexAdjFaceCountMap[edge.first] <= 4 && weldVertexToMap.find(edge.first) == weldVertexToMap.end()) {
-                            weldVertexToMap[edge.first] = edge.second;
-                            weldTargetVertices.insert(edge.second);
-                            processedFaces.insert(i);
-                            processedFaces.insert(oppositeFaceIndex);
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-    }
-    int weldedCount = 0;
-    int faceCountAfterWeld = 0;
-    std::map<int, int> oldToNewVerticesMap;
-    for (int i = 0; i < (int)sourceTriangles.size(); i++) {
-        const auto& faceIndices = sourceTriangles[i];
-        std::vector<int> mappedFaceIndices;
-        bool errored = false;
-        for (const auto& index : faceIndices) {
-            int finalIndex = index;
-            int mapTimes = 0;
-            while (mapTimes < 500) {
-                auto findMapResult = weldVertexToMap.find(finalIndex);
-                if (findMapResult == weldVertexToMap.end())
-                    break;
-                finalIndex = findMapResult->second;
-                mapTimes++;
-            }
-            if (mapTimes >= 500) {
-                errored = true;
-                break;
-            }
-            mappedFaceIndices.push_back(finalIndex);
-        }
-        if (errored || mappedFaceIndices.size() < 3)
-            continue;
-        bool welded = false;
-        for (decltype(mappedFaceIndices.size()) j = 0; j < mappedFaceIndices.size(); j++) {
-            int next = (j + 1) % 3;
-            if (mappedFaceIndices[j] == mappedFaceIndices[next]) {
-                welded = true;
-                break;
-            }
-        }
-        if (welded) {
-            weldedCount++;
-            continue;
-        }
-        faceCountAfterWeld++;
-        std::vector<size_t> newFace;
-        for (const auto& index : mappedFaceIndices) {
-            auto findMap = oldToNewVerticesMap.find(index);
-            if (findMap == oldToNewVerticesMap.end()) {
-                size_t newIndex = destVertices.size();
-                newFace.push_back(newIndex);
-                destVertices.push_back(sourceVertices[index]);
-                oldToNewVerticesMap.insert({ index, newIndex });
-            } else {
-                newFace.push_back(findMap->second);
-            }
-        }
-        destTriangles.push_back(newFace);
-    }
-    return weldedCount;
-}
-
-}
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <dust3d/base/spatial_hash_map.h>
+#include <dust3d/mesh/half_edge_map.h>
+#include <dust3d/mesh/weld_vertices.h>
+#include <limits>
+
+namespace dust3d {
+
+size_t weldVertices(std::vector<Vector3>& vertices, std::vector<std::vector<size_t>>& triangles,
+    float allowedSmallestDistance, const std::set<PositionKey>& excludePositions)
+{
+    std::vector<char> excludeVertices(vertices.size(), 0);
+    if (!excludePositions.empty()) {
+        SpatialHashMap<PositionKey, bool> excludePositionMap;
+        excludePositionMap.reserve(excludePositions.size());
+        for (const auto& position : excludePositions)
+            excludePositionMap.insert({ position, true });
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            if (excludePositionMap.count(PositionKey(vertices[i])) > 0)
+                excludeVertices[i] = 1;
+        }
+    }
+    float squareOfAllowedSmallestDistance = allowedSmallestDistance * allowedSmallestDistance;
+
+    std::vector<char> removedFaces(triangles.size(), 0);
+    std::vector<int> vertexAdjFaceCounts(vertices.size(), 0);
+    for (size_t i = 0; i < triangles.size(); ++i) {
+        const auto& faceIndices = triangles[i];
+        if (faceIndices.size() < 3) {
+            removedFaces[i] = 1;
+            continue;
+        }
+        if (faceIndices.size() == 3) {
+            for (const auto& index : faceIndices)
+                ++vertexAdjFaceCounts[index];
+        }
+    }
+
+    // Each pass collapses short edges whose vertex has no more than four adjacent faces, keeping the first come
+    // decision per vertex, then remaps the faces. A face whose vertices were not touched by the previous pass sees
+    // exactly the same edges, lengths and valences as before, so it would fail again; only faces around the
+    // previous collapses are revisited until nothing more collapses.
+    std::vector<char> dirtyVertices(vertices.size(), 1);
+    std::vector<char> processedFaces(triangles.size(), 0);
+    std::vector<size_t> weldVertexTo(vertices.size(), std::numeric_limits<size_t>::max());
+    std::vector<size_t> weldedVertices;
+    std::vector<size_t> candidateFaces;
+    std::vector<size_t> mappedFaceIndices;
+    HalfEdgeMap<size_t> triangleEdgeMap;
+    size_t totalWeldedCount = 0;
+    for (bool firstPass = true;; firstPass = false) {
+        candidateFaces.clear();
+        triangleEdgeMap.clear();
+        for (size_t i = 0; i < triangles.size(); ++i) {
+            const auto& faceIndices = triangles[i];
+            if (removedFaces[i] || faceIndices.size() != 3)
+                continue;
+            if (dirtyVertices[faceIndices[0]] || dirtyVertices[faceIndices[1]] || dirtyVertices[faceIndices[2]])
+                candidateFaces.push_back(i);
+        }
+        triangleEdgeMap.reserve(candidateFaces.size() * 3);
+        for (const auto& i : candidateFaces) {
+            const auto& faceIndices = triangles[i];
+            triangleEdgeMap[makeHalfEdgeKey(faceIndices[0], faceIndices[1])] = i;
+            triangleEdgeMap[makeHalfEdgeKey(faceIndices[1], faceIndices[2])] = i;
+            triangleEdgeMap[makeHalfEdgeKey(faceIndices[2], faceIndices[0])] = i;
+        }
+
+        for (const auto& i : candidateFaces) {
+            if (processedFaces[i])
+                continue;
+            const auto& faceIndices = triangles[i];
+            for (size_t j = 0; j < 3; ++j) {
+                size_t first = faceIndices[j];
+                size_t second = faceIndices[(j + 1) % 3];
+                if (excludeVertices[first] || excludeVertices[second])
+                    continue;
+                if ((vertices[first] - vertices[second]).lengthSquared() >= squareOfAllowedSmallestDistance)
+                    continue;
+                auto findOppositeFace = triangleEdgeMap.find(makeHalfEdgeKey(second, first));
+                if (findOppositeFace == triangleEdgeMap.end())
+                    continue;
+                size_t oppositeFaceIndex = findOppositeFace->second;
+                size_t third = faceIndices[(j + 2) % 3];
+                size_t from = first;
+                size_t to = second;
+                if ((vertices[first] - vertices[third]).lengthSquared() < (vertices[second] - vertices[third]).lengthSquared()
+                    && vertexAdjFaceCounts[second] <= 4 && weldVertexTo[second] == std::numeric_limits<size_t>::max()) {
+                    from = second;
+                    to = first;
+                } else if (!(vertexAdjFaceCounts[first] <= 4 && weldVertexTo[first] == std::numeric_limits<size_t>::max())) {
+                    continue;
+                }
+                weldVertexTo[from] = to;
+                weldedVertices.push_back(from);
+                processedFaces[i] = 1;
+                processedFaces[oppositeFaceIndex] = 1;
+                break;
+            }
+        }
+        for (const auto& i : candidateFaces)
+            processedFaces[i] = 0;
+
+        std::fill(dirtyVertices.begin(), dirtyVertices.end(), 0);
+        size_t weldedCount = 0;
+        if (firstPass || !weldedVertices.empty()) {
+            for (size_t i = 0; i < triangles.size(); ++i) {
+                if (removedFaces[i])
+                    continue;
+                auto& faceIndices = triangles[i];
+                if (!firstPass) {
+                    bool touched = false;
+                    for (const auto& index : faceIndices) {
+                        if (weldVertexTo[index] != std::numeric_limits<size_t>::max()) {
+                            touched = true;
+                            break;
+                        }
+                    }
+                    if (!touched)
+                        continue;
+                }
+                mappedFaceIndices.clear();
+                bool errored = false;
+                for (const auto& index : faceIndices) {
+                    size_t finalIndex = index;
+                    int mapTimes = 0;
+                    while (mapTimes < 500) {
+                        size_t mappedIndex = weldVertexTo[finalIndex];
+                        if (mappedIndex == std::numeric_limits<size_t>::max())
+                            break;
+                        finalIndex = mappedIndex;
+                        mapTimes++;
+                    }
+                    if (mapTimes >= 500) {
+                        errored = true;
+                        break;
+                    }
+                    mappedFaceIndices.push_back(finalIndex);
+                }
+                bool welded = false;
+                if (!errored) {
+                    for (size_t j = 0; j < mappedFaceIndices.size(); ++j) {
+                        if (mappedFaceIndices[j] == mappedFaceIndices[(j + 1) % mappedFaceIndices.size()]) {
+                            welded = true;
+                            break;
+                        }
+                    }
+                }
+                if (!errored && !welded && mappedFaceIndices == faceIndices)
+                    continue;
+                bool isTriangle = faceIndices.size() == 3;
+                for (const auto& index : faceIndices) {
+                    dirtyVertices[index] = 1;
+                    if (isTriangle)
+                        --vertexAdjFaceCounts[index];
+                }
+                if (errored || welded) {
+                    if (welded)
+                        ++weldedCount;
+                    removedFaces[i] = 1;
+                    for (const auto& index : mappedFaceIndices)
+                        dirtyVertices[index] = 1;
+                    continue;
+                }
+                for (size_t j = 0; j < mappedFaceIndices.size(); ++j) {
+                    faceIndices[j] = mappedFaceIndices[j];
+                    dirtyVertices[faceIndices[j]] = 1;
+                    if (isTriangle)
+                        ++vertexAdjFaceCounts[faceIndices[j]];
+                }
+            }
+        }
+        for (const auto& index : weldedVertices)
+            weldVertexTo[index] = std::numeric_limits<size_t>::max();
+        weldedVertices.clear();
+        totalWeldedCount += weldedCount;
+        if (0 == weldedCount)
+            break;
+    }
+
+    std::vector<size_t> oldToNewVertices(vertices.size(), std::numeric_limits<size_t>::max());
+    std::vector<Vector3> weldedVertexPositions;
+    weldedVertexPositions.reserve(vertices.size());
+    size_t faceCount = 0;
+    for (size_t i = 0; i < triangles.size(); ++i) {
+        if (removedFaces[i])
+            continue;
+        for (auto& index : triangles[i]) {
+            if (oldToNewVertices[index] == std::numeric_limits<size_t>::max()) {
+                oldToNewVertices[index] = weldedVertexPositions.size();
+                weldedVertexPositions.push_back(vertices[index]);
+            }
+            index = oldToNewVertices[index];
+        }
+        if (faceCount != i)
+            triangles[faceCount] = std::move(triangles[i]);
+        ++faceCount;
+    }
+    triangles.resize(faceCount);
+    vertices = std::move(weldedVertexPositions);
+    return totalWeldedCount;
+}
+
+}
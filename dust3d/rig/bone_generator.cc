@@ -38,7 +38,7 @@ void BoneGenerator::setTriangles(const std::vector<std::vector<size_t>>& triangl
     m_triangles = triangles;
 }
 
-void BoneGenerator::setPositionToNodeMap(const std::map<PositionKey, Uuid>& positionToNodeMap)
+void BoneGenerator::setPositionToNodeMap(const SpatialHashMap<PositionKey, Uuid>& positionToNodeMap)
 {
     m_positionToNodeMap = positionToNodeMap;
 }
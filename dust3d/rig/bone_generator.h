@@ -26,6 +26,7 @@
 #include <array>
 #include <dust3d/base/color.h>
 #include <dust3d/base/position_key.h>
+#include <dust3d/base/spatial_hash_map.h>
 #include <dust3d/base/uuid.h>
 #include <dust3d/base/vector3.h>
 #include <map>
@@ -74,7 +75,7 @@ public:
 protected:
     void setVertices(const std::vector<Vector3>& vertices);
     void setTriangles(const std::vector<std::vector<size_t>>& triangles);
-    void setPositionToNodeMap(const std::map<PositionKey, Uuid>& positionToNodeMap);
+    void setPositionToNodeMap(const SpatialHashMap<PositionKey, Uuid>& positionToNodeMap);
     void addBone(const Uuid& boneId, const Bone& bone);
     void addNodeBinding(const Uuid& nodeId, const NodeBinding& nodeBidning);
     void addNode(const Uuid& nodeId, const Node& node);
@@ -82,7 +83,7 @@ protected:
 private:
     std::vector<Vector3> m_vertices;
     std::vector<std::vector<size_t>> m_triangles;
-    std::map<PositionKey, Uuid> m_positionToNodeMap;
+    SpatialHashMap<PositionKey, Uuid> m_positionToNodeMap;
     std::map<Uuid, NodeBinding> m_nodeBindingMap;
     std::map<Uuid, Bone> m_boneMap;
     std::map<Uuid, Node> m_nodeMap;
@@ -20,6 +20,7 @@
  *  SOFTWARE.
  */
 
+#include <algorithm>
 #include <cmath>
 #include <dust3d/uv/chart_packer.h>
 #include <dust3d/uv/max_rectangles.h>
@@ -31,6 +32,11 @@ void ChartPacker::setCharts(const std::vector<std::pair<float, float>>& chartSiz
     m_chartSizes = chartSizes;
 }
 
+void ChartPacker::setThreadBudget(ThreadBudget* threadBudget)
+{
+    m_threadBudget = threadBudget;
+}
+
 const std::vector<std::tuple<float, float, float, float, bool>>& ChartPacker::getResult()
 {
     return m_result;
@@ -46,18 +52,34 @@ double ChartPacker::calculateTotalArea()
 }
 
 bool ChartPacker::tryPack(float textureSize)
+{
+    std::vector<std::tuple<float, float, float, float, bool>> packedResult;
+    if (!packWithSize(textureSize, &packedResult))
+        return false;
+    m_result = std::move(packedResult);
+    return true;
+}
+
+bool ChartPacker::packWithSize(float textureSize, std::vector<std::tuple<float, float, float, float, bool>>* packedResult) const
 {
     std::vector<uv::MaxRectanglesSize> rects;
     int width = textureSize * m_floatToIntFactor;
     int height = width;
     float paddingSize = m_paddingSize * width;
     float paddingSize2 = paddingSize + paddingSize;
+    long long totalRectArea = 0;
     for (const auto& chartSize : m_chartSizes) {
         uv::MaxRectanglesSize r;
         r.width = chartSize.first * m_floatToIntFactor + paddingSize2;
         r.height = chartSize.second * m_floatToIntFactor + paddingSize2;
+        if (std::max(r.width, r.height) > width)
+            return false;
+        totalRectArea += (long long)r.width * r.height;
         rects.push_back(r);
     }
+    // The padding grows with the texture, so small sizes often can not hold the padded charts at all
+    if (totalRectArea > (long long)width * height)
+        return false;
     const uv::MaxRectanglesFreeRectChoiceHeuristic methods[] = {
         uv::kMaxRectanglesBestShortSideFit,
         uv::kMaxRectanglesBestLongSideFit,
@@ -65,26 +87,36 @@ bool ChartPacker::tryPack(float textureSize)
         uv::kMaxRectanglesBottomLeftRule,
         uv::kMaxRectanglesContactPointRule
     };
-    float occupancy = 0;
+    const size_t methodCount = sizeof(methods) / sizeof(methods[0]);
+    std::vector<std::vector<uv::MaxRectanglesPosition>> methodResults(methodCount);
+    std::vector<float> methodOccupancies(methodCount, 0.0f);
+    parallelFor(m_threadBudget, methodCount, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            std::vector<uv::MaxRectanglesPosition> result(rects.size());
+            float occupancy = 0;
+            if (0 != maxRectangles(width, height, rects.size(), rects.data(), methods[i], true, result.data(), &occupancy))
+                continue;
+            methodResults[i] = std::move(result);
+            methodOccupancies[i] = occupancy;
+        }
+    });
     float bestOccupancy = 0;
-    std::vector<uv::MaxRectanglesPosition> bestResult;
-    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); ++i) {
-        std::vector<uv::MaxRectanglesPosition> result(rects.size());
-        if (0 != maxRectangles(width, height, rects.size(), rects.data(), methods[i], true, result.data(), &occupancy)) {
+    const std::vector<uv::MaxRectanglesPosition>* bestResult = nullptr;
+    for (size_t i = 0; i < methodCount; ++i) {
+        if (methodResults[i].empty())
             continue;
-        }
-        if (occupancy > bestOccupancy) {
-            bestResult = result;
-            bestOccupancy = occupancy;
+        if (methodOccupancies[i] > bestOccupancy) {
+            bestResult = &methodResults[i];
+            bestOccupancy = methodOccupancies[i];
         }
     }
-    if (bestResult.size() != rects.size())
+    if (nullptr == bestResult || bestResult->size() != rects.size())
         return false;
-    m_result.resize(bestResult.size());
-    for (decltype(bestResult.size()) i = 0; i < bestResult.size(); ++i) {
-        const auto& result = bestResult[i];
+    packedResult->resize(bestResult->size());
+    for (size_t i = 0; i < bestResult->size(); ++i) {
+        const auto& result = (*bestResult)[i];
         const auto& rect = rects[i];
-        auto& dest = m_result[i];
+        auto& dest = (*packedResult)[i];
         std::get<0>(dest) = (float)(result.left + paddingSize) / width;
         std::get<1>(dest) = (float)(result.top + paddingSize) / height;
         std::get<2>(dest) = (float)(rect.width - paddingSize2) / width;
@@ -96,19 +128,36 @@ bool ChartPacker::tryPack(float textureSize)
 
 float ChartPacker::pack()
 {
-    float textureSize = 0;
     float initialGuessSize = std::sqrt(calculateTotalArea() * m_initialAreaGuessFactor);
-    while (true) {
-        textureSize = initialGuessSize * m_textureSizeFactor;
-        ++m_tryNum;
-        if (tryPack(textureSize))
-            break;
-        m_textureSizeFactor += m_textureSizeGrowFactor;
-        if (m_tryNum >= m_maxTryNum) {
-            break;
+
+    std::vector<float> sizeFactors(m_maxTryNum);
+    float sizeFactor = m_textureSizeFactor;
+    for (size_t i = 0; i < m_maxTryNum; ++i) {
+        sizeFactors[i] = sizeFactor;
+        sizeFactor += m_textureSizeGrowFactor;
+    }
+
+    // Packability is not monotonic in the texture size, so the first packable step is still taken in order,
+    // while a window of the following steps is tried speculatively on the spare threads
+    size_t windowSize = nullptr == m_threadBudget ? 1 : m_threadBudget->threadCount();
+    for (size_t firstStep = 0; firstStep < m_maxTryNum; firstStep += windowSize) {
+        size_t stepCount = std::min(windowSize, m_maxTryNum - firstStep);
+        std::vector<std::vector<std::tuple<float, float, float, float, bool>>> stepResults(stepCount);
+        std::vector<char> stepSucceed(stepCount, 0);
+        parallelFor(m_threadBudget, stepCount, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                stepSucceed[i] = packWithSize(initialGuessSize * sizeFactors[firstStep + i], &stepResults[i]);
+        });
+        for (size_t i = 0; i < stepCount; ++i) {
+            ++m_tryNum;
+            m_textureSizeFactor = sizeFactors[firstStep + i];
+            if (stepSucceed[i]) {
+                m_result = std::move(stepResults[i]);
+                return initialGuessSize * m_textureSizeFactor;
+            }
         }
     }
-    return textureSize;
+    return initialGuessSize * m_textureSizeFactor;
 }
 
 }
@@ -24,6 +24,7 @@
 #define DUST3D_UV_CHART_PACKER_H_
 
 #include <cstdlib>
+#include <dust3d/base/task_group.h>
 #include <tuple>
 #include <vector>
 
@@ -32,12 +33,14 @@ namespace dust3d {
 class ChartPacker {
 public:
     void setCharts(const std::vector<std::pair<float, float>>& chartSizes);
+    void setThreadBudget(ThreadBudget* threadBudget);
     const std::vector<std::tuple<float, float, float, float, bool>>& getResult();
     float pack();
     bool tryPack(float textureSize);
 
 private:
     double calculateTotalArea();
+    bool packWithSize(float textureSize, std::vector<std::tuple<float, float, float, float, bool>>* packedResult) const;
 
     std::vector<std::pair<float, float>> m_chartSizes;
     std::vector<std::tuple<float, float, float, float, bool>> m_result;
@@ -48,6 +51,7 @@ private:
     float m_textureSizeFactor = 1.0;
     float m_paddingSize = 0.005;
     size_t m_maxTryNum = 100;
+    ThreadBudget* m_threadBudget = nullptr;
 };
 
 }
@@ -28,353 +28,297 @@
  *
  */
 
-#include <assert.h>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
 #include <dust3d/uv/max_rectangles.h>
-#include <limits.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
+#include <vector>
 
 namespace dust3d {
 namespace uv {
 
-#ifdef MAX
-#undef MAX
-#endif
-#define MAX(a, b) ((a) > (b) ? (a) : (b))
-
-#ifdef MIN
-#undef MIN
-#endif
-#define MIN(a, b) ((a) < (b) ? (a) : (b))
-
-    typedef struct MaxRectanglesRect {
-        struct MaxRectanglesRect* next;
-        struct MaxRectanglesRect* prev;
-        int rectOrder;
-        int x;
-        int y;
-        int width;
-        int height;
-        int inFreeRectLink : 1;
-        int inUsedRectLink : 1;
-        int inInputRectLink : 1;
-    } MaxRectanglesRect;
-
-    typedef struct MaxRectanglesContext {
+    // Free and used rectangles are kept as structure of arrays, so the fit scans walk plain int arrays.
+    // Free rectangles are scanned from the back, newest first, which is the order the original linked list had,
+    // so every tie still resolves the same way.
+    struct MaxRectanglesRects {
+        std::vector<int> x;
+        std::vector<int> y;
+        std::vector<int> width;
+        std::vector<int> height;
+        std::vector<int> id;
+        std::vector<char> removed;
+
+        size_t size() const
+        {
+            return x.size();
+        }
+
+        void clear()
+        {
+            x.clear();
+            y.clear();
+            width.clear();
+            height.clear();
+            id.clear();
+            removed.clear();
+        }
+
+        void add(int left, int top, int rectWidth, int rectHeight, int rectId = -1)
+        {
+            x.push_back(left);
+            y.push_back(top);
+            width.push_back(rectWidth);
+            height.push_back(rectHeight);
+            id.push_back(rectId);
+            removed.push_back(0);
+        }
+
+        void compact()
+        {
+            size_t target = 0;
+            for (size_t i = 0; i < x.size(); ++i) {
+                if (removed[i])
+                    continue;
+                x[target] = x[i];
+                y[target] = y[i];
+                width[target] = width[i];
+                height[target] = height[i];
+                id[target] = id[i];
+                removed[target] = 0;
+                ++target;
+            }
+            x.resize(target);
+            y.resize(target);
+            width.resize(target);
+            height.resize(target);
+            id.resize(target);
+            removed.resize(target);
+        }
+    };
+
+    struct MaxRectanglesPlacement {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    // Best fit of one input rectangle, remembered across placements together with the free rectangle it came from
+    struct MaxRectanglesCandidate {
+        int score1 = INT_MAX;
+        int score2 = INT_MAX;
+        MaxRectanglesPlacement node;
+        int freeRectId = -1;
+    };
+
+    // Buffers are reused by every call on the same thread, so packing does not allocate once they have grown
+    struct MaxRectanglesArena {
+        MaxRectanglesRects freeRects;
+        MaxRectanglesRects usedRects;
+        std::vector<int> usedRectOrders;
+        std::vector<int> inputRects;
+        std::vector<MaxRectanglesCandidate> candidates;
+        std::vector<char> freeRectAlive;
+        size_t firstNewFreeRect = 0;
+    };
+
+    struct MaxRectanglesContext {
         int width;
         int height;
         int rectCount;
-        MaxRectanglesSize* rects;
+        const MaxRectanglesSize* rects;
         MaxRectanglesPosition* layoutResults;
         enum MaxRectanglesFreeRectChoiceHeuristic method;
-        int allowRotations : 1;
-        MaxRectanglesRect* freeRectLink;
-        MaxRectanglesRect* usedRectLink;
-        MaxRectanglesRect* inputRectLink;
-    } MaxRectanglesContext;
+        bool allowRotations;
+        MaxRectanglesArena* arena;
+    };
 
-    static void addRectToLink(MaxRectanglesRect* rect, MaxRectanglesRect** link)
+    // Products are taken in 32-bit and wrap the same way the original int arithmetic did
+    static inline int wrappedMultiply(int a, int b)
     {
-        rect->prev = 0;
-        rect->next = *link;
-        if (*link) {
-            (*link)->prev = rect;
-        }
-        *link = rect;
+        return (int)((unsigned int)a * (unsigned int)b);
     }
 
-    static void freeRectOnLine(MaxRectanglesRect* rect, long line)
+    static inline int wrappedSubtract(int a, int b)
     {
-        free(rect);
+        return (int)((unsigned int)a - (unsigned int)b);
     }
 
-#define freeRect(rect) freeRectOnLine((rect), __LINE__)
-
-    static void removeRectFromLink(MaxRectanglesRect* rect, MaxRectanglesRect** link)
+    static void findPositionForNewNodeBottomLeft(const MaxRectanglesContext* ctx,
+        size_t begin, int width, int height, int* bestY, int* bestX, MaxRectanglesPlacement* bestNode, int* bestId)
     {
-        if (rect->prev) {
-            rect->prev->next = rect->next;
-        }
-        if (rect->next) {
-            rect->next->prev = rect->prev;
-        }
-        if (rect == *link) {
-            *link = rect->next;
-        }
-        freeRect(rect);
-    }
-
-    static void freeLink(MaxRectanglesRect** link)
-    {
-        while (*link) {
-            MaxRectanglesRect* willDel = *link;
-            *link = willDel->next;
-            freeRect(willDel);
-        }
-    }
-
-    static void addRectToFreeRectLinkOnLine(MaxRectanglesContext* ctx,
-        MaxRectanglesRect* rect, long line)
-    {
-        assert(!rect->inInputRectLink && !rect->inFreeRectLink && !rect->inUsedRectLink);
-        rect->inFreeRectLink = 1;
-        addRectToLink(rect, &ctx->freeRectLink);
-    }
-
-#define addRectToFreeRectLink(ctx, rect) addRectToFreeRectLinkOnLine((ctx), (rect), __LINE__)
-
-    static void addRectToUsedRectLink(MaxRectanglesContext* ctx, MaxRectanglesRect* rect)
-    {
-        assert(!rect->inInputRectLink && !rect->inFreeRectLink && !rect->inUsedRectLink);
-        rect->inUsedRectLink = 1;
-        addRectToLink(rect, &ctx->usedRectLink);
-    }
-
-    static void addRectToInputRectLink(MaxRectanglesContext* ctx, MaxRectanglesRect* rect)
-    {
-        assert(!rect->inInputRectLink && !rect->inFreeRectLink && !rect->inUsedRectLink);
-        rect->inInputRectLink = 1;
-        addRectToLink(rect, &ctx->inputRectLink);
-    }
-
-    static void removeAndFreeRectFromUsedRectLink(MaxRectanglesContext* ctx,
-        MaxRectanglesRect* rect)
-    {
-        assert(rect->inUsedRectLink);
-        rect->inUsedRectLink = 0;
-        removeRectFromLink(rect, &ctx->usedRectLink);
-    }
-
-    static void removeAndFreeRectFromFreeRectLink(MaxRectanglesContext* ctx,
-        MaxRectanglesRect* rect)
-    {
-        assert(rect->inFreeRectLink);
-        rect->inFreeRectLink = 0;
-        removeRectFromLink(rect, &ctx->freeRectLink);
-    }
-
-    static void removeAndFreeRectFromInputRectLink(MaxRectanglesContext* ctx,
-        MaxRectanglesRect* rect)
-    {
-        assert(rect->inInputRectLink);
-        rect->inInputRectLink = 0;
-        removeRectFromLink(rect, &ctx->inputRectLink);
-    }
-
-    static MaxRectanglesRect* createRectOnLine(int x, int y, int width, int height,
-        int rectOrder, long line)
-    {
-        MaxRectanglesRect* rect = (MaxRectanglesRect*)calloc(1, sizeof(MaxRectanglesRect));
-        if (!rect) {
-            return 0;
-        }
-        rect->x = x;
-        rect->y = y;
-        rect->width = width;
-        rect->height = height;
-        rect->rectOrder = rectOrder;
-        return rect;
-    }
-
-#define createRect(x, y, width, height, rectOrder) createRectOnLine((x), (y), (width), (height), (rectOrder), __LINE__)
-
-    MaxRectanglesRect* findPositionForNewNodeBottomLeft(MaxRectanglesContext* ctx,
-        int width, int height, int* bestY, int* bestX)
-    {
-        MaxRectanglesRect* loop;
-        MaxRectanglesRect* bestNode = createRect(0, 0, 0, 0, 0);
-        if (!bestNode) {
-            return 0;
-        }
+        const MaxRectanglesRects& freeRects = ctx->arena->freeRects;
+        const int* freeX = freeRects.x.data();
+        const int* freeY = freeRects.y.data();
+        const int* freeWidth = freeRects.width.data();
+        const int* freeHeight = freeRects.height.data();
 
         *bestY = INT_MAX;
 
-        for (loop = ctx->freeRectLink; loop; loop = loop->next) {
+        for (size_t i = freeRects.size(); i-- > begin;) {
             // Try to place the rectangle in upright (non-flipped) orientation.
-            if (loop->width >= width && loop->height >= height) {
-                int topSideY = (int)loop->y + height;
-                if (topSideY < *bestY || (topSideY == *bestY && loop->x < *bestX)) {
-                    bestNode->x = loop->x;
-                    bestNode->y = loop->y;
-                    bestNode->width = width;
-                    bestNode->height = height;
+            if (freeWidth[i] >= width && freeHeight[i] >= height) {
+                int topSideY = freeY[i] + height;
+                if (topSideY < *bestY || (topSideY == *bestY && freeX[i] < *bestX)) {
+                    *bestNode = { freeX[i], freeY[i], width, height };
+                    *bestId = freeRects.id[i];
                     *bestY = topSideY;
-                    *bestX = (int)loop->x;
+                    *bestX = freeX[i];
                 }
             }
-            if (ctx->allowRotations && loop->width >= height && loop->height >= width) {
-                int topSideY = (int)loop->y + width;
-                if (topSideY < *bestY || (topSideY == *bestY && loop->x < *bestX)) {
-                    bestNode->x = loop->x;
-                    bestNode->y = loop->y;
-                    bestNode->width = height;
-                    bestNode->height = width;
+            if (ctx->allowRotations && freeWidth[i] >= height && freeHeight[i] >= width) {
+                int topSideY = freeY[i] + width;
+                if (topSideY < *bestY || (topSideY == *bestY && freeX[i] < *bestX)) {
+                    *bestNode = { freeX[i], freeY[i], height, width };
+                    *bestId = freeRects.id[i];
                     *bestY = topSideY;
-                    *bestX = (int)loop->x;
+                    *bestX = freeX[i];
                 }
             }
         }
-        return bestNode;
     }
 
-    MaxRectanglesRect* findPositionForNewNodeBestShortSideFit(MaxRectanglesContext* ctx,
-        int width, int height, int* bestShortSideFit, int* bestLongSideFit)
+    static void findPositionForNewNodeBestShortSideFit(const MaxRectanglesContext* ctx,
+        size_t begin, int width, int height, int* bestShortSideFit, int* bestLongSideFit, MaxRectanglesPlacement* bestNode, int* bestId)
     {
-        MaxRectanglesRect* loop;
-        MaxRectanglesRect* bestNode = createRect(0, 0, 0, 0, 0);
-        if (!bestNode) {
-            return 0;
-        }
+        const MaxRectanglesRects& freeRects = ctx->arena->freeRects;
+        const int* freeX = freeRects.x.data();
+        const int* freeY = freeRects.y.data();
+        const int* freeWidth = freeRects.width.data();
+        const int* freeHeight = freeRects.height.data();
 
         *bestShortSideFit = INT_MAX;
 
-        for (loop = ctx->freeRectLink; loop; loop = loop->next) {
+        for (size_t i = freeRects.size(); i-- > begin;) {
             // Try to place the rectangle in upright (non-flipped) orientation.
-            if (loop->width >= width && loop->height >= height) {
-                int leftoverHoriz = abs((int)loop->width - width);
-                int leftoverVert = abs((int)loop->height - height);
-                int shortSideFit = MIN(leftoverHoriz, leftoverVert);
-                int longSideFit = MAX(leftoverHoriz, leftoverVert);
+            if (freeWidth[i] >= width && freeHeight[i] >= height) {
+                int leftoverHoriz = abs(freeWidth[i] - width);
+                int leftoverVert = abs(freeHeight[i] - height);
+                int shortSideFit = std::min(leftoverHoriz, leftoverVert);
+                int longSideFit = std::max(leftoverHoriz, leftoverVert);
 
                 if (shortSideFit < *bestShortSideFit || (shortSideFit == *bestShortSideFit && longSideFit < *bestLongSideFit)) {
-                    bestNode->x = loop->x;
-                    bestNode->y = loop->y;
-                    bestNode->width = width;
-                    bestNode->height = height;
+                    *bestNode = { freeX[i], freeY[i], width, height };
+                    *bestId = freeRects.id[i];
                     *bestShortSideFit = shortSideFit;
                     *bestLongSideFit = longSideFit;
                 }
             }
 
-            if (ctx->allowRotations && loop->width >= height && loop->height >= width) {
-                int flippedLeftoverHoriz = abs((int)loop->width - height);
-                int flippedLeftoverVert = abs((int)loop->height - width);
-                int flippedShortSideFit = MIN(flippedLeftoverHoriz, flippedLeftoverVert);
-                int flippedLongSideFit = MAX(flippedLeftoverHoriz, flippedLeftoverVert);
+            if (ctx->allowRotations && freeWidth[i] >= height && freeHeight[i] >= width) {
+                int flippedLeftoverHoriz = abs(freeWidth[i] - height);
+                int flippedLeftoverVert = abs(freeHeight[i] - width);
+                int flippedShortSideFit = std::min(flippedLeftoverHoriz, flippedLeftoverVert);
+                int flippedLongSideFit = std::max(flippedLeftoverHoriz, flippedLeftoverVert);
 
                 if (flippedShortSideFit < *bestShortSideFit || (flippedShortSideFit == *bestShortSideFit && flippedLongSideFit < *bestLongSideFit)) {
-                    bestNode->x = loop->x;
-                    bestNode->y = loop->y;
-                    bestNode->width = height;
-                    bestNode->height = width;
+                    *bestNode = { freeX[i], freeY[i], height, width };
+                    *bestId = freeRects.id[i];
                     *bestShortSideFit = flippedShortSideFit;
                     *bestLongSideFit = flippedLongSideFit;
                 }
             }
         }
-        return bestNode;
     }
 
-    MaxRectanglesRect* findPositionForNewNodeBestLongSideFit(MaxRectanglesContext* ctx,
-        int width, int height, int* bestShortSideFit, int* bestLongSideFit)
+    static void findPositionForNewNodeBestLongSideFit(const MaxRectanglesContext* ctx,
+        size_t begin, int width, int height, int* bestShortSideFit, int* bestLongSideFit, MaxRectanglesPlacement* bestNode, int* bestId)
     {
-        MaxRectanglesRect* loop;
-        MaxRectanglesRect* bestNode = createRect(0, 0, 0, 0, 0);
-        if (!bestNode) {
-            return 0;
-        }
+        const MaxRectanglesRects& freeRects = ctx->arena->freeRects;
+        const int* freeX = freeRects.x.data();
+        const int* freeY = freeRects.y.data();
+        const int* freeWidth = freeRects.width.data();
+        const int* freeHeight = freeRects.height.data();
 
         *bestLongSideFit = INT_MAX;
 
-        for (loop = ctx->freeRectLink; loop; loop = loop->next) {
+        for (size_t i = freeRects.size(); i-- > begin;) {
             // Try to place the rectangle in upright (non-flipped) orientation.
-            if (loop->width >= width && loop->height >= height) {
-                int leftoverHoriz = abs((int)loop->width - width);
-                int leftoverVert = abs((int)loop->height - height);
-                int shortSideFit = MIN(leftoverHoriz, leftoverVert);
-                int longSideFit = MAX(leftoverHoriz, leftoverVert);
+            if (freeWidth[i] >= width && freeHeight[i] >= height) {
+                int leftoverHoriz = abs(freeWidth[i] - width);
+                int leftoverVert = abs(freeHeight[i] - height);
+                int shortSideFit = std::min(leftoverHoriz, leftoverVert);
+                int longSideFit = std::max(leftoverHoriz, leftoverVert);
 
                 if (longSideFit < *bestLongSideFit || (longSideFit == *bestLongSideFit && shortSideFit < *bestShortSideFit)) {
-                    bestNode->x = loop->x;
-                    bestNode->y = loop->y;
-                    bestNode->width = width;
-                    bestNode->height = height;
+                    *bestNode = { freeX[i], freeY[i], width, height };
+                    *bestId = freeRects.id[i];
                     *bestShortSideFit = shortSideFit;
                     *bestLongSideFit = longSideFit;
                 }
             }
 
-            if (ctx->allowRotations && loop->width >= height && loop->height >= width) {
-                int leftoverHoriz = abs((int)loop->width - height);
-                int leftoverVert = abs((int)loop->height - width);
-                int shortSideFit = MIN(leftoverHoriz, leftoverVert);
-                int longSideFit = MAX(leftoverHoriz, leftoverVert);
+            if (ctx->allowRotations && freeWidth[i] >= height && freeHeight[i] >= width) {
+                int leftoverHoriz = abs(freeWidth[i] - height);
+                int leftoverVert = abs(freeHeight[i] - width);
+                int shortSideFit = std::min(leftoverHoriz, leftoverVert);
+                int longSideFit = std::max(leftoverHoriz, leftoverVert);
 
                 if (longSideFit < *bestLongSideFit || (longSideFit == *bestLongSideFit && shortSideFit < *bestShortSideFit)) {
-                    bestNode->x = loop->x;
-                    bestNode->y = loop->y;
-                    bestNode->width = height;
-                    bestNode->height = width;
+                    *bestNode = { freeX[i], freeY[i], height, width };
+                    *bestId = freeRects.id[i];
                     *bestShortSideFit = shortSideFit;
                     *bestLongSideFit = longSideFit;
                 }
             }
         }
-        return bestNode;
     }
 
-    MaxRectanglesRect* findPositionForNewNodeBestAreaFit(MaxRectanglesContext* ctx,
-        int width, int height, int* bestAreaFit, int* bestShortSideFit)
+    static void findPositionForNewNodeBestAreaFit(const MaxRectanglesContext* ctx,
+        size_t begin, int width, int height, int* bestAreaFit, int* bestShortSideFit, MaxRectanglesPlacement* bestNode, int* bestId)
     {
-        MaxRectanglesRect* loop;
-        MaxRectanglesRect* bestNode = createRect(0, 0, 0, 0, 0);
-        if (!bestNode) {
-            return 0;
-        }
+        const MaxRectanglesRects& freeRects = ctx->arena->freeRects;
+        const int* freeX = freeRects.x.data();
+        const int* freeY = freeRects.y.data();
+        const int* freeWidth = freeRects.width.data();
+        const int* freeHeight = freeRects.height.data();
+        int area = wrappedMultiply(width, height);
 
         *bestAreaFit = INT_MAX;
 
-        for (loop = ctx->freeRectLink; loop; loop = loop->next) {
-            int areaFit = (int)loop->width * (int)loop->height - width * height;
+        for (size_t i = freeRects.size(); i-- > begin;) {
+            int areaFit = wrappedSubtract(wrappedMultiply(freeWidth[i], freeHeight[i]), area);
 
             // Try to place the rectangle in upright (non-flipped) orientation.
-            if (loop->width >= width && loop->height >= height) {
-                int leftoverHoriz = abs((int)loop->width - width);
-                int leftoverVert = abs((int)loop->height - height);
-                int shortSideFit = MIN(leftoverHoriz, leftoverVert);
+            if (freeWidth[i] >= width && freeHeight[i] >= height) {
+                int leftoverHoriz = abs(freeWidth[i] - width);
+                int leftoverVert = abs(freeHeight[i] - height);
+                int shortSideFit = std::min(leftoverHoriz, leftoverVert);
 
                 if (areaFit < *bestAreaFit || (areaFit == *bestAreaFit && shortSideFit < *bestShortSideFit)) {
-                    bestNode->x = loop->x;
-                    bestNode->y = loop->y;
-                    bestNode->width = width;
-                    bestNode->height = height;
+                    *bestNode = { freeX[i], freeY[i], width, height };
+                    *bestId = freeRects.id[i];
                     *bestShortSideFit = shortSideFit;
                     *bestAreaFit = areaFit;
                 }
             }
 
-            if (ctx->allowRotations && loop->width >= height && loop->height >= width) {
-                int leftoverHoriz = abs((int)loop->width - height);
-                int leftoverVert = abs((int)loop->height - width);
-                int shortSideFit = MIN(leftoverHoriz, leftoverVert);
+            if (ctx->allowRotations && freeWidth[i] >= height && freeHeight[i] >= width) {
+                int leftoverHoriz = abs(freeWidth[i] - height);
+                int leftoverVert = abs(freeHeight[i] - width);
+                int shortSideFit = std::min(leftoverHoriz, leftoverVert);
 
                 if (areaFit < *bestAreaFit || (areaFit == *bestAreaFit && shortSideFit < *bestShortSideFit)) {
-                    bestNode->x = loop->x;
-                    bestNode->y = loop->y;
-                    bestNode->width = height;
-                    bestNode->height = width;
+                    *bestNode = { freeX[i], freeY[i], height, width };
+                    *bestId = freeRects.id[i];
                     *bestShortSideFit = shortSideFit;
                     *bestAreaFit = areaFit;
                 }
             }
         }
-        return bestNode;
     }
 
     /// Returns 0 if the two intervals i1 and i2 are disjoint, or the length of their overlap otherwise.
-    static int commonIntervalLength(int i1start, int i1end,
+    static inline int commonIntervalLength(int i1start, int i1end,
         int i2start, int i2end)
     {
-        if (i1end < i2start || i2end < i1start)
-            return 0;
-        return MIN(i1end, i2end) - MAX(i1start, i2start);
+        return std::max(0, std::min(i1end, i2end) - std::max(i1start, i2start));
     }
 
-    static int contactPointScoreNode(MaxRectanglesContext* ctx, int x, int y,
+    static int contactPointScoreNode(const MaxRectanglesContext* ctx, int x, int y,
         int width, int height)
     {
-        MaxRectanglesRect* loop;
+        const MaxRectanglesRects& usedRects = ctx->arena->usedRects;
         int score = 0;
 
         if (x == 0 || x + width == ctx->width)
@@ -382,297 +326,256 @@ namespace uv {
         if (y == 0 || y + height == ctx->height)
             score += width;
 
-        for (loop = ctx->usedRectLink; loop; loop = loop->next) {
-            if (loop->x == x + width || loop->x + loop->width == x)
-                score += commonIntervalLength((int)loop->y,
-                    (int)loop->y + (int)loop->height,
-                    y, y + height);
-            if (loop->y == y + height || loop->y + loop->height == y)
-                score += commonIntervalLength((int)loop->x,
-                    (int)loop->x + (int)loop->width, x, x + width);
+        const int* usedX = usedRects.x.data();
+        const int* usedY = usedRects.y.data();
+        const int* usedWidth = usedRects.width.data();
+        const int* usedHeight = usedRects.height.data();
+        size_t usedCount = usedRects.size();
+        int right = x + width;
+        int bottom = y + height;
+        for (size_t i = 0; i < usedCount; ++i) {
+            int usedRight = usedX[i] + usedWidth[i];
+            int usedBottom = usedY[i] + usedHeight[i];
+            int verticalContact = (usedX[i] == right || usedRight == x) ? commonIntervalLength(usedY[i], usedBottom, y, bottom) : 0;
+            int horizontalContact = (usedY[i] == bottom || usedBottom == y) ? commonIntervalLength(usedX[i], usedRight, x, right) : 0;
+            score += verticalContact + horizontalContact;
         }
         return score;
     }
 
-    MaxRectanglesRect* findPositionForNewNodeContactPoint(MaxRectanglesContext* ctx,
-        int width, int height, int* bestContactScore)
+    static void findPositionForNewNodeContactPoint(const MaxRectanglesContext* ctx,
+        int width, int height, int* bestContactScore, MaxRectanglesPlacement* bestNode)
     {
-        MaxRectanglesRect* loop;
-        MaxRectanglesRect* bestNode = createRect(0, 0, 0, 0, 0);
-        if (!bestNode) {
-            return 0;
-        }
+        const MaxRectanglesRects& freeRects = ctx->arena->freeRects;
 
         *bestContactScore = -1;
 
-        for (loop = ctx->freeRectLink; loop; loop = loop->next) {
+        for (size_t i = freeRects.size(); i-- > 0;) {
+            int freeX = freeRects.x[i];
+            int freeY = freeRects.y[i];
             // Try to place the rectangle in upright (non-flipped) orientation.
-            if (loop->width >= width && loop->height >= height) {
-                int score = contactPointScoreNode(ctx, (int)loop->x, (int)loop->y,
-                    width, height);
+            if (freeRects.width[i] >= width && freeRects.height[i] >= height) {
+                int score = contactPointScoreNode(ctx, freeX, freeY, width, height);
                 if (score > *bestContactScore) {
-                    bestNode->x = (int)loop->x;
-                    bestNode->y = (int)loop->y;
-                    bestNode->width = width;
-                    bestNode->height = height;
+                    *bestNode = { freeX, freeY, width, height };
                     *bestContactScore = score;
                 }
             }
-            if (ctx->allowRotations && loop->width >= height && loop->height >= width) {
-                int score = contactPointScoreNode(ctx, (int)loop->x, (int)loop->y,
-                    height, width);
+            if (ctx->allowRotations && freeRects.width[i] >= height && freeRects.height[i] >= width) {
+                int score = contactPointScoreNode(ctx, freeX, freeY, height, width);
                 if (score > *bestContactScore) {
-                    bestNode->x = (int)loop->x;
-                    bestNode->y = (int)loop->y;
-                    bestNode->width = height;
-                    bestNode->height = width;
+                    *bestNode = { freeX, freeY, height, width };
                     *bestContactScore = score;
                 }
             }
         }
-        return bestNode;
     }
 
-    static int initContext(MaxRectanglesContext* ctx)
-    {
-        int i;
-        MaxRectanglesRect* newRect = createRect(0, 0, ctx->width, ctx->height, 0);
-        if (!newRect) {
-            return -1;
-        }
-        addRectToFreeRectLink(ctx, newRect);
-        for (i = 0; i < ctx->rectCount; ++i) {
-            newRect = createRect(0, 0, ctx->rects[i].width,
-                ctx->rects[i].height, i + 1);
-            if (!newRect) {
-                return -1;
-            }
-            addRectToInputRectLink(ctx, newRect);
-        }
-        return 0;
-    }
-
-    static void releaseContext(MaxRectanglesContext* ctx)
-    {
-        freeLink(&ctx->usedRectLink);
-        freeLink(&ctx->freeRectLink);
-        freeLink(&ctx->inputRectLink);
-    }
-
-    static float getOccupany(MaxRectanglesContext* ctx)
+    static float getOccupany(const MaxRectanglesContext* ctx)
     {
+        const MaxRectanglesRects& usedRects = ctx->arena->usedRects;
         unsigned long long usedSurfaceArea = 0;
-        MaxRectanglesRect* loop = ctx->usedRectLink;
-        while (loop) {
-            usedSurfaceArea += loop->width * loop->height;
-            loop = loop->next;
-        }
-        return (float)usedSurfaceArea / (ctx->width * ctx->height);
+        for (size_t i = 0; i < usedRects.size(); ++i)
+            usedSurfaceArea += wrappedMultiply(usedRects.width[i], usedRects.height[i]);
+        return (float)usedSurfaceArea / wrappedMultiply(ctx->width, ctx->height);
     }
 
-    MaxRectanglesRect* scoreRect(MaxRectanglesContext* ctx, int width, int height,
-        enum MaxRectanglesFreeRectChoiceHeuristic method, int* score1, int* score2)
+    static void scoreRect(const MaxRectanglesContext* ctx, size_t begin, int width, int height,
+        enum MaxRectanglesFreeRectChoiceHeuristic method, int* score1, int* score2, MaxRectanglesPlacement* newNode, int* freeRectId)
     {
-        MaxRectanglesRect* newNode = 0;
+        *newNode = MaxRectanglesPlacement();
         *score1 = INT_MAX;
         *score2 = INT_MAX;
+        *freeRectId = -1;
         switch (method) {
         case kMaxRectanglesBestShortSideFit:
-            newNode = findPositionForNewNodeBestShortSideFit(ctx, width, height,
-                score1, score2);
+            findPositionForNewNodeBestShortSideFit(ctx, begin, width, height, score1, score2, newNode, freeRectId);
             break;
         case kMaxRectanglesBottomLeftRule:
-            newNode = findPositionForNewNodeBottomLeft(ctx, width, height,
-                score1, score2);
+            findPositionForNewNodeBottomLeft(ctx, begin, width, height, score1, score2, newNode, freeRectId);
             break;
         case kMaxRectanglesContactPointRule:
-            newNode = findPositionForNewNodeContactPoint(ctx, width, height, score1);
+            findPositionForNewNodeContactPoint(ctx, width, height, score1, newNode);
             *score1 = -*score1; // Reverse since we are minimizing, but for contact point score bigger is better.
             break;
         case kMaxRectanglesBestLongSideFit:
-            newNode = findPositionForNewNodeBestLongSideFit(ctx, width, height,
-                score2, score1);
+            findPositionForNewNodeBestLongSideFit(ctx, begin, width, height, score2, score1, newNode, freeRectId);
             break;
         case kMaxRectanglesBestAreaFit:
-            newNode = findPositionForNewNodeBestAreaFit(ctx, width, height,
-                score1, score2);
+            findPositionForNewNodeBestAreaFit(ctx, begin, width, height, score1, score2, newNode, freeRectId);
             break;
         }
 
         // Cannot fit the current rectangle.
-        if (!newNode || 0 == newNode->height) {
+        if (0 == newNode->height) {
             *score1 = INT_MAX;
             *score2 = INT_MAX;
         }
+    }
 
-        return newNode;
+    // Every rule but the contact point one scores an input against a free rectangle alone, so a remembered best fit
+    // stays valid while its free rectangle survives, and only the rectangles split off since then need a scan.
+    // They come first in scan order, so a remembered fit only wins when it is strictly better, exactly as a full scan decides.
+    static void scoreRect(const MaxRectanglesContext* ctx, int width, int height,
+        int* score1, int* score2, MaxRectanglesPlacement* newNode, MaxRectanglesCandidate* candidate)
+    {
+        const MaxRectanglesArena* arena = ctx->arena;
+        int freeRectId = -1;
+        if (kMaxRectanglesContactPointRule == ctx->method) {
+            scoreRect(ctx, 0, width, height, ctx->method, score1, score2, newNode, &freeRectId);
+            return;
+        }
+        bool useCandidate = -1 == candidate->freeRectId || arena->freeRectAlive[candidate->freeRectId];
+        scoreRect(ctx, useCandidate ? arena->firstNewFreeRect : 0, width, height, ctx->method, score1, score2, newNode, &freeRectId);
+        if (useCandidate && -1 != candidate->freeRectId) {
+            if (candidate->score1 < *score1 || (candidate->score1 == *score1 && candidate->score2 < *score2)) {
+                *score1 = candidate->score1;
+                *score2 = candidate->score2;
+                *newNode = candidate->node;
+                freeRectId = candidate->freeRectId;
+            }
+        }
+        candidate->score1 = *score1;
+        candidate->score2 = *score2;
+        candidate->node = *newNode;
+        candidate->freeRectId = freeRectId;
     }
 
-    int splitFreeNode(MaxRectanglesContext* ctx, MaxRectanglesRect* freeNode,
-        MaxRectanglesRect* usedNode)
+    static void addFreeRect(MaxRectanglesArena* arena, int x, int y, int width, int height)
     {
+        arena->freeRects.add(x, y, width, height, (int)arena->freeRectAlive.size());
+        arena->freeRectAlive.push_back(1);
+    }
+
+    static bool splitFreeNode(MaxRectanglesArena* arena, size_t freeIndex,
+        const MaxRectanglesPlacement& usedNode)
+    {
+        const MaxRectanglesRects& freeRects = arena->freeRects;
+        int freeX = freeRects.x[freeIndex];
+        int freeY = freeRects.y[freeIndex];
+        int freeWidth = freeRects.width[freeIndex];
+        int freeHeight = freeRects.height[freeIndex];
+
         // Test with SAT if the rectangles even intersect.
-        if (usedNode->x >= freeNode->x + freeNode->width || usedNode->x + usedNode->width <= freeNode->x || usedNode->y >= freeNode->y + freeNode->height || usedNode->y + usedNode->height <= freeNode->y) {
-            return 0;
+        if (usedNode.x >= freeX + freeWidth || usedNode.x + usedNode.width <= freeX || usedNode.y >= freeY + freeHeight || usedNode.y + usedNode.height <= freeY) {
+            return false;
         }
 
-        if (usedNode->x < freeNode->x + freeNode->width && usedNode->x + usedNode->width > freeNode->x) {
+        if (usedNode.x < freeX + freeWidth && usedNode.x + usedNode.width > freeX) {
             // New node at the top side of the used node.
-            if (usedNode->y > freeNode->y && usedNode->y < freeNode->y + freeNode->height) {
-                MaxRectanglesRect* newNode = createRect(freeNode->x, freeNode->y,
-                    freeNode->width, freeNode->height, 0);
-                if (!newNode) {
-                    return -1;
-                }
-                newNode->height = usedNode->y - newNode->y;
-                addRectToFreeRectLink(ctx, newNode);
-            }
+            if (usedNode.y > freeY && usedNode.y < freeY + freeHeight)
+                addFreeRect(arena, freeX, freeY, freeWidth, usedNode.y - freeY);
 
             // New node at the bottom side of the used node.
-            if (usedNode->y + usedNode->height < freeNode->y + freeNode->height) {
-                MaxRectanglesRect* newNode = createRect(freeNode->x, freeNode->y,
-                    freeNode->width, freeNode->height, 0);
-                if (!newNode) {
-                    return -1;
-                }
-                newNode->y = usedNode->y + usedNode->height;
-                newNode->height = freeNode->y + freeNode->height - (usedNode->y + usedNode->height);
-                addRectToFreeRectLink(ctx, newNode);
-            }
+            if (usedNode.y + usedNode.height < freeY + freeHeight)
+                addFreeRect(arena, freeX, usedNode.y + usedNode.height, freeWidth, freeY + freeHeight - (usedNode.y + usedNode.height));
         }
 
-        if (usedNode->y < freeNode->y + freeNode->height && usedNode->y + usedNode->height > freeNode->y) {
+        if (usedNode.y < freeY + freeHeight && usedNode.y + usedNode.height > freeY) {
             // New node at the left side of the used node.
-            if (usedNode->x > freeNode->x && usedNode->x < freeNode->x + freeNode->width) {
-                MaxRectanglesRect* newNode = createRect(freeNode->x, freeNode->y,
-                    freeNode->width, freeNode->height, 0);
-                if (!newNode) {
-                    return -1;
-                }
-                newNode->width = usedNode->x - newNode->x;
-                addRectToFreeRectLink(ctx, newNode);
-            }
+            if (usedNode.x > freeX && usedNode.x < freeX + freeWidth)
+                addFreeRect(arena, freeX, freeY, usedNode.x - freeX, freeHeight);
 
             // New node at the right side of the used node.
-            if (usedNode->x + usedNode->width < freeNode->x + freeNode->width) {
-                MaxRectanglesRect* newNode = createRect(freeNode->x, freeNode->y,
-                    freeNode->width, freeNode->height, 0);
-                if (!newNode) {
-                    return -1;
-                }
-                newNode->x = usedNode->x + usedNode->width;
-                newNode->width = freeNode->x + freeNode->width - (usedNode->x + usedNode->width);
-                addRectToFreeRectLink(ctx, newNode);
-            }
+            if (usedNode.x + usedNode.width < freeX + freeWidth)
+                addFreeRect(arena, usedNode.x + usedNode.width, freeY, freeX + freeWidth - (usedNode.x + usedNode.width), freeHeight);
         }
 
-        return 1;
+        return true;
     }
 
-    static int isContainedIn(MaxRectanglesRect* a, MaxRectanglesRect* b)
+    static bool isContainedIn(const MaxRectanglesRects& rects, size_t a, size_t b)
     {
-        return a->x >= b->x && a->y >= b->y && a->x + a->width <= b->x + b->width && a->y + a->height <= b->y + b->height;
+        return rects.x[a] >= rects.x[b] && rects.y[a] >= rects.y[b] && rects.x[a] + rects.width[a] <= rects.x[b] + rects.width[b] && rects.y[a] + rects.height[a] <= rects.y[b] + rects.height[b];
     }
 
-    static void pruneFreeList(MaxRectanglesContext* ctx)
+    // Only the rectangles split off by the last placement need checking: the older ones were already
+    // pruned against each other, and each new one lies inside a removed older one, so it can never contain a survivor.
+    static void pruneFreeList(MaxRectanglesRects& freeRects, size_t firstNewIndex)
     {
-        MaxRectanglesRect* outerLoop = ctx->freeRectLink;
-        while (outerLoop) {
-            MaxRectanglesRect* innerLoop;
-            MaxRectanglesRect* outer = outerLoop;
-            outerLoop = outerLoop->next;
-            innerLoop = outerLoop;
-            while (innerLoop) {
-                MaxRectanglesRect* inner = innerLoop;
-                innerLoop = innerLoop->next;
-                if (isContainedIn(outer, inner)) {
-                    removeAndFreeRectFromFreeRectLink(ctx, outer);
+        for (size_t outer = freeRects.size(); outer-- > firstNewIndex;) {
+            if (freeRects.removed[outer])
+                continue;
+            for (size_t inner = outer; inner-- > 0;) {
+                if (freeRects.removed[inner])
+                    continue;
+                if (isContainedIn(freeRects, outer, inner)) {
+                    freeRects.removed[outer] = 1;
                     break;
                 }
-                if (isContainedIn(inner, outer)) {
-                    if (inner == outerLoop) {
-                        outerLoop = outerLoop->next;
-                    }
-                    removeAndFreeRectFromFreeRectLink(ctx, inner);
-                }
+                if (isContainedIn(freeRects, inner, outer))
+                    freeRects.removed[inner] = 1;
             }
         }
     }
 
-    static int placeRect(MaxRectanglesContext* ctx, MaxRectanglesRect* rect)
+    static void placeRect(MaxRectanglesContext* ctx, const MaxRectanglesPlacement& rect, int rectOrder)
     {
-        MaxRectanglesRect* loop = ctx->freeRectLink;
-        while (loop) {
-            MaxRectanglesRect* freeNode = loop;
-            int splitResult = splitFreeNode(ctx, freeNode, rect);
-            if (splitResult < 0) {
-                return -1;
-            }
-            loop = loop->next;
-            if (splitResult) {
-                removeAndFreeRectFromFreeRectLink(ctx, freeNode);
-            }
-        }
-        pruneFreeList(ctx);
-        addRectToUsedRectLink(ctx, rect);
-        return 0;
+        MaxRectanglesArena* arena = ctx->arena;
+        MaxRectanglesRects& freeRects = arena->freeRects;
+        size_t oldCount = freeRects.size();
+        for (size_t i = oldCount; i-- > 0;) {
+            if (splitFreeNode(arena, i, rect))
+                freeRects.removed[i] = 1;
+        }
+        pruneFreeList(freeRects, oldCount);
+        size_t survivedOldCount = 0;
+        for (size_t i = 0; i < freeRects.size(); ++i) {
+            if (freeRects.removed[i])
+                arena->freeRectAlive[freeRects.id[i]] = 0;
+            else if (i < oldCount)
+                ++survivedOldCount;
+        }
+        freeRects.compact();
+        arena->firstNewFreeRect = survivedOldCount;
+        ctx->arena->usedRects.add(rect.x, rect.y, rect.width, rect.height);
+        ctx->arena->usedRectOrders.push_back(rectOrder);
     }
 
     static int startLayout(MaxRectanglesContext* ctx)
     {
-        while (ctx->inputRectLink) {
+        std::vector<int>& inputRects = ctx->arena->inputRects;
+        while (!inputRects.empty()) {
             int bestScore1 = INT_MAX;
             int bestScore2 = INT_MAX;
-            MaxRectanglesRect* bestNode = 0;
-            MaxRectanglesRect* bestRect = 0;
-            MaxRectanglesRect* loop = ctx->inputRectLink;
-            while (loop) {
+            MaxRectanglesPlacement bestNode;
+            size_t bestInput = inputRects.size();
+            for (size_t i = 0; i < inputRects.size(); ++i) {
+                const MaxRectanglesSize& rect = ctx->rects[inputRects[i]];
                 int score1 = 0;
                 int score2 = 0;
-                MaxRectanglesRect* newRect = 0;
-                newRect = scoreRect(ctx, loop->width, loop->height, ctx->method, &score1, &score2);
-                if (!newRect) {
-                    return -1;
-                }
+                MaxRectanglesPlacement newNode;
+                scoreRect(ctx, rect.width, rect.height, &score1, &score2, &newNode, &ctx->arena->candidates[inputRects[i]]);
                 if (score1 < bestScore1 || (score1 == bestScore1 && score2 < bestScore2)) {
                     bestScore1 = score1;
                     bestScore2 = score2;
-                    if (bestNode) {
-                        freeRect(bestNode);
-                    }
-                    bestRect = loop;
-                    bestNode = newRect;
-                    newRect = 0;
+                    bestInput = i;
+                    bestNode = newNode;
                 }
-                if (newRect) {
-                    freeRect(newRect);
-                }
-                loop = loop->next;
             }
-            if (!bestNode) {
+            if (bestInput == inputRects.size()) {
                 return -1;
             }
-            if (bestNode->width != bestRect->width || bestNode->height != bestRect->height) {
-                bestNode->rectOrder = -bestRect->rectOrder;
-            } else {
-                bestNode->rectOrder = bestRect->rectOrder;
-            }
-            placeRect(ctx, bestNode);
-            removeAndFreeRectFromInputRectLink(ctx, bestRect);
+            const MaxRectanglesSize& bestRect = ctx->rects[inputRects[bestInput]];
+            int rectOrder = inputRects[bestInput] + 1;
+            if (bestNode.width != bestRect.width || bestNode.height != bestRect.height)
+                rectOrder = -rectOrder;
+            placeRect(ctx, bestNode, rectOrder);
+            inputRects.erase(inputRects.begin() + bestInput);
         }
         return 0;
     }
 
     static void fillResults(MaxRectanglesContext* ctx)
     {
-        MaxRectanglesRect* loop = ctx->usedRectLink;
-        while (loop) {
-            int index = abs(loop->rectOrder) - 1;
+        const MaxRectanglesRects& usedRects = ctx->arena->usedRects;
+        const std::vector<int>& usedRectOrders = ctx->arena->usedRectOrders;
+        for (size_t i = 0; i < usedRects.size(); ++i) {
+            int index = abs(usedRectOrders[i]) - 1;
             MaxRectanglesPosition* result = &ctx->layoutResults[index];
-            result->left = loop->x;
-            result->top = loop->y;
-            result->rotated = loop->rectOrder < 0;
-            loop = loop->next;
+            result->left = usedRects.x[i];
+            result->top = usedRects.y[i];
+            result->rotated = usedRectOrders[i] < 0;
         }
     }
 
@@ -680,29 +583,37 @@ namespace uv {
         enum MaxRectanglesFreeRectChoiceHeuristic method, int allowRotations,
         MaxRectanglesPosition* layoutResults, float* occupancy)
     {
+        thread_local MaxRectanglesArena arena;
+        arena.freeRects.clear();
+        arena.usedRects.clear();
+        arena.usedRectOrders.clear();
+        arena.inputRects.clear();
+        arena.candidates.assign(rectCount, MaxRectanglesCandidate());
+        arena.freeRectAlive.clear();
+        arena.firstNewFreeRect = 0;
+
         MaxRectanglesContext contextStruct;
         MaxRectanglesContext* ctx = &contextStruct;
-        memset(ctx, 0, sizeof(MaxRectanglesContext));
         ctx->width = width;
         ctx->height = height;
         ctx->method = method;
-        ctx->allowRotations = allowRotations;
+        ctx->allowRotations = 0 != allowRotations;
         ctx->rectCount = rectCount;
         ctx->rects = rects;
         ctx->layoutResults = layoutResults;
-        if (0 != initContext(ctx)) {
-            releaseContext(ctx);
-            return -1;
-        }
-        if (0 != startLayout(ctx)) {
-            releaseContext(ctx);
+        ctx->arena = &arena;
+
+        addFreeRect(&arena, 0, 0, width, height);
+        // Inputs are visited from the last one to the first, as the original list was built by prepending
+        for (int i = rectCount - 1; i >= 0; --i)
+            arena.inputRects.push_back(i);
+
+        if (0 != startLayout(ctx))
             return -1;
-        }
         if (occupancy) {
             *occupancy = getOccupany(ctx);
         }
         fillResults(ctx);
-        releaseContext(ctx);
         return 0;
     }
 
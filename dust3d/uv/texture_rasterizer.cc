@@ -0,0 +1,269 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <dust3d/uv/texture_rasterizer.h>
+
+namespace dust3d {
+
+static inline uint32_t premultiply(uint32_t color)
+{
+    uint32_t alpha = color >> 24;
+    uint32_t redBlue = (color & 0xff00ff) * alpha;
+    redBlue = ((redBlue + ((redBlue >> 8) & 0xff00ff) + 0x800080) >> 8) & 0xff00ff;
+    uint32_t green = ((color >> 8) & 0xff) * alpha;
+    green = (green + ((green >> 8) & 0xff) + 0x80) & 0xff00;
+    return (alpha << 24) | green | redBlue;
+}
+
+static inline uint32_t multiplyBytes(uint32_t color, uint32_t factor)
+{
+    uint32_t redBlue = (color & 0xff00ff) * factor;
+    redBlue = ((redBlue + ((redBlue >> 8) & 0xff00ff) + 0x800080) >> 8) & 0xff00ff;
+    uint32_t alphaGreen = ((color >> 8) & 0xff00ff) * factor;
+    alphaGreen = (alphaGreen + ((alphaGreen >> 8) & 0xff00ff) + 0x800080) & 0xff00ff00;
+    return alphaGreen | redBlue;
+}
+
+static inline uint32_t sourceOver(uint32_t destination, uint32_t source)
+{
+    uint32_t alpha = source >> 24;
+    if (255 == alpha)
+        return source;
+    if (0 == alpha)
+        return destination;
+    return premultiply(source) + multiplyBytes(destination, 255 - alpha);
+}
+
+static inline uint32_t grayOf(uint32_t color)
+{
+    return (((color >> 16) & 0xff) * 11 + ((color >> 8) & 0xff) * 16 + (color & 0xff) * 5) / 32;
+}
+
+TextureRasterizer::TextureRasterizer(size_t width, size_t height)
+    : m_width(width)
+    , m_height(height)
+{
+}
+
+void TextureRasterizer::setBackgroundColor(uint32_t color)
+{
+    m_backgroundColor = color;
+}
+
+void TextureRasterizer::setThreadCount(size_t threadCount)
+{
+    if (threadCount <= 1) {
+        m_threadBudget.reset();
+        return;
+    }
+    m_threadBudget = std::make_unique<ThreadBudget>(threadCount);
+}
+
+void TextureRasterizer::addLayout(const Layout& layout)
+{
+    m_layouts.push_back(layout);
+}
+
+void TextureRasterizer::addClipRect(int left, int top, int width, int height)
+{
+    Rect rect;
+    rect.left = std::max(left, 0);
+    rect.top = std::max(top, 0);
+    rect.right = std::min(left + width, (int)m_width);
+    rect.bottom = std::min(top + height, (int)m_height);
+    if (rect.left >= rect.right || rect.top >= rect.bottom)
+        return;
+    m_clipRects.push_back(rect);
+}
+
+// Same 16.16 fixed point stepping Qt uses when it draws a scaled image without smoothing,
+// so the result matches QImage::scaled with Qt::FastTransformation
+void TextureRasterizer::buildNearestOffsets(size_t sourceSize, size_t targetSize, size_t multiplier, std::vector<size_t>* offsets)
+{
+    double scale = (double)targetSize / sourceSize;
+    uint32_t step = (uint32_t)(int)(65536 / scale);
+    uint32_t position = (uint32_t)((int)std::ceil(0.5 * step) - 1);
+    offsets->resize(targetSize);
+    for (size_t i = 0; i < targetSize; ++i) {
+        (*offsets)[i] = std::min((size_t)(position >> 16), sourceSize - 1) * multiplier;
+        position += step;
+    }
+}
+
+void TextureRasterizer::prepareLayout(const Layout& layout, PreparedLayout* prepared) const
+{
+    prepared->rect.left = layout.left;
+    prepared->rect.top = layout.top;
+    prepared->rect.right = layout.left + std::max(layout.width, 0);
+    prepared->rect.bottom = layout.top + std::max(layout.height, 0);
+    prepared->color = layout.color;
+    if (nullptr == layout.image)
+        return;
+    const Image& image = *layout.image;
+    if (nullptr == image.pixels || 0 == image.width || 0 == image.height || layout.width <= 0 || layout.height <= 0) {
+        prepared->rect.right = prepared->rect.left;
+        return;
+    }
+    prepared->image = layout.image;
+    if (layout.flipped) {
+        // Resized to the transposed size, rotated by 90 degrees and mirrored, which is a plain transpose
+        buildNearestOffsets(image.height, layout.width, image.stride, &prepared->columnOffsets);
+        buildNearestOffsets(image.width, layout.height, 1, &prepared->rowOffsets);
+    } else {
+        buildNearestOffsets(image.width, layout.width, 1, &prepared->columnOffsets);
+        buildNearestOffsets(image.height, layout.height, image.stride, &prepared->rowOffsets);
+    }
+}
+
+void TextureRasterizer::fillRect(const Rect& rect, uint32_t* pixels, size_t stride) const
+{
+    for (int y = rect.top; y < rect.bottom; ++y) {
+        uint32_t* row = pixels + y * stride;
+        std::fill(row + rect.left, row + rect.right, m_backgroundColor);
+    }
+}
+
+void TextureRasterizer::drawLayout(const PreparedLayout& layout, const Rect& clip, uint32_t* pixels, size_t stride)
+{
+    if (nullptr == layout.image) {
+        for (int y = clip.top; y < clip.bottom; ++y) {
+            uint32_t* row = pixels + y * stride;
+            if (255 == (layout.color >> 24)) {
+                std::fill(row + clip.left, row + clip.right, layout.color);
+                continue;
+            }
+            for (int x = clip.left; x < clip.right; ++x)
+                row[x] = sourceOver(row[x], layout.color);
+        }
+        return;
+    }
+    const size_t* columnOffsets = layout.columnOffsets.data() - layout.rect.left;
+    for (int y = clip.top; y < clip.bottom; ++y) {
+        uint32_t* row = pixels + y * stride;
+        const uint32_t* source = layout.image->pixels + layout.rowOffsets[y - layout.rect.top];
+        for (int x = clip.left; x < clip.right; ++x)
+            row[x] = sourceOver(row[x], source[columnOffsets[x]]);
+    }
+}
+
+void TextureRasterizer::rasterize(uint32_t* pixels, size_t stride)
+{
+    std::vector<PreparedLayout> layouts(m_layouts.size());
+    parallelFor(m_threadBudget.get(), m_layouts.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            prepareLayout(m_layouts[i], &layouts[i]);
+    });
+
+    std::vector<Rect> clipRects = m_clipRects;
+    if (clipRects.empty()) {
+        Rect whole;
+        whole.right = (int)m_width;
+        whole.bottom = (int)m_height;
+        clipRects.push_back(whole);
+    }
+
+    size_t tileColumns = (m_width + m_tileSize - 1) / m_tileSize;
+    size_t tileRows = (m_height + m_tileSize - 1) / m_tileSize;
+    std::vector<std::vector<size_t>> tileLayouts(tileColumns * tileRows);
+    for (size_t i = 0; i < layouts.size(); ++i) {
+        const auto& rect = layouts[i].rect;
+        int left = std::max(rect.left, 0);
+        int top = std::max(rect.top, 0);
+        int right = std::min(rect.right, (int)m_width);
+        int bottom = std::min(rect.bottom, (int)m_height);
+        if (left >= right || top >= bottom)
+            continue;
+        for (int row = top / m_tileSize; row <= (bottom - 1) / m_tileSize; ++row) {
+            for (int column = left / m_tileSize; column <= (right - 1) / m_tileSize; ++column)
+                tileLayouts[row * tileColumns + column].push_back(i);
+        }
+    }
+
+    parallelFor(
+        m_threadBudget.get(), tileLayouts.size(), [&](size_t begin, size_t end) {
+            for (size_t tileIndex = begin; tileIndex < end; ++tileIndex) {
+                Rect tile;
+                tile.left = (int)(tileIndex % tileColumns) * m_tileSize;
+                tile.top = (int)(tileIndex / tileColumns) * m_tileSize;
+                tile.right = std::min(tile.left + m_tileSize, (int)m_width);
+                tile.bottom = std::min(tile.top + m_tileSize, (int)m_height);
+                for (const auto& clipRect : clipRects) {
+                    Rect area;
+                    area.left = std::max(tile.left, clipRect.left);
+                    area.top = std::max(tile.top, clipRect.top);
+                    area.right = std::min(tile.right, clipRect.right);
+                    area.bottom = std::min(tile.bottom, clipRect.bottom);
+                    if (area.left >= area.right || area.top >= area.bottom)
+                        continue;
+                    fillRect(area, pixels, stride);
+                    for (const auto& layoutIndex : tileLayouts[tileIndex]) {
+                        const auto& layout = layouts[layoutIndex];
+                        Rect clip;
+                        clip.left = std::max(area.left, layout.rect.left);
+                        clip.top = std::max(area.top, layout.rect.top);
+                        clip.right = std::min(area.right, layout.rect.right);
+                        clip.bottom = std::min(area.bottom, layout.rect.bottom);
+                        if (clip.left >= clip.right || clip.top >= clip.bottom)
+                            continue;
+                        drawLayout(layout, clip, pixels, stride);
+                    }
+                }
+            }
+        },
+        16);
+}
+
+// Each channel is written by its own straight loop over the row, which the compiler turns into vector code
+void TextureRasterizer::packMetalnessRoughnessAmbientOcclusion(const Image* metalness,
+    const Image* roughness,
+    const Image* ambientOcclusion,
+    uint32_t* pixels, size_t stride, size_t width, size_t height,
+    ThreadBudget* threadBudget)
+{
+    parallelFor(
+        threadBudget, height, [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; ++y) {
+                uint32_t* row = pixels + y * stride;
+                std::fill(row, row + width, 0xffffff00);
+                if (nullptr != ambientOcclusion) {
+                    const uint32_t* source = ambientOcclusion->pixels + y * ambientOcclusion->stride;
+                    for (size_t x = 0; x < width; ++x)
+                        row[x] = (row[x] & 0xff00ffff) | (grayOf(source[x]) << 16);
+                }
+                if (nullptr != roughness) {
+                    const uint32_t* source = roughness->pixels + y * roughness->stride;
+                    for (size_t x = 0; x < width; ++x)
+                        row[x] = (row[x] & 0xffff00ff) | (grayOf(source[x]) << 8);
+                }
+                if (nullptr != metalness) {
+                    const uint32_t* source = metalness->pixels + y * metalness->stride;
+                    for (size_t x = 0; x < width; ++x)
+                        row[x] = (row[x] & 0xffffff00) | grayOf(source[x]);
+                }
+            }
+        },
+        64);
+}
+
+}
@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2016-2021 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_UV_TEXTURE_RASTERIZER_H_
+#define DUST3D_UV_TEXTURE_RASTERIZER_H_
+
+#include <cstdint>
+#include <dust3d/base/task_group.h>
+#include <memory>
+#include <vector>
+
+namespace dust3d {
+
+// Paints packed layouts into a 32 bits 0xAARRGGBB texture, tile by tile, so the tiles can be filled in parallel.
+// Source images are resized with nearest sampling and blended source over, the destination is assumed opaque.
+class TextureRasterizer {
+public:
+    struct Image {
+        const uint32_t* pixels = nullptr;
+        size_t width = 0;
+        size_t height = 0;
+        size_t stride = 0;
+    };
+
+    struct Layout {
+        int left = 0;
+        int top = 0;
+        int width = 0;
+        int height = 0;
+        uint32_t color = 0xffffffff;
+        const Image* image = nullptr;
+        bool flipped = false;
+    };
+
+    TextureRasterizer(size_t width, size_t height);
+    void setBackgroundColor(uint32_t color);
+    void setThreadCount(size_t threadCount);
+    void addLayout(const Layout& layout);
+    void addClipRect(int left, int top, int width, int height);
+    void rasterize(uint32_t* pixels, size_t stride);
+
+    static void packMetalnessRoughnessAmbientOcclusion(const Image* metalness,
+        const Image* roughness,
+        const Image* ambientOcclusion,
+        uint32_t* pixels, size_t stride, size_t width, size_t height,
+        ThreadBudget* threadBudget = nullptr);
+
+private:
+    struct Rect {
+        int left = 0;
+        int top = 0;
+        int right = 0;
+        int bottom = 0;
+    };
+
+    struct PreparedLayout {
+        Rect rect;
+        uint32_t color = 0xffffffff;
+        const Image* image = nullptr;
+        std::vector<size_t> columnOffsets;
+        std::vector<size_t> rowOffsets;
+    };
+
+    size_t m_width = 0;
+    size_t m_height = 0;
+    uint32_t m_backgroundColor = 0xffffffff;
+    std::vector<Layout> m_layouts;
+    std::vector<Rect> m_clipRects;
+    std::unique_ptr<ThreadBudget> m_threadBudget;
+    int m_tileSize = 64;
+
+    void prepareLayout(const Layout& layout, PreparedLayout* prepared) const;
+    void fillRect(const Rect& rect, uint32_t* pixels, size_t stride) const;
+    static void drawLayout(const PreparedLayout& layout, const Rect& clip, uint32_t* pixels, size_t stride);
+    static void buildNearestOffsets(size_t sourceSize, size_t targetSize, size_t multiplier, std::vector<size_t>* offsets);
+};
+
+}
+
+#endif
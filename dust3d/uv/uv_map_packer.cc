@@ -20,9 +20,11 @@
  *  SOFTWARE.
  */
 
+#include <algorithm>
 #include <dust3d/base/debug.h>
 #include <dust3d/uv/chart_packer.h>
 #include <dust3d/uv/uv_map_packer.h>
+#include <set>
 
 namespace dust3d {
 
@@ -35,7 +37,7 @@ void UvMapPacker::addPart(const Part& part)
     m_partTriangleUvs.push_back(part);
 }
 
-void UvMapPacker::addSeams(const std::vector<std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>>>& seamTriangleUvs)
+void UvMapPacker::addSeams(const std::vector<SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>>>& seamTriangleUvs)
 {
     for (const auto& it : seamTriangleUvs)
         m_seams.push_back(it);
@@ -48,7 +50,7 @@ void UvMapPacker::resolveSeamUvs()
         std::array<Vector2, 3> uv;
     };
 
-    std::map<std::array<PositionKey, 2>, TriangleUv> halfEdgeToUvMap;
+    SpatialHashMap<std::array<PositionKey, 2>, TriangleUv> halfEdgeToUvMap;
     for (size_t partIndex = 0; partIndex < m_partTriangleUvs.size(); ++partIndex) {
         const auto& part = m_partTriangleUvs[partIndex];
         for (const auto& it : part.localUv) {
@@ -77,6 +79,183 @@ void UvMapPacker::resolveSeamUvs()
     }
 }
 
+void UvMapPacker::setThreadCount(size_t threadCount)
+{
+    if (threadCount <= 1) {
+        m_threadBudget.reset();
+        return;
+    }
+    m_threadBudget = std::make_unique<ThreadBudget>(threadCount);
+}
+
+void UvMapPacker::setPreviousState(const PackedState& state)
+{
+    m_previousState = std::make_unique<PackedState>(state);
+}
+
+bool UvMapPacker::findFreeRect(double width, double height, const std::vector<Rectangle>& occupiedRects,
+    const PackedChart* previousChart, Rectangle* rect, bool* flipped) const
+{
+    const double epsilon = 1e-9;
+    auto isFree = [&](const Rectangle& candidate) {
+        if (candidate.left() - m_paddingSize < -epsilon || candidate.top() - m_paddingSize < -epsilon)
+            return false;
+        if (candidate.right() + m_paddingSize > 1.0 + epsilon || candidate.bottom() + m_paddingSize > 1.0 + epsilon)
+            return false;
+        double gap = m_paddingSize + m_paddingSize - epsilon;
+        for (const auto& occupied : occupiedRects) {
+            if (candidate.left() < occupied.right() + gap
+                && occupied.left() < candidate.right() + gap
+                && candidate.top() < occupied.bottom() + gap
+                && occupied.top() < candidate.bottom() + gap)
+                return false;
+        }
+        return true;
+    };
+
+    // A resized chart keeps its corner when it still fits there
+    if (nullptr != previousChart) {
+        Rectangle candidate = previousChart->flipped ? Rectangle(previousChart->rect.left(), previousChart->rect.top(), height, width)
+                                                     : Rectangle(previousChart->rect.left(), previousChart->rect.top(), width, height);
+        if (isFree(candidate)) {
+            *rect = candidate;
+            *flipped = previousChart->flipped;
+            return true;
+        }
+    }
+
+    std::vector<double> lefts = { m_paddingSize };
+    std::vector<double> tops = { m_paddingSize };
+    for (const auto& occupied : occupiedRects) {
+        lefts.push_back(occupied.right() + m_paddingSize + m_paddingSize);
+        tops.push_back(occupied.bottom() + m_paddingSize + m_paddingSize);
+    }
+    std::sort(lefts.begin(), lefts.end());
+    std::sort(tops.begin(), tops.end());
+
+    // Topmost, then leftmost, free corner; the rotated chart only wins when it sits strictly higher
+    bool found = false;
+    for (int orientation = 0; orientation < 2; ++orientation) {
+        double candidateWidth = 0 == orientation ? width : height;
+        double candidateHeight = 0 == orientation ? height : width;
+        for (const auto& top : tops) {
+            if (found && top >= rect->top())
+                break;
+            for (const auto& left : lefts) {
+                Rectangle candidate(left, top, candidateWidth, candidateHeight);
+                if (!isFree(candidate))
+                    continue;
+                *rect = candidate;
+                *flipped = 0 != orientation;
+                found = true;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+bool UvMapPacker::packIncrementally(std::vector<std::tuple<float, float, float, float, bool>>* packedResult)
+{
+    if (nullptr == m_previousState || m_previousState->textureSize <= 0.0)
+        return false;
+
+    std::unordered_map<Uuid, const PackedChart*> previousCharts;
+    for (const auto& chart : m_previousState->charts) {
+        if (chart.partId.isNull())
+            continue;
+        previousCharts.insert({ chart.partId, &chart });
+    }
+
+    double textureSize = m_previousState->textureSize;
+    std::vector<Rectangle> occupiedRects;
+    std::vector<std::pair<size_t, const PackedChart*>> pendingParts;
+    packedResult->resize(m_partTriangleUvs.size());
+    for (size_t i = 0; i < m_partTriangleUvs.size(); ++i) {
+        const auto& part = m_partTriangleUvs[i];
+        auto findChart = previousCharts.find(part.partId);
+        if (findChart == previousCharts.end()) {
+            pendingParts.push_back({ i, nullptr });
+            continue;
+        }
+        const PackedChart* chart = findChart->second;
+        previousCharts.erase(findChart);
+        if (chart->chartWidth != part.width || chart->chartHeight != part.height) {
+            pendingParts.push_back({ i, chart });
+            continue;
+        }
+        const auto& rect = chart->rect;
+        (*packedResult)[i] = chart->flipped ? std::make_tuple((float)rect.left(), (float)rect.top(), (float)rect.height(), (float)rect.width(), true)
+                                            : std::make_tuple((float)rect.left(), (float)rect.top(), (float)rect.width(), (float)rect.height(), false);
+        occupiedRects.push_back(rect);
+    }
+    if (occupiedRects.empty())
+        return false;
+
+    std::stable_sort(pendingParts.begin(), pendingParts.end(), [&](const std::pair<size_t, const PackedChart*>& first, const std::pair<size_t, const PackedChart*>& second) {
+        const auto& firstPart = m_partTriangleUvs[first.first];
+        const auto& secondPart = m_partTriangleUvs[second.first];
+        return firstPart.width * firstPart.height > secondPart.width * secondPart.height;
+    });
+    for (const auto& it : pendingParts) {
+        const auto& part = m_partTriangleUvs[it.first];
+        double width = part.width / textureSize;
+        double height = part.height / textureSize;
+        Rectangle rect;
+        bool flipped = false;
+        if (!findFreeRect(width, height, occupiedRects, it.second, &rect, &flipped))
+            return false;
+        (*packedResult)[it.first] = std::make_tuple((float)rect.left(), (float)rect.top(), (float)width, (float)height, flipped);
+        occupiedRects.push_back(rect);
+    }
+
+    double chartArea = 0.0;
+    for (const auto& part : m_partTriangleUvs)
+        chartArea += part.width * part.height;
+    if (chartArea / (textureSize * textureSize) < m_previousState->fullPackOccupancy * m_minimalOccupancyRatio)
+        return false;
+
+    m_packedTextureSize = textureSize;
+    return true;
+}
+
+void UvMapPacker::collectDirtyRects()
+{
+    m_dirtyRects.clear();
+    if (!m_isIncrementallyPacked) {
+        m_dirtyRects.push_back(Rectangle(0.0, 0.0, 1.0, 1.0));
+        return;
+    }
+
+    auto isSameRect = [](const Rectangle& first, const Rectangle& second) {
+        return first.left() == second.left() && first.top() == second.top()
+            && first.width() == second.width() && first.height() == second.height();
+    };
+
+    std::unordered_map<Uuid, const PackedChart*> previousCharts;
+    for (const auto& chart : m_previousState->charts)
+        previousCharts.insert({ chart.partId, &chart });
+    std::set<const PackedChart*> unchangedCharts;
+    for (const auto& chart : m_packedState.charts) {
+        auto findChart = previousCharts.find(chart.partId);
+        if (findChart != previousCharts.end()) {
+            const auto& previous = *findChart->second;
+            if (isSameRect(previous.rect, chart.rect)
+                && previous.flipped == chart.flipped
+                && previous.id == chart.id
+                && previous.color.toString() == chart.color.toString()) {
+                unchangedCharts.insert(findChart->second);
+                continue;
+            }
+        }
+        m_dirtyRects.push_back(chart.rect);
+    }
+    for (const auto& chart : m_previousState->charts) {
+        if (unchangedCharts.end() == unchangedCharts.find(&chart))
+            m_dirtyRects.push_back(chart.rect);
+    }
+}
+
 void UvMapPacker::pack()
 {
     if (m_partTriangleUvs.empty())
@@ -84,17 +263,25 @@ void UvMapPacker::pack()
 
     resolveSeamUvs();
 
-    std::vector<std::pair<float, float>> chartSizes(m_partTriangleUvs.size());
-    for (size_t i = 0; i < m_partTriangleUvs.size(); ++i) {
-        const auto& part = m_partTriangleUvs[i];
-        //dust3dDebug << "part.width:" << part.width << "part.height:" << part.height;
-        chartSizes[i] = { part.width, part.height };
+    std::vector<std::tuple<float, float, float, float, bool>> packedResult;
+    m_isIncrementallyPacked = packIncrementally(&packedResult);
+    if (!m_isIncrementallyPacked) {
+        std::vector<std::pair<float, float>> chartSizes(m_partTriangleUvs.size());
+        for (size_t i = 0; i < m_partTriangleUvs.size(); ++i) {
+            const auto& part = m_partTriangleUvs[i];
+            //dust3dDebug << "part.width:" << part.width << "part.height:" << part.height;
+            chartSizes[i] = { part.width, part.height };
+        }
+
+        ChartPacker chartPacker;
+        chartPacker.setCharts(chartSizes);
+        chartPacker.setThreadBudget(m_threadBudget.get());
+        m_packedTextureSize = chartPacker.pack();
+        packedResult = chartPacker.getResult();
     }
 
-    ChartPacker chartPacker;
-    chartPacker.setCharts(chartSizes);
-    m_packedTextureSize = chartPacker.pack();
-    const auto& packedResult = chartPacker.getResult();
+    m_packedState.charts.clear();
+    m_packedState.textureSize = m_packedTextureSize;
     for (size_t i = 0; i < packedResult.size(); ++i) {
         auto& part = m_partTriangleUvs[i];
         const auto& result = packedResult[i];
@@ -107,6 +294,7 @@ void UvMapPacker::pack()
         Layout layout;
         layout.color = part.color;
         layout.id = part.id;
+        layout.partId = part.partId;
         layout.flipped = flipped;
         if (flipped) {
             layout.left = left;
@@ -139,8 +327,28 @@ void UvMapPacker::pack()
                     Vector2((left * m_packedTextureSize + it.second[2].x() * partWidth) / m_packedTextureSize,
                         (top * m_packedTextureSize + it.second[2].y() * partHeight) / m_packedTextureSize) } });
         }
+        PackedChart chart;
+        chart.partId = part.partId;
+        chart.id = part.id;
+        chart.color = part.color;
+        chart.chartWidth = part.width;
+        chart.chartHeight = part.height;
+        chart.rect = Rectangle(layout.left, layout.top, layout.width, layout.height);
+        chart.flipped = flipped;
+        m_packedState.charts.push_back(chart);
         m_packedLayouts.emplace_back(layout);
     }
+
+    if (m_isIncrementallyPacked) {
+        m_packedState.fullPackOccupancy = m_previousState->fullPackOccupancy;
+    } else {
+        double chartArea = 0.0;
+        for (const auto& part : m_partTriangleUvs)
+            chartArea += part.width * part.height;
+        m_packedState.fullPackOccupancy = m_packedTextureSize > 0.0 ? chartArea / (m_packedTextureSize * m_packedTextureSize) : 0.0;
+    }
+
+    collectDirtyRects();
 }
 
 double UvMapPacker::packedTextureSize()
@@ -152,4 +360,19 @@ const std::vector<UvMapPacker::Layout>& UvMapPacker::packedLayouts()
 {
     return m_packedLayouts;
 }
+
+const UvMapPacker::PackedState& UvMapPacker::packedState()
+{
+    return m_packedState;
+}
+
+bool UvMapPacker::isIncrementallyPacked()
+{
+    return m_isIncrementallyPacked;
+}
+
+const std::vector<Rectangle>& UvMapPacker::dirtyRects()
+{
+    return m_dirtyRects;
+}
 }
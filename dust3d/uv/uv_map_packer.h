@@ -26,9 +26,14 @@
 #include <array>
 #include <dust3d/base/color.h>
 #include <dust3d/base/position_key.h>
+#include <dust3d/base/rectangle.h>
+#include <dust3d/base/spatial_hash_map.h>
+#include <dust3d/base/task_group.h>
 #include <dust3d/base/uuid.h>
 #include <dust3d/base/vector2.h>
 #include <map>
+#include <memory>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
@@ -38,37 +43,72 @@ class UvMapPacker {
 public:
     struct Part {
         Uuid id;
+        Uuid partId;
         Color color;
         double width = 0.0;
         double height = 0.0;
-        std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>> localUv;
+        SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>> localUv;
     };
 
     struct Layout {
         Uuid id;
+        Uuid partId;
         Color color;
         double left = 0.0;
         double top = 0.0;
         double width = 0.0;
         double height = 0.0;
         bool flipped = false;
-        std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>> globalUv;
+        SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>> globalUv;
+    };
+
+    struct PackedChart {
+        Uuid partId;
+        Uuid id;
+        Color color;
+        double chartWidth = 0.0;
+        double chartHeight = 0.0;
+        Rectangle rect;
+        bool flipped = false;
+    };
+
+    // Result of the last pack, handed to the next packer so charts whose size did not change can stay in place
+    struct PackedState {
+        std::vector<PackedChart> charts;
+        double textureSize = 0.0;
+        double fullPackOccupancy = 0.0;
     };
 
     UvMapPacker();
     void addPart(const Part& part);
-    void addSeams(const std::vector<std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>>>& seamTriangleUvs);
+    void addSeams(const std::vector<SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>>>& seamTriangleUvs);
     void pack();
+    void setThreadCount(size_t threadCount);
+    void setPreviousState(const PackedState& state);
     const std::vector<Layout>& packedLayouts();
     double packedTextureSize();
+    const PackedState& packedState();
+    bool isIncrementallyPacked();
+    const std::vector<Rectangle>& dirtyRects();
 
 private:
     std::vector<Part> m_partTriangleUvs;
     std::vector<Layout> m_packedLayouts;
-    std::vector<std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>>> m_seams;
+    std::vector<SpatialHashMap<std::array<PositionKey, 3>, std::array<Vector2, 3>>> m_seams;
     double m_packedTextureSize = 0.0;
+    std::unique_ptr<ThreadBudget> m_threadBudget;
+    std::unique_ptr<PackedState> m_previousState;
+    PackedState m_packedState;
+    bool m_isIncrementallyPacked = false;
+    std::vector<Rectangle> m_dirtyRects;
+    double m_paddingSize = 0.005;
+    double m_minimalOccupancyRatio = 0.75;
 
     void resolveSeamUvs();
+    bool packIncrementally(std::vector<std::tuple<float, float, float, float, bool>>* packedResult);
+    bool findFreeRect(double width, double height, const std::vector<Rectangle>& occupiedRects,
+        const PackedChart* previousChart, Rectangle* rect, bool* flipped) const;
+    void collectDirtyRects();
 };
 
 }
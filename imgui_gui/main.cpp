@@ -11,27 +11,12 @@
 #include "dust3d/base/ds3_file.h"
 #include <dust3d/base/snapshot.h>
 #include <dust3d/base/snapshot_xml.cc>
-#include <fstream>
 
 std::vector<sf::Texture> textures;
 void test()
 {
-    //QFile file(path);
-    //file.open(QFile::ReadOnly);
-    //QByteArray fileData = file.readAll();
     std::string filepath = TEST_DS3_FILE;
-    std::ifstream file(filepath, std::ios::in | std::ios::binary);
-    if (!file.is_open())
-        return ;
-
-    // Read contents
-    std::string fileData { std::istreambuf_iterator<char>(file),
-        std::istreambuf_iterator<char>() };
-
-    // Close the file
-    file.close();
-
-    dust3d::Ds3FileReader ds3Reader((const std::uint8_t*)fileData.data(), fileData.size());
+    dust3d::Ds3FileReader ds3Reader(filepath);
     for (int i = 0; i < (int)ds3Reader.items().size(); ++i) {
         const dust3d::Ds3ReaderItem& item = ds3Reader.items()[i];
         std::cout << "[" << i << "]item.name:" << item.name << "item.type:" << item.type << std::endl;
@@ -41,10 +26,9 @@ void test()
                 std::string imageIdString = dust3d::String::split(filename, '.')[0];
                 dust3d::Uuid imageId = dust3d::Uuid(imageIdString);
                 if (!imageId.isNull()) {
-                    std::vector<std::uint8_t> data;
-                    ds3Reader.loadItem(item.name, &data);
+                    dust3d::Ds3ReaderItemView data = ds3Reader.itemView(item.name);
                     sf::Texture texture;
-                    texture.loadFromMemory(data.data(), (int)data.size()); 
+                    texture.loadFromMemory(data.data, data.size);
                     textures.push_back(texture);
                     //QImage image = QImage::fromData(data.data(), (int)data.size(), "PNG");
                     //(void)ImageForever::add(&image, imageId);
@@ -56,17 +40,16 @@ void test()
     for (int i = 0; i < (int)ds3Reader.items().size(); ++i) {
         const dust3d::Ds3ReaderItem& item = ds3Reader.items()[i];
         if (item.type == "model") {
-            std::vector<std::uint8_t> data;
-            ds3Reader.loadItem(item.name, &data);
+            dust3d::Ds3ReaderItemView view = ds3Reader.itemView(item.name);
+            std::vector<char> data(view.data, view.data + view.size);
             data.push_back('\0');
             dust3d::Snapshot snapshot;
-            loadSnapshotFromXmlString(&snapshot, (char*)data.data());
+            loadSnapshotFromXmlString(&snapshot, data.data());
             //m_document->fromSnapshot(snapshot);
             //m_document->saveSnapshot();
         } else if (item.type == "asset") {
             if (item.name == "canvas.png") {
-                std::vector<std::uint8_t> data;
-                ds3Reader.loadItem(item.name, &data);
+                dust3d::Ds3ReaderItemView data = ds3Reader.itemView(item.name);
                 //m_document->updateTurnaround(QImage::fromData(data.data(), (int)data.size(), "PNG"));
             }
         }